@@ -0,0 +1,207 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+
+#define ARB_CHUNK 32
+
+// an emulator behind a plain file standing in for the bus device node, so
+// that flock() works on it as on /dev/i2c-N
+typedef struct {
+    ssd1306_emu_t *emu;
+    int probe_fd; // a second open file of the node to test the bus lock with
+    unsigned int ntx;
+    size_t max_len;
+    unsigned int unlocked; // transactions sent without the bus lock held
+} arb_bus_t;
+
+static int arb_bus_open(ssd1306_i2c_t *oled, void *ctx, const char *dev)
+{
+    (void)ctx;
+    oled->fd = open(dev, O_RDWR | O_CREAT, 0600);
+    return (oled->fd < 0) ? -1 : 0;
+}
+
+static void arb_bus_close(ssd1306_i2c_t *oled, void *ctx)
+{
+    (void)ctx;
+    if (oled->fd >= 0)
+        close(oled->fd);
+    oled->fd = -1;
+}
+
+static int arb_bus_write(ssd1306_i2c_t *oled, void *ctx, const uint8_t *buf, size_t len)
+{
+    (void)oled;
+    arb_bus_t *ab = (arb_bus_t *)ctx;
+    ab->ntx++;
+    if (len > ab->max_len)
+        ab->max_len = len;
+    if (flock(ab->probe_fd, LOCK_EX | LOCK_NB) == 0) {
+        flock(ab->probe_fd, LOCK_UN);
+        ab->unlocked++;
+    } else if (errno != EWOULDBLOCK) {
+        ab->unlocked++;
+    }
+    return ssd1306_emu_write(ab->emu, buf, len);
+}
+
+static uint32_t arb_bus_caps(const ssd1306_i2c_t *oled, void *ctx)
+{
+    (void)oled;
+    (void)ctx;
+    return SSD1306_I2C_TRANSPORT_CAP_FD;
+}
+
+static const ssd1306_i2c_transport_t arb_transport = {
+    .name = "arbitration test",
+    .open = arb_bus_open,
+    .write_cmds = arb_bus_write,
+    .write_data = arb_bus_write,
+    .close = arb_bus_close,
+    .capabilities = arb_bus_caps
+};
+
+static bool arb_file_exists(const char *dir, const char *name)
+{
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    return access(path, F_OK) == 0;
+}
+
+// checks that with arbitration every transaction goes out with the bus
+// locked in slices of at most chunk_bytes, that the stats count the slices,
+// that a bad configuration keeps the arbitration in place and that without
+// it a frame goes out whole
+static int run_arbitration(void)
+{
+    int rc = 0;
+    char dir[] = "/tmp/ssd1306-arb-XXXXXX";
+    char node[sizeof(dir) + 16] = { 0 };
+    arb_bus_t ab = { 0 };
+    ssd1306_i2c_t *oled = NULL;
+    ssd1306_framebuffer_t *fbp = NULL;
+    ab.probe_fd = -1;
+    do {
+        if (!mkdtemp(dir)) {
+            rc = -1;
+            break;
+        }
+        snprintf(node, sizeof(node), "%s/i2c-emu", dir);
+        ab.emu = ssd1306_emu_create();
+        if (!ab.emu) {
+            rc = -1;
+            break;
+        }
+        oled = ssd1306_i2c_open_transport(&arb_transport, &ab, node, 0, 128, 64, NULL);
+        ab.probe_fd = open(node, O_RDWR);
+        if (!oled || ab.probe_fd < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_err_set_level(oled->err, SSD1306_LOGLEVEL_WARN);
+        fbp = ssd1306_i2c_framebuffer_create(oled);
+        if (!fbp || ssd1306_i2c_display_initialize(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_arbitration_stats_t st = { 0 };
+        ssd1306_i2c_arbitration_t cfg = { 0 };
+        cfg.chunk_bytes = ARB_CHUNK;
+        cfg.lock_dir = dir;
+        if (ssd1306_i2c_arbitration_get_stats(oled, &st) == 0 ||
+            ssd1306_i2c_arbitration_enable(oled, &cfg) < 0 ||
+            !arb_file_exists(dir, "i2c-emu.prio") || !arb_file_exists(dir, "i2c-emu-3c.lock")) {
+            fprintf(stderr, "ERROR: arbitration: cannot enable it in %s\n", dir);
+            rc = -1;
+            break;
+        }
+        ab.ntx = 0;
+        ab.max_len = 0;
+        ab.unlocked = 0;
+        draw_frame(fbp, 0);
+        ssd1306_i2c_shadow_invalidate(oled);
+        if (ssd1306_i2c_display_update(oled, fbp) < 0 ||
+            ssd1306_i2c_arbitration_get_stats(oled, &st) < 0) {
+            rc = -1;
+            break;
+        }
+        // every transaction of a slice goes out under the same lock
+        const unsigned int data_slices = (fbp->len + ARB_CHUNK - 2) / (ARB_CHUNK - 1);
+        if (!ssd1306_emu_matches(ab.emu, fbp) || ab.unlocked != 0 || ab.max_len > ARB_CHUNK ||
+            st.locks < data_slices || st.locks > ab.ntx || st.hold_ns == 0 ||
+            st.hold_max_ns > st.hold_ns || st.wait_max_ns > st.wait_ns) {
+            fprintf(stderr, "ERROR: arbitration: %u transactions of up to %zu bytes, %u unlocked,"
+                    " in %" PRIu64 " slices\n", ab.ntx, ab.max_len, ab.unlocked, st.locks);
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_arbitration_stats_t before = st;
+        ssd1306_i2c_arbitration_t bad = cfg;
+        bad.chunk_bytes = 1;
+        ssd1306_err_set_log_callback(oled->err, quiet_log, NULL);
+        int brc = ssd1306_i2c_arbitration_enable(oled, &bad);
+        ssd1306_err_set_log_callback(oled->err, NULL, NULL);
+        ab.ntx = 0;
+        ab.max_len = 0;
+        draw_frame(fbp, 1);
+        if (brc == 0 || ssd1306_i2c_display_update(oled, fbp) < 0 ||
+            ssd1306_i2c_arbitration_get_stats(oled, &st) < 0 ||
+            st.locks <= before.locks || ab.unlocked != 0 || ab.max_len > ARB_CHUNK ||
+            !ssd1306_emu_matches(ab.emu, fbp)) {
+            fprintf(stderr, "ERROR: arbitration: lost after a refused configuration\n");
+            rc = -1;
+            break;
+        }
+        ab.ntx = 0;
+        ab.max_len = 0;
+        ab.unlocked = 0;
+        draw_frame(fbp, 2);
+        ssd1306_i2c_shadow_invalidate(oled);
+        if (ssd1306_i2c_arbitration_enable(oled, NULL) < 0 ||
+            ssd1306_i2c_arbitration_get_stats(oled, &st) == 0 ||
+            ssd1306_i2c_display_update(oled, fbp) < 0 ||
+            ab.max_len != fbp->len + 1 || ab.unlocked != ab.ntx ||
+            !ssd1306_emu_matches(ab.emu, fbp)) {
+            fprintf(stderr, "ERROR: arbitration: frame of %zu bytes without it\n", ab.max_len);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: %ux%u %-26s %8s\n", 128, 64, "bus arbitration", "ok");
+    } while (0);
+    if (fbp)
+        ssd1306_framebuffer_destroy(fbp);
+    if (oled)
+        ssd1306_i2c_close(oled);
+    if (ab.probe_fd >= 0)
+        close(ab.probe_fd);
+    if (ab.emu)
+        ssd1306_emu_destroy(ab.emu);
+    if (node[0]) {
+        char path[512];
+        unlink(node);
+        snprintf(path, sizeof(path), "%s/i2c-emu.prio", dir);
+        unlink(path);
+        snprintf(path, sizeof(path), "%s/i2c-emu-3c.lock", dir);
+        unlink(path);
+        rmdir(dir);
+    }
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_arbitration() < 0) {
+        fprintf(stderr, "ERROR: bus arbitration failed\n");
+        rc = -1;
+    }
+    return rc;
+}
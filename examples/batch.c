@@ -0,0 +1,125 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+typedef struct {
+    emu_fixture_t fx;
+    unsigned int ntx;
+    unsigned int bad_tx; // transactions not made of one command control byte
+    size_t max_len;
+    uint64_t first_cmds; // commands decoded from the first transaction
+    bool first_on; // display on after the first transaction
+    bool first_stream; // the first transaction had a single 0x00 control byte
+} batch_bus_t;
+
+// notes the shape of each transaction before the emulator decodes it
+static int batch_bus(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata)
+{
+    (void)addr;
+    batch_bus_t *bb = (batch_bus_t *)cbdata;
+    bb->ntx++;
+    if (len < 2 || buf[0] != 0x00)
+        bb->bad_tx++;
+    if (len > bb->max_len)
+        bb->max_len = len;
+    int rc = ssd1306_emu_write(bb->fx.emu, buf, len);
+    if (bb->ntx == 1) {
+        bb->first_cmds = bb->fx.emu->stats.commands;
+        bb->first_on = bb->fx.emu->display_on;
+        bb->first_stream = (buf[0] == 0x00 && bb->fx.emu->stats.control_bytes == 1);
+    }
+    return rc;
+}
+
+// checks that the initialization sequence and a command batch each go out
+// as a single 0x00 prefixed control stream, and that a batch larger than
+// SSD1306_I2C_CMD_BATCH_MAX is split into full streams
+static int run_batch(uint8_t width, uint8_t height)
+{
+    int rc = 0;
+    batch_bus_t bb = { 0 };
+    emu_fixture_t *fx = &(bb.fx);
+    fx->tcb.cb = batch_bus;
+    fx->tcb.cbdata = &bb;
+    do {
+        if (emu_fixture_open(fx, width, height, NULL, EMU_FIXTURE_INIT) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx->emu;
+        ssd1306_i2c_t *oled = fx->oled;
+        // the screen is cleared after the sequence
+        if (!bb.first_stream || bb.first_cmds != 17 || !bb.first_on || emu->mux_ratio != height - 1 ||
+            emu->stats.unknown_cmds != 0) {
+            fprintf(stderr, "ERROR: batch: first of %u transactions held %" PRIu64
+                    " of the initialization commands\n", bb.ntx, bb.first_cmds);
+            rc = -1;
+            break;
+        }
+        uint8_t contrast = 0x42, offset = 3;
+        bb.ntx = 0;
+        bb.bad_tx = 0;
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_cmd_batch_begin(oled) < 0 ||
+            ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &contrast, 1) < 0 ||
+            ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_DISP_INVERTED, 0, 0) < 0 ||
+            ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_DISP_OFFSET, &offset, 1) < 0 ||
+            bb.ntx != 0 || ssd1306_i2c_cmd_batch_commit(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        if (bb.ntx != 1 || bb.bad_tx != 0 || emu->stats.bytes != 6 ||
+            emu->contrast != contrast || !emu->inverted || emu->disp_offset != offset) {
+            fprintf(stderr, "ERROR: batch: %u transactions of %" PRIu64 " bytes\n",
+                    bb.ntx, emu->stats.bytes);
+            rc = -1;
+            break;
+        }
+        // with the cache off every contrast command is sent
+        const unsigned int ncmds = 3 * SSD1306_I2C_CMD_BATCH_MAX / 2;
+        bb.ntx = 0;
+        bb.max_len = 0;
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_regcache_enable(oled, false) < 0 ||
+            ssd1306_i2c_cmd_batch_begin(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        for (unsigned int idx = 0; idx < ncmds && rc == 0; ++idx) {
+            contrast = (uint8_t)idx;
+            rc = ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &contrast, 1);
+        }
+        if (rc < 0 || ssd1306_i2c_cmd_batch_commit(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        // 31 two byte commands fill a batch
+        const unsigned int per_batch = (SSD1306_I2C_CMD_BATCH_MAX - 1) / 2;
+        if (bb.ntx != (ncmds + per_batch - 1) / per_batch || bb.bad_tx != 0 ||
+            bb.max_len != 1 + 2 * per_batch || emu->stats.commands != ncmds ||
+            emu->contrast != contrast) {
+            fprintf(stderr, "ERROR: batch: %u commands in %u transactions of up to %zu bytes\n",
+                    ncmds, bb.ntx, bb.max_len);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: %ux%u %-26s %8s\n", width, height, "command batches", "ok");
+    } while (0);
+    emu_fixture_close(fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_batch(128, 64) < 0 || run_batch(128, 32) < 0) {
+        fprintf(stderr, "ERROR: command batches failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,97 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+#include <poll.h>
+
+// true if fd becomes readable within timeout_ms
+static bool fd_readable(int fd, int timeout_ms)
+{
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    return (poll(&pfd, 1, timeout_ms) == 1 && (pfd.revents & POLLIN));
+}
+
+// presents more frames than the completion ring holds without draining, then
+// checks that the oldest were counted as lost, that the rest come out in
+// order over several drains and that the eventfd is readable until then
+static int run_completions(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    const unsigned int nframes = SSD1306_I2C_ASYNC_COMPLETIONS + 36;
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0 ||
+            ssd1306_i2c_async_start(fx.oled) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        int efd = ssd1306_i2c_async_eventfd(oled);
+        if (efd < 0 || fd_readable(efd, 0)) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_async_stats_t st = { 0 };
+        for (unsigned int frame = 0; frame < nframes && rc == 0; ++frame) {
+            draw_frame(fbp, frame);
+            rc = ssd1306_i2c_async_present(oled, fbp);
+            for (int tries = 0; rc == 0 && tries < 1000; ++tries) {
+                if (ssd1306_i2c_async_get_stats(oled, &st) < 0)
+                    rc = -1;
+                else if (st.flushed + st.dropped >= st.submitted)
+                    break;
+                usleep(100);
+            }
+        }
+        // flushed is counted before the completion is recorded, lost with it
+        for (int tries = 0; rc == 0 && tries < 1000; ++tries) {
+            if (ssd1306_i2c_async_get_stats(oled, &st) < 0)
+                rc = -1;
+            else if (st.lost >= nframes - SSD1306_I2C_ASYNC_COMPLETIONS)
+                break;
+            usleep(100);
+        }
+        if (rc < 0)
+            break;
+        ssd1306_i2c_present_info_t infos[SSD1306_I2C_ASYNC_COMPLETIONS];
+        size_t first = 0, rest = 0;
+        bool readable = fd_readable(efd, 1000);
+        if (readable)
+            first = ssd1306_i2c_async_drain(oled, infos, 16);
+        // still readable for the completions left
+        bool more = fd_readable(efd, 0);
+        if (more)
+            rest = ssd1306_i2c_async_drain(oled, &infos[first],
+                        SSD1306_I2C_ASYNC_COMPLETIONS - first);
+        ssd1306_i2c_async_get_stats(oled, &st);
+        bool ordered = (first + rest == SSD1306_I2C_ASYNC_COMPLETIONS);
+        for (size_t idx = 0; ordered && idx < first + rest; ++idx)
+            ordered = (infos[idx].seq == nframes - SSD1306_I2C_ASYNC_COMPLETIONS + idx + 1);
+        if (!readable || !more || first != 16 || !ordered || fd_readable(efd, 0) ||
+            st.lost != nframes - SSD1306_I2C_ASYNC_COMPLETIONS ||
+            ssd1306_i2c_async_drain(oled, infos, 1) != 0) {
+            fprintf(stderr, "ERROR: completions: drained %zu and %zu, %" PRIu64 " lost\n",
+                    first, rest, st.lost);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x64 %-26s %8s\n", "eventfd completions", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_completions() < 0) {
+        fprintf(stderr, "ERROR: completions failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,109 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// logs lines to the start line console and checks that each new line costs
+// about one page instead of a full frame
+static int run_console(uint8_t width, uint8_t height)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    ssd1306_i2c_console_t *con = NULL;
+    do {
+        if (emu_fixture_open(&fx, width, height, NULL, EMU_FIXTURE_INIT) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        con = ssd1306_i2c_console_create(fx.oled, 32);
+        if (!con) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_reset_stats(emu);
+        char line[32];
+        for (unsigned int idx = 0; idx < EMU_TEST_FRAMES; ++idx) {
+            snprintf(line, sizeof(line), "%u: log line\n", idx);
+            if (ssd1306_i2c_console_write(con, line, 0) < 0) {
+                rc = -1;
+                break;
+            }
+        }
+        if (rc < 0)
+            break;
+        double per_line = (double)emu->stats.bytes / EMU_TEST_FRAMES;
+        fprintf(stderr, "INFO: %ux%u %-26s %8.1f bytes/line\n", width, height,
+                "start line console", per_line);
+        // a line is one page with its window and a start line command
+        if (per_line > width + 8 + 2) {
+            fprintf(stderr, "ERROR: console sent %.1f bytes per line\n", per_line);
+            rc = -1;
+            break;
+        }
+        if (emu->start_line % 8 != 0 || ssd1306_i2c_console_scrollback(con) != 32) {
+            fprintf(stderr, "ERROR: console start line %u scrollback %zu\n",
+                    emu->start_line, ssd1306_i2c_console_scrollback(con));
+            rc = -1;
+            break;
+        }
+    } while (0);
+    if (con)
+        ssd1306_i2c_console_destroy(con);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+// a ticker scrolls the rows the console pages through, so each refuses to
+// start while the other is in use
+static int run_console_refusals(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    ssd1306_i2c_console_t *con = NULL;
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_err_set_log_callback(oled->err, quiet_log, NULL);
+        ssd1306_i2c_ticker_t tk = { 0 };
+        if (ssd1306_i2c_ticker_start(oled, &tk, fx.fbp) < 0) {
+            rc = -1;
+            break;
+        }
+        con = ssd1306_i2c_console_create(oled, 0);
+        if (con || ssd1306_i2c_ticker_stop(oled) < 0) {
+            fprintf(stderr, "ERROR: console: opened while the ticker is running\n");
+            rc = -1;
+            break;
+        }
+        con = ssd1306_i2c_console_create(oled, 0);
+        if (!con || ssd1306_i2c_ticker_start(oled, &tk, fx.fbp) == 0 || oled->ticker_active) {
+            fprintf(stderr, "ERROR: console: ticker started while a console is open\n");
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x64 %-26s %8s\n", "console refusals", "ok");
+    } while (0);
+    if (con)
+        ssd1306_i2c_console_destroy(con);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_console(128, 64) < 0 || run_console(128, 32) < 0 ||
+        run_console_refusals() < 0) {
+        fprintf(stderr, "ERROR: console failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,83 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// runs a contrast fade and an invert blink from a timer loop, then a fade
+// with frames flushed meanwhile, and checks where they end up and that each
+// step costs a few bytes
+static int run_effects(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_fx_fade(oled, 0xFF, 0x10, 100, SSD1306_I2C_FX_EASE_IN_OUT) < 0 ||
+            ssd1306_i2c_fx_blink(oled, SSD1306_I2C_FX_INVERT, 0x5, 3, 10, 2) < 0) {
+            rc = -1;
+            break;
+        }
+        uint32_t next_ms = 0;
+        bool seen_inverted = false;
+        while ((rc = ssd1306_i2c_fx_run(oled, &next_ms)) > 0) {
+            seen_inverted |= emu->inverted;
+            usleep(next_ms * 1000);
+        }
+        if (rc < 0)
+            break;
+        ssd1306_i2c_fx_stats_t st;
+        ssd1306_i2c_fx_get_stats(oled, &st);
+        fprintf(stderr, "INFO: 128x64 %-26s %8.1f bytes/step %6" PRIu64 " steps\n",
+                "contrast fade and blink", (double)emu->stats.bytes / (st.steps ? st.steps : 1),
+                st.steps);
+        if (emu->contrast != 0x10 || emu->inverted || !seen_inverted ||
+            emu->stats.bytes > st.steps * 4) {
+            fprintf(stderr, "ERROR: effects: contrast 0x%02x inverted %d after %" PRIu64
+                    " bytes\n", emu->contrast, emu->inverted, emu->stats.bytes);
+            rc = -1;
+            break;
+        }
+        // steps ride along with the frames
+        if (ssd1306_i2c_fx_fade(oled, 0x10, 0xFF, 50, SSD1306_I2C_FX_LINEAR) < 0) {
+            rc = -1;
+            break;
+        }
+        for (unsigned int frame = 0; frame < 10 && rc == 0; ++frame) {
+            usleep(8000);
+            draw_frame(fbp, frame);
+            rc = ssd1306_i2c_display_update(oled, fbp);
+        }
+        if (rc == 0)
+            rc = (ssd1306_i2c_fx_run(oled, NULL) < 0) ? -1 : 0;
+        ssd1306_i2c_fx_get_stats(oled, &st);
+        if (rc < 0 || st.merged == 0 || emu->contrast != 0xFF || !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: effects: %" PRIu64 " steps merged, contrast 0x%02x\n",
+                    st.merged, emu->contrast);
+            rc = -1;
+            break;
+        }
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_effects() < 0) {
+        fprintf(stderr, "ERROR: effects failed\n");
+        rc = -1;
+    }
+    return rc;
+}
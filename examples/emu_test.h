@@ -0,0 +1,123 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#ifndef __SSD1306_EMU_TEST_H__
+#define __SSD1306_EMU_TEST_H__
+
+#include <ssd1306_emulator.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// helpers shared by the tests that run against the software emulator
+
+// frames or lines each test runs through
+#define EMU_TEST_FRAMES 256
+
+// swallows the errors that checks of refused calls expect
+static inline void quiet_log(ssd1306_loglevel_t level, const char *msg, void *cbdata)
+{
+    (void)level;
+    (void)msg;
+    (void)cbdata;
+}
+
+static inline void draw_frame(ssd1306_framebuffer_t *fbp, unsigned int frame)
+{
+    // a sweeping line and a bouncing circle touch only part of the screen
+    uint8_t x = (uint8_t)(frame % fbp->width);
+    int16_t cy = (int16_t)(frame % fbp->height);
+    ssd1306_framebuffer_clear(fbp);
+    ssd1306_framebuffer_draw_line(fbp, x, 0, x, fbp->height - 1, true);
+    ssd1306_framebuffer_draw_circle(fbp, 32, cy, 6);
+}
+
+// an SSD1306 driven like an SH1106 whose panel starts at RAM column 0, since
+// the emulator has 128 columns. it also gets the SH1106 DC-DC command
+static inline const ssd1306_i2c_profile_t *page_profile(void)
+{
+    static const ssd1306_i2c_profile_t profile = {
+        .name = "page addressing",
+        .ram_columns = 128,
+        .column_offset = 0,
+        .page_addressing_only = true,
+        .hw_scroll = false,
+        .clock_divfreq = 0x80,
+        .precharge = 0xF1,
+        .vcomh = 0x30,
+        .charge_pump = true,
+        .dcdc = 0x8B
+    };
+    return &profile;
+}
+
+// a display on a fresh emulator and what the tests create with it
+typedef struct {
+    ssd1306_emu_t *emu;
+    ssd1306_i2c_t *oled;
+    ssd1306_framebuffer_t *fbp; // destroyed by emu_fixture_close() if set
+    // set cb to put a bus callback between the library and the emulator.
+    // cbdata defaults to the emulator
+    ssd1306_i2c_transport_cb_t tcb;
+} emu_fixture_t;
+
+#define EMU_FIXTURE_INIT 0x1 // run ssd1306_i2c_display_initialize()
+#define EMU_FIXTURE_FB 0x2 // create fbp with ssd1306_i2c_framebuffer_create()
+
+// creates the emulator and opens a display on it with warnings and errors
+// logged. profile, if not NULL, is set before anything else is sent.
+// returns 0 on success and -1 on failure. call emu_fixture_close() either way
+static inline int emu_fixture_open(emu_fixture_t *fx, uint8_t width, uint8_t height,
+        const ssd1306_i2c_profile_t *profile, unsigned int flags)
+{
+    fx->emu = ssd1306_emu_create();
+    if (!fx->emu)
+        return -1;
+    if (fx->tcb.cb) {
+        if (!fx->tcb.cbdata)
+            fx->tcb.cbdata = fx->emu;
+        fx->oled = ssd1306_i2c_open_transport(&ssd1306_i2c_transport_callback, &(fx->tcb),
+                NULL, 0, width, height, NULL);
+    } else {
+        fx->oled = ssd1306_i2c_open_transport(&ssd1306_i2c_transport_emulator, fx->emu,
+                NULL, 0, width, height, NULL);
+    }
+    if (!fx->oled)
+        return -1;
+    ssd1306_err_set_level(fx->oled->err, SSD1306_LOGLEVEL_WARN);
+    if (profile && ssd1306_i2c_set_profile(fx->oled, profile) < 0)
+        return -1;
+    if (flags & EMU_FIXTURE_INIT) {
+        if (ssd1306_i2c_display_initialize(fx->oled) < 0)
+            return -1;
+        if (fx->emu->stats.unknown_cmds != 0) {
+            fprintf(stderr, "ERROR: %" PRIu64 " commands of the %s initialization not understood\n",
+                    fx->emu->stats.unknown_cmds, fx->oled->profile->name);
+            return -1;
+        }
+    }
+    if (flags & EMU_FIXTURE_FB) {
+        fx->fbp = ssd1306_i2c_framebuffer_create(fx->oled);
+        if (!fx->fbp)
+            return -1;
+    }
+    return 0;
+}
+
+static inline void emu_fixture_close(emu_fixture_t *fx)
+{
+    if (fx->fbp)
+        ssd1306_framebuffer_destroy(fx->fbp);
+    if (fx->oled)
+        ssd1306_i2c_close(fx->oled);
+    if (fx->emu)
+        ssd1306_emu_destroy(fx->emu);
+    fx->fbp = NULL;
+    fx->oled = NULL;
+    fx->emu = NULL;
+}
+
+#endif /* __SSD1306_EMU_TEST_H__ */
@@ -0,0 +1,107 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// runs the same animation through each update strategy against the software
+// emulator, checks that the emulated GDDRAM matches the framebuffer after
+// every frame and prints frames per second and bus bytes per frame.
+
+#define BENCH_FRAMES EMU_TEST_FRAMES
+
+typedef struct {
+    const char *name;
+    bool shadow;
+    size_t chunk_size;
+    bool prefixed; // use ssd1306_i2c_framebuffer_create()
+    bool page_addressing; // use page_profile() instead of the default
+} bench_strategy_t;
+
+static const bench_strategy_t strategies[] = {
+    { "full update", false, 0, false, false },
+    { "zero-copy framebuffer", false, 0, true, false },
+    { "shadow partial update", true, 0, true, false },
+    { "SMBus sized chunks", false, SSD1306_I2C_SMBUS_BLOCK_MAX, true, false },
+    { "shadow with SMBus chunks", true, SSD1306_I2C_SMBUS_BLOCK_MAX, true, false },
+    { "page addressing", false, 0, true, true },
+    { "page addressing with shadow", true, 0, true, true }
+};
+
+static int run_strategy(const bench_strategy_t *strat, uint8_t width, uint8_t height)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, width, height,
+                    strat->page_addressing ? page_profile() : NULL, EMU_FIXTURE_INIT) < 0 ||
+            ssd1306_i2c_set_chunk_size(fx.oled, strat->chunk_size) < 0 ||
+            ssd1306_i2c_shadow_enable(fx.oled, strat->shadow) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        // the SH1106 DC-DC command takes one argument
+        uint8_t dcdc = 0x8A;
+        if (strat->page_addressing &&
+            (ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SH1106_DCDC, &dcdc, 1) < 0 ||
+             emu->dcdc != dcdc || emu->stats.unknown_cmds != 0)) {
+            fprintf(stderr, "ERROR: %s: DC-DC is 0x%02x\n", strat->name, emu->dcdc);
+            rc = -1;
+            break;
+        }
+        if (strat->prefixed)
+            fx.fbp = ssd1306_i2c_framebuffer_create(oled);
+        else
+            fx.fbp = ssd1306_framebuffer_create(oled->width, oled->height, oled->err);
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        if (!fbp) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_reset_stats(emu);
+        struct timespec ts0, ts1;
+        clock_gettime(CLOCK_MONOTONIC, &ts0);
+        for (unsigned int frame = 0; frame < BENCH_FRAMES; ++frame) {
+            draw_frame(fbp, frame);
+            if (ssd1306_i2c_display_update(oled, fbp) < 0) {
+                rc = -1;
+                break;
+            }
+            if (!ssd1306_emu_matches(emu, fbp)) {
+                fprintf(stderr, "ERROR: %s: GDDRAM differs from framebuffer at frame %u\n",
+                        strat->name, frame);
+                rc = -1;
+                break;
+            }
+        }
+        clock_gettime(CLOCK_MONOTONIC, &ts1);
+        if (rc < 0)
+            break;
+        double secs = (double)(ts1.tv_sec - ts0.tv_sec) +
+                        (double)(ts1.tv_nsec - ts0.tv_nsec) / 1e9;
+        fprintf(stderr, "INFO: %ux%u %-26s %10.0f fps %8.1f bytes/frame %6.2f xfers/frame\n",
+                width, height, strat->name, (secs > 0) ? BENCH_FRAMES / secs : 0.0,
+                (double)emu->stats.bytes / BENCH_FRAMES,
+                (double)emu->stats.transactions / BENCH_FRAMES);
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    for (size_t idx = 0; idx < sizeof(strategies) / sizeof(strategies[0]); ++idx) {
+        if (run_strategy(&strategies[idx], 128, 64) < 0 ||
+            run_strategy(&strategies[idx], 128, 32) < 0) {
+            fprintf(stderr, "ERROR: strategy %s failed\n", strategies[idx].name);
+            rc = -1;
+        }
+    }
+    return rc;
+}
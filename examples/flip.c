@@ -0,0 +1,92 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// flips between the two GDDRAM halves of a 128x32 panel and checks that the
+// shown half holds each frame, then pans over a 64 row image
+static int run_flip(const ssd1306_i2c_profile_t *profile)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    ssd1306_framebuffer_t *tall = NULL;
+    do {
+        if (emu_fixture_open(&fx, 128, 32, profile, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0 ||
+            ssd1306_i2c_flip_enable(fx.oled, true) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        ssd1306_emu_reset_stats(emu);
+        for (unsigned int frame = 0; frame < EMU_TEST_FRAMES; ++frame) {
+            draw_frame(fbp, frame);
+            if (ssd1306_i2c_display_update(oled, fbp) < 0) {
+                rc = -1;
+                break;
+            }
+            uint8_t first = (uint8_t)(emu->start_line / 8);
+            bool same = (emu->start_line == oled->flip_front * 32);
+            for (uint8_t p = 0; p < 4 && same; ++p) {
+                same = (memcmp(emu->gddram[first + p], &(fbp->buffer[p * 128]), 128) == 0);
+            }
+            if (!same) {
+                fprintf(stderr, "ERROR: flip: shown half differs from framebuffer at frame %u\n",
+                        frame);
+                rc = -1;
+                break;
+            }
+        }
+        if (rc < 0)
+            break;
+        fprintf(stderr, "INFO: 128x32 %-26s %8.1f bytes/frame %6.2f xfers/frame\n",
+                profile ? "page flip page addressing" : "page flip",
+                (double)emu->stats.bytes / EMU_TEST_FRAMES,
+                (double)emu->stats.transactions / EMU_TEST_FRAMES);
+        tall = ssd1306_framebuffer_create(128, 64, oled->err);
+        if (!tall) {
+            rc = -1;
+            break;
+        }
+        for (uint8_t y = 0; y < 64; y += 8)
+            ssd1306_framebuffer_draw_line(tall, 0, y, 127, y, true);
+        if (ssd1306_i2c_flip_enable(oled, false) < 0 ||
+            ssd1306_i2c_pan_load(oled, tall) < 0 ||
+            memcmp(emu->gddram, tall->buffer, tall->len) != 0) {
+            fprintf(stderr, "ERROR: pan: GDDRAM differs from the 64 row image\n");
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_reset_stats(emu);
+        for (uint8_t row = 0; row < 64; ++row) {
+            if (ssd1306_i2c_pan_set(oled, row) < 0 || emu->start_line != row) {
+                fprintf(stderr, "ERROR: pan: start line %u for row %u\n", emu->start_line, row);
+                rc = -1;
+                break;
+            }
+        }
+        if (rc == 0 && emu->stats.bytes > 64 * 2) {
+            fprintf(stderr, "ERROR: pan: %" PRIu64 " bytes for 64 rows\n", emu->stats.bytes);
+            rc = -1;
+        }
+    } while (0);
+    if (tall)
+        ssd1306_framebuffer_destroy(tall);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_flip(NULL) < 0 || run_flip(page_profile()) < 0) {
+        fprintf(stderr, "ERROR: page flip failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,77 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// the console and preemptible flushes also own the start line and the
+// ticker scrolls the rows, so page flipping is refused while any of them is
+// in use and they are refused while flipping
+static int run_flip_refusals(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, 128, 32, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_err_set_log_callback(oled->err, quiet_log, NULL);
+        ssd1306_i2c_console_t *con = ssd1306_i2c_console_create(oled, 0);
+        bool refused = con && ssd1306_i2c_flip_enable(oled, true) < 0;
+        ssd1306_i2c_console_destroy(con);
+        if (refused && ssd1306_i2c_async_start(oled) == 0) {
+            refused = ssd1306_i2c_async_set_preemptible(oled, true) == 0 &&
+                        ssd1306_i2c_flip_enable(oled, true) < 0;
+            ssd1306_i2c_async_stop(oled);
+        }
+        ssd1306_i2c_ticker_t tk = { 0 };
+        if (refused) {
+            refused = ssd1306_i2c_ticker_start(oled, &tk, fx.fbp) == 0 &&
+                        ssd1306_i2c_flip_enable(oled, true) < 0 &&
+                        ssd1306_i2c_ticker_stop(oled) == 0;
+        }
+        if (!refused || oled->flip_enabled) {
+            fprintf(stderr, "ERROR: flip: enabled along with a console, a ticker or"
+                    " preemptible flushes\n");
+            rc = -1;
+            break;
+        }
+        if (ssd1306_i2c_flip_enable(oled, true) < 0) {
+            rc = -1;
+            break;
+        }
+        con = ssd1306_i2c_console_create(oled, 0);
+        refused = !con;
+        ssd1306_i2c_console_destroy(con);
+        if (refused && ssd1306_i2c_async_start(oled) == 0) {
+            refused = ssd1306_i2c_async_set_preemptible(oled, true) < 0;
+            ssd1306_i2c_async_stop(oled);
+        }
+        if (refused)
+            refused = ssd1306_i2c_ticker_start(oled, &tk, fx.fbp) < 0 && !oled->ticker_active;
+        if (!refused) {
+            fprintf(stderr, "ERROR: flip: a console, a ticker or preemptible flushes while"
+                    " flipping\n");
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x32 %-26s %8s\n", "page flip refusals", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_flip_refusals() < 0) {
+        fprintf(stderr, "ERROR: page flip refusals failed\n");
+        rc = -1;
+    }
+    return rc;
+}
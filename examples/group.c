@@ -0,0 +1,133 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+#define GROUP_NDISPLAYS 3
+
+// two 128x64 displays on one bus and a 128x32 display on another. checks
+// that a mirrored frame reaches both 128x64 displays with the same traffic
+// while the 128x32 display is left alone and reported, and that an update
+// gives every display its own framebuffer
+static int run_group(void)
+{
+    int rc = 0;
+    ssd1306_emu_t *emus[GROUP_NDISPLAYS] = { NULL };
+    ssd1306_framebuffer_t *fbps[GROUP_NDISPLAYS] = { NULL };
+    ssd1306_i2c_group_t *grp = NULL;
+    // catches the size mismatch that the mirror is expected to report. the
+    // group closes it
+    FILE *log = tmpfile();
+    do {
+        static const char *buses[GROUP_NDISPLAYS] = { "emu-0", "emu-0", "emu-1" };
+        static const uint8_t addrs[GROUP_NDISPLAYS] = { 0x3c, 0x3d, 0x3c };
+        static const uint8_t heights[GROUP_NDISPLAYS] = { 64, 64, 32 };
+        grp = log ? ssd1306_i2c_group_create(log) : NULL;
+        if (!grp) {
+            if (log)
+                fclose(log);
+            rc = -1;
+            break;
+        }
+        for (size_t idx = 0; idx < GROUP_NDISPLAYS && rc == 0; ++idx) {
+            emus[idx] = ssd1306_emu_create();
+            ssd1306_i2c_t *oled = emus[idx] ? ssd1306_i2c_group_add_transport(grp,
+                                    &ssd1306_i2c_transport_emulator, emus[idx],
+                                    buses[idx], addrs[idx], 128, heights[idx]) : NULL;
+            fbps[idx] = oled ? ssd1306_i2c_framebuffer_create(oled) : NULL;
+            if (!fbps[idx])
+                rc = -1;
+        }
+        if (rc < 0)
+            break;
+        if (ssd1306_i2c_group_size(grp) != GROUP_NDISPLAYS ||
+            ssd1306_i2c_group_get(grp, GROUP_NDISPLAYS) != NULL ||
+            ssd1306_i2c_group_add_transport(grp, &ssd1306_i2c_transport_emulator, emus[0],
+                buses[0], addrs[0], 128, 64) != NULL ||
+            ssd1306_i2c_group_size(grp) != GROUP_NDISPLAYS) {
+            fprintf(stderr, "ERROR: group: holds %zu displays\n", ssd1306_i2c_group_size(grp));
+            rc = -1;
+            break;
+        }
+        if (ssd1306_i2c_group_display_initialize(grp) < 0) {
+            rc = -1;
+            break;
+        }
+        for (size_t idx = 0; idx < GROUP_NDISPLAYS; ++idx) {
+            if (!emus[idx]->display_on || emus[idx]->mux_ratio != heights[idx] - 1)
+                rc = -1;
+            ssd1306_emu_reset_stats(emus[idx]);
+        }
+        if (rc < 0) {
+            fprintf(stderr, "ERROR: group: displays not initialized\n");
+            break;
+        }
+        ssd1306_framebuffer_t *fbp = fbps[0];
+        for (unsigned int frame = 0; frame < EMU_TEST_FRAMES && rc == 0; ++frame) {
+            draw_frame(fbp, frame);
+            if (ssd1306_i2c_group_mirror(grp, fbp) == 0 ||
+                !ssd1306_emu_matches(emus[0], fbp) || !ssd1306_emu_matches(emus[1], fbp)) {
+                fprintf(stderr, "ERROR: group: mirror of frame %u\n", frame);
+                rc = -1;
+            }
+        }
+        if (rc < 0)
+            break;
+        fflush(log);
+        char line[256];
+        bool reported = false;
+        rewind(log);
+        while (fgets(line, sizeof(line), log)) {
+            if (strstr(line, "is 128x32, the framebuffer is 128x64"))
+                reported = true;
+        }
+        if (emus[0]->stats.bytes != emus[1]->stats.bytes || emus[0]->stats.unknown_cmds != 0 ||
+            emus[2]->stats.bytes != 0 || !reported) {
+            fprintf(stderr, "ERROR: group: mirrors sent %" PRIu64 " and %" PRIu64
+                    " bytes and %" PRIu64 " to the smaller display\n", emus[0]->stats.bytes,
+                    emus[1]->stats.bytes, emus[2]->stats.bytes);
+            rc = -1;
+            break;
+        }
+        // NULL leaves the second display showing the last mirrored frame
+        ssd1306_framebuffer_t *mirrored = fbps[1];
+        memcpy(mirrored->buffer, fbp->buffer, fbp->len);
+        draw_frame(fbps[0], 7);
+        draw_frame(fbps[2], 11);
+        const ssd1306_framebuffer_t *updates[GROUP_NDISPLAYS] = { fbps[0], NULL, fbps[2] };
+        if (ssd1306_i2c_group_set_engine(grp, SSD1306_I2C_ENGINE_SERIAL) < 0 ||
+            ssd1306_i2c_group_update(grp, updates, 2) == 0 ||
+            ssd1306_i2c_group_update(grp, updates, GROUP_NDISPLAYS) < 0 ||
+            !ssd1306_emu_matches(emus[0], fbps[0]) || !ssd1306_emu_matches(emus[1], mirrored) ||
+            !ssd1306_emu_matches(emus[2], fbps[2])) {
+            fprintf(stderr, "ERROR: group: update with a framebuffer per display\n");
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: %ux%u %-26s %8s\n", 128, 64, "group mirror", "ok");
+    } while (0);
+    for (size_t idx = 0; idx < GROUP_NDISPLAYS; ++idx) {
+        if (fbps[idx])
+            ssd1306_framebuffer_destroy(fbps[idx]);
+    }
+    ssd1306_i2c_group_destroy(grp);
+    for (size_t idx = 0; idx < GROUP_NDISPLAYS; ++idx) {
+        if (emus[idx])
+            ssd1306_emu_destroy(emus[idx]);
+    }
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_group() < 0) {
+        fprintf(stderr, "ERROR: display groups failed\n");
+        rc = -1;
+    }
+    return rc;
+}
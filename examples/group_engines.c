@@ -0,0 +1,157 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+#include <pthread.h>
+
+#define ENGINE_NBUSES 2
+#define ENGINE_NDISPLAYS 4
+#define ENGINE_UPDATES 64
+#define ENGINE_TX_MAX 64
+
+// the transactions seen on one bus during an update
+typedef struct {
+    uint8_t addrs[ENGINE_TX_MAX];
+    size_t ntx;
+    unsigned int switches; // changes of address from one transaction to the next
+    pthread_t thread; // thread of the last transaction
+} engine_bus_t;
+
+typedef struct {
+    ssd1306_emu_t *emu;
+    engine_bus_t *bus;
+    ssd1306_i2c_transport_cb_t tcb;
+} engine_display_t;
+
+static int engine_bus(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata)
+{
+    engine_display_t *ed = (engine_display_t *)cbdata;
+    engine_bus_t *bus = ed->bus;
+    if (bus->ntx > 0 && bus->addrs[(bus->ntx - 1) % ENGINE_TX_MAX] != addr)
+        bus->switches++;
+    bus->addrs[bus->ntx++ % ENGINE_TX_MAX] = addr;
+    bus->thread = pthread_self();
+    return ssd1306_emu_write(ed->emu, buf, len);
+}
+
+// four displays on two buses. checks that the displays of a bus are updated
+// one after the other starting with the one whose turn it is, and that the
+// threaded engine updates the second bus on a thread of its own
+static int run_engine(ssd1306_i2c_engine_t engine, const char *name)
+{
+    int rc = 0;
+    static const uint8_t addrs[ENGINE_NDISPLAYS] = { 0x3c, 0x3d, 0x3c, 0x3d };
+    static const char *names[ENGINE_NBUSES] = { "emu-0", "emu-1" };
+    static const char *engines[] = { "serial", "threads", "io_uring" };
+    engine_bus_t buses[ENGINE_NBUSES];
+    engine_display_t displays[ENGINE_NDISPLAYS];
+    ssd1306_framebuffer_t *fbps[ENGINE_NDISPLAYS] = { NULL };
+    ssd1306_i2c_group_t *grp = NULL;
+    memset(buses, 0, sizeof(buses));
+    memset(displays, 0, sizeof(displays));
+    do {
+        grp = ssd1306_i2c_group_create(NULL);
+        if (!grp) {
+            rc = -1;
+            break;
+        }
+        for (size_t idx = 0; idx < ENGINE_NDISPLAYS && rc == 0; ++idx) {
+            engine_display_t *ed = &(displays[idx]);
+            ed->bus = &(buses[idx / 2]);
+            ed->tcb.cb = engine_bus;
+            ed->tcb.cbdata = ed;
+            ed->emu = ssd1306_emu_create();
+            ssd1306_i2c_t *oled = ed->emu ? ssd1306_i2c_group_add_transport(grp,
+                                    &ssd1306_i2c_transport_callback, &(ed->tcb),
+                                    names[idx / 2], addrs[idx], 128, 64) : NULL;
+            if (oled)
+                ssd1306_err_set_level(oled->err, SSD1306_LOGLEVEL_WARN);
+            fbps[idx] = oled ? ssd1306_i2c_framebuffer_create(oled) : NULL;
+            if (!fbps[idx])
+                rc = -1;
+        }
+        if (rc < 0 || ssd1306_i2c_group_display_initialize(grp) < 0) {
+            rc = -1;
+            break;
+        }
+        int in_use = ssd1306_i2c_group_set_engine(grp, engine);
+        if (in_use < 0) {
+            rc = -1;
+            break;
+        }
+        bool threaded = (in_use == SSD1306_I2C_ENGINE_THREADS);
+        const ssd1306_framebuffer_t *const *updates = (const ssd1306_framebuffer_t *const *)fbps;
+        pthread_t self = pthread_self();
+        bool other_thread = false;
+        for (unsigned int upd = 0; upd < ENGINE_UPDATES && rc == 0; ++upd) {
+            for (size_t idx = 0; idx < ENGINE_NDISPLAYS; ++idx)
+                draw_frame(fbps[idx], upd * ENGINE_NDISPLAYS + (unsigned int)idx);
+            memset(buses, 0, sizeof(buses));
+            if (ssd1306_i2c_group_update(grp, updates, ENGINE_NDISPLAYS) < 0) {
+                rc = -1;
+                break;
+            }
+            // the display served first rotates through the group
+            size_t start = upd % ENGINE_NDISPLAYS;
+            for (size_t b = 0; b < ENGINE_NBUSES; ++b) {
+                size_t first = start;
+                while (first / 2 != b)
+                    first = (first + 1) % ENGINE_NDISPLAYS;
+                if (buses[b].ntx == 0 || buses[b].switches != 1 ||
+                    buses[b].addrs[0] != addrs[first]) {
+                    fprintf(stderr, "ERROR: %s: update %u sent %zu transactions on %s"
+                            " switching %u times, starting at 0x%02x\n", name, upd,
+                            buses[b].ntx, names[b], buses[b].switches, buses[b].addrs[0]);
+                    rc = -1;
+                }
+            }
+            // the calling thread takes the first bus
+            if (!pthread_equal(buses[0].thread, self) ||
+                (!threaded && !pthread_equal(buses[1].thread, self))) {
+                fprintf(stderr, "ERROR: %s: update %u ran on the wrong thread\n", name, upd);
+                rc = -1;
+            }
+            if (!pthread_equal(buses[1].thread, self))
+                other_thread = true;
+            for (size_t idx = 0; idx < ENGINE_NDISPLAYS && rc == 0; ++idx) {
+                if (!ssd1306_emu_matches(displays[idx].emu, fbps[idx])) {
+                    fprintf(stderr, "ERROR: %s: display %zu does not show update %u\n",
+                            name, idx, upd);
+                    rc = -1;
+                }
+            }
+        }
+        if (rc == 0 && threaded && !other_thread) {
+            fprintf(stderr, "ERROR: %s: second bus never had a thread of its own\n", name);
+            rc = -1;
+        }
+        if (rc == 0)
+            fprintf(stderr, "INFO: %ux%u %-26s %8s\n", 128, 64, name, engines[in_use]);
+    } while (0);
+    for (size_t idx = 0; idx < ENGINE_NDISPLAYS; ++idx) {
+        if (fbps[idx])
+            ssd1306_framebuffer_destroy(fbps[idx]);
+    }
+    ssd1306_i2c_group_destroy(grp);
+    for (size_t idx = 0; idx < ENGINE_NDISPLAYS; ++idx) {
+        if (displays[idx].emu)
+            ssd1306_emu_destroy(displays[idx].emu);
+    }
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_engine(SSD1306_I2C_ENGINE_SERIAL, "serial engine") < 0 ||
+        run_engine(SSD1306_I2C_ENGINE_THREADS, "threaded engine") < 0 ||
+        run_engine(SSD1306_I2C_ENGINE_URING, "io_uring engine") < 0) {
+        fprintf(stderr, "ERROR: group engines failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -63,9 +63,11 @@ int main ()
     ssd1306_i2c_display_update(oled, fbp);
     fprintf(stderr, "INFO: Starting vertical left horizontal scroll test\n");
     uint8_t sarea[2] = { 0x00, 0x20 /* 32 rows */ };
-    ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_DEACTIVATE, 0, 0);
-    ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_VERTICAL_AREA, sarea, 2);
-    ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_VERTICAL_LEFT_HORIZONTAL, scroll_data, 3);
+    ssd1306_i2c_cmd_batch_begin(oled);
+    ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_SCROLL_DEACTIVATE, 0, 0);
+    ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_SCROLL_VERTICAL_AREA, sarea, 2);
+    ssd1306_i2c_cmd_batch_append(oled, SSD1306_I2C_CMD_SCROLL_VERTICAL_LEFT_HORIZONTAL, scroll_data, 3);
+    ssd1306_i2c_cmd_batch_commit(oled);
     fprintf(stderr, "INFO: Activating vertical left horizontal scroll test and waiting 10 seconds...\n");
     sleep(10);
     fprintf(stderr, "INFO: Deactivating vertical left horizontal scroll test\n");
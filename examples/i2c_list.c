@@ -6,12 +6,20 @@
  */
 #include <ssd1306_i2c.h>
 
-int main ()
+int main (int argc, char **argv)
 {
     fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
     ssd1306_i2c_dev_t *devs = NULL;
     size_t num_devs = 0;
-    int rc = ssd1306_i2c_search_addresses(&devs, &num_devs, stderr);
+    // usage: test_i2c_list [-s] [cache file]. -s probes only 0x3c and 0x3d
+    ssd1306_i2c_search_opts_t opts = { 0 };
+    for (int idx = 1; idx < argc; ++idx) {
+        if (strcmp(argv[idx], "-s") == 0)
+            opts.ssd1306_only = true;
+        else
+            opts.cache_file = argv[idx];
+    }
+    int rc = ssd1306_i2c_search_addresses_ex(&devs, &num_devs, &opts, stderr);
     if (rc < 0)
         return rc;
     if (!devs) {
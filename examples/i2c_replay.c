@@ -0,0 +1,76 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include <ssd1306_emulator.h>
+
+// replays a capture made with ssd1306_i2c_capture_start() and prints the
+// traffic it caused. without -d it goes to the software emulator, so captures
+// can be compared across library versions without a display.
+// usage: ssd1306_replay [-r] [-d /dev/i2c-1] [-a 0x3c] [-W 128] [-H 32] capture
+//   -r  keep the captured timing instead of sending back to back
+//   -d  I2C device to replay to
+//   -a  address of the display on the device. default 0x3c
+//   -W  display width. default 128
+//   -H  display height. default 64
+int main(int argc, char **argv)
+{
+    bool realtime = false;
+    const char *dev = NULL;
+    const char *path = NULL;
+    uint8_t addr = 0x3c;
+    uint8_t width = 128;
+    uint8_t height = 64;
+    for (int idx = 1; idx < argc; ++idx) {
+        if (strcmp(argv[idx], "-r") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[idx], "-d") == 0 && idx + 1 < argc) {
+            dev = argv[++idx];
+        } else if (strcmp(argv[idx], "-a") == 0 && idx + 1 < argc) {
+            addr = (uint8_t)strtoul(argv[++idx], NULL, 0);
+        } else if (strcmp(argv[idx], "-W") == 0 && idx + 1 < argc) {
+            width = (uint8_t)strtoul(argv[++idx], NULL, 0);
+        } else if (strcmp(argv[idx], "-H") == 0 && idx + 1 < argc) {
+            height = (uint8_t)strtoul(argv[++idx], NULL, 0);
+        } else {
+            path = argv[idx];
+        }
+    }
+    if (!path) {
+        fprintf(stderr, "Usage: %s [-r] [-d device] [-a address] [-W width] [-H height] capture\n", argv[0]);
+        return -1;
+    }
+    ssd1306_emu_t *emu = NULL;
+    ssd1306_i2c_t *oled = NULL;
+    if (dev) {
+        oled = ssd1306_i2c_open(dev, addr, width, height, NULL);
+    } else if ((emu = ssd1306_emu_create()) != NULL) {
+        oled = ssd1306_i2c_open_transport(&ssd1306_i2c_transport_emulator, emu,
+                NULL, addr, width, height, NULL);
+    }
+    if (!oled) {
+        if (emu)
+            ssd1306_emu_destroy(emu);
+        return -1;
+    }
+    ssd1306_i2c_replay_stats_t st;
+    int rc = ssd1306_i2c_replay(oled, path, realtime, &st);
+    if (rc == 0) {
+        fprintf(stderr, "INFO: %" PRIu64 " submissions %" PRIu64 " transactions "
+                "(%" PRIu64 " command, %" PRIu64 " data) %" PRIu64 " bytes\n",
+                st.submissions, st.transactions, st.cmd_xfers, st.data_xfers, st.bytes);
+        fprintf(stderr, "INFO: captured over %.3f s, replayed in %.3f s\n",
+                (double)st.capture_ns / 1e9, (double)st.elapsed_ns / 1e9);
+        if (emu) {
+            fprintf(stderr, "INFO: emulator decoded %" PRIu64 " commands and %" PRIu64
+                    " data bytes, %" PRIu64 " unknown command bytes\n", emu->stats.commands,
+                    emu->stats.data_bytes, emu->stats.unknown_cmds);
+        }
+    }
+    ssd1306_i2c_close(oled);
+    if (emu)
+        ssd1306_emu_destroy(emu);
+    return rc;
+}
@@ -46,7 +46,8 @@ void onesec_timer_cb(EV_P_ ev_timer *w, int revents)
         ssd1306_framebuffer_clear(i2c->fbp);
         ssd1306_framebuffer_box_t bbox;
         ssd1306_framebuffer_draw_text(i2c->fbp, buf, 0, 32, 16, SSD1306_FONT_DEFAULT, 4, &bbox);
-        if (ssd1306_i2c_display_update(i2c->oled, i2c->fbp) < 0) {
+        /* hand the frame to the flush thread so the loop never waits on the bus */
+        if (ssd1306_i2c_async_present(i2c->oled, i2c->fbp) < 0) {
             fprintf(stderr, "ERROR: failed to update I2C display, exiting...\n");
             ev_break(EV_A_ EVBREAK_ALL);
         }
@@ -56,6 +57,24 @@ void onesec_timer_cb(EV_P_ ev_timer *w, int revents)
     }
 }
 
+void flush_done_cb(EV_P_ ev_io *w, int revents)
+{
+    if (w && (revents & EV_READ)) {
+        i2c_clock_t *i2c = (i2c_clock_t *)(w->data);
+        ssd1306_i2c_present_info_t infos[8];
+        size_t count = 0;
+        /* the fd stays readable until all completions are drained */
+        while ((count = ssd1306_i2c_async_drain(i2c->oled, infos, 8)) > 0) {
+            for (size_t idx = 0; idx < count; ++idx) {
+                printf("INFO: Frame %" PRIu64 " %s in %" PRIu64 " us, %" PRIu64 " bytes\n",
+                        infos[idx].seq, infos[idx].failed ? "failed" :
+                        (infos[idx].dropped ? "dropped" : "sent"),
+                        infos[idx].bus_ns / 1000, infos[idx].bus_bytes);
+            }
+        }
+    }
+}
+
 int main(int argc, char **argv)
 {
     /* check if i2c device exists */
@@ -75,8 +94,14 @@ int main(int argc, char **argv)
     }
     /* clear the display */
     ssd1306_i2c_display_clear(oled);
-    /* create a framebuffer */
-    ssd1306_framebuffer_t *fbp = ssd1306_framebuffer_create(oled->width, oled->height, oled->err);
+    /* create a framebuffer that can be written to the device without copying */
+    ssd1306_framebuffer_t *fbp = ssd1306_i2c_framebuffer_create(oled);
+    /* start the flush thread */
+    if (ssd1306_i2c_async_start(oled) < 0) {
+        ssd1306_framebuffer_destroy(fbp);
+        ssd1306_i2c_close(oled);
+        return -1;
+    }
     /* create an object to send to the callbacks */
     i2c_clock_t timer_data = {
         .oled = oled,
@@ -93,7 +118,17 @@ int main(int argc, char **argv)
     timer_watcher.data = &timer_data;
     /* start the timer */
     ev_timer_start(loop, &timer_watcher);
+    /* watch the flush thread's completions */
+    ev_io done_watcher = { 0 };
+    int efd = ssd1306_i2c_async_eventfd(oled);
+    if (efd >= 0) {
+        ev_io_init(&done_watcher, flush_done_cb, efd, EV_READ);
+        done_watcher.data = &timer_data;
+        ev_io_start(loop, &done_watcher);
+    }
     ev_run(loop, 0);
+    if (efd >= 0)
+        ev_io_stop(loop, &done_watcher);
     ssd1306_framebuffer_destroy(fbp);
     ssd1306_i2c_close(oled);
     return 0;
@@ -0,0 +1,112 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+#include <errno.h>
+
+// feeds the emulator at about 2us per byte, so a full frame takes longer
+// than a slot at 1000 fps and paced frames are late
+static int slow_bus(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata)
+{
+    (void)addr;
+    struct timespec ts = { 0, (long)(len * 2000) };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+    return ssd1306_emu_write((ssd1306_emu_t *)cbdata, buf, len);
+}
+
+typedef struct {
+    unsigned int handled;
+    unsigned int late;
+    unsigned int dropped;
+    unsigned int dropped_twice; // frames dropped right after a dropped one
+    unsigned int partial;
+    unsigned int failed;
+    bool last_dropped;
+} pacing_count_t;
+
+static void count_present(ssd1306_i2c_t *oled, const ssd1306_i2c_present_info_t *info,
+        void *cbdata)
+{
+    (void)oled;
+    pacing_count_t *cnt = (pacing_count_t *)cbdata;
+    cnt->handled++;
+    cnt->late += info->late ? 1 : 0;
+    cnt->dropped += info->dropped ? 1 : 0;
+    cnt->dropped_twice += (info->dropped && cnt->last_dropped) ? 1 : 0;
+    cnt->partial += info->partial ? 1 : 0;
+    cnt->failed += info->failed ? 1 : 0;
+    cnt->last_dropped = info->dropped;
+}
+
+// presents frames faster than a slow bus takes them with pacing at 1000 fps
+// and checks what each policy does with the late ones: drop never drops two
+// in a row, merge never drops and degrade sends parts of frames. merge and
+// degrade end up with the last frame on the display
+static int run_pacing(ssd1306_i2c_pace_policy_t policy, const char *name)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    pacing_count_t cnt = { 0 };
+    fx.tcb.cb = slow_bus;
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0 ||
+            ssd1306_i2c_async_start(fx.oled) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        ssd1306_i2c_pacing_t pacing = { 0 };
+        pacing.fps = 1000;
+        pacing.policy = policy;
+        pacing.cb = count_present;
+        pacing.cbdata = &cnt;
+        if (ssd1306_i2c_async_set_pacing(oled, &pacing) < 0) {
+            rc = -1;
+            break;
+        }
+        // every byte changes in every frame
+        for (unsigned int frame = 0; frame < 32 && rc == 0; ++frame) {
+            for (size_t idx = 0; idx < fbp->len; ++idx)
+                fbp->buffer[idx] = (uint8_t)(frame * 37 + idx);
+            rc = ssd1306_i2c_async_present(oled, fbp);
+            usleep(1000);
+        }
+        if (rc < 0)
+            break;
+        ssd1306_i2c_async_stop(oled);
+        fprintf(stderr, "INFO: 128x64 %-26s %8u handled %4u late %4u dropped %4u partial\n",
+                name, cnt.handled, cnt.late, cnt.dropped, cnt.partial);
+        bool ok = (cnt.late > 0 && cnt.failed == 0 && cnt.dropped_twice == 0);
+        if (policy == SSD1306_I2C_PACE_DROP)
+            ok = ok && cnt.dropped > 0 && cnt.dropped < cnt.handled;
+        else
+            ok = ok && cnt.dropped == 0 && ssd1306_emu_matches(emu, fbp);
+        if (policy == SSD1306_I2C_PACE_DEGRADE)
+            ok = ok && cnt.partial > 0;
+        if (!ok) {
+            fprintf(stderr, "ERROR: %s: unexpected frame handling\n", name);
+            rc = -1;
+            break;
+        }
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_pacing(SSD1306_I2C_PACE_DROP, "pacing drop") < 0 ||
+        run_pacing(SSD1306_I2C_PACE_MERGE, "pacing merge") < 0 ||
+        run_pacing(SSD1306_I2C_PACE_DEGRADE, "pacing degrade") < 0) {
+        fprintf(stderr, "ERROR: pacing failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,142 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include <ssd1306_i2c.h>
+#include <unistd.h>
+
+// the token line of the cache and the buses found by a scan
+typedef struct {
+    char token[64];
+    ssd1306_i2c_dev_t *devs;
+    size_t num_devs;
+} probe_result_t;
+
+static int probe_search(const char *cache, size_t threads, probe_result_t *res)
+{
+    ssd1306_i2c_search_opts_t opts = { 0 };
+    opts.cache_file = cache;
+    opts.threads = threads;
+    // the scan logs every bus it tries
+    FILE *log = tmpfile();
+    int rc = ssd1306_i2c_search_addresses_ex(&(res->devs), &(res->num_devs), &opts,
+                    log ? log : stderr);
+    if (log)
+        fclose(log);
+    if (rc < 0 || !res->devs)
+        return -1;
+    FILE *fp = fopen(cache, "r");
+    if (!fp || !fgets(res->token, sizeof(res->token), fp) ||
+        strncmp(res->token, "token ", 6) != 0) {
+        fprintf(stderr, "ERROR: probe cache: %s was not written\n", cache);
+        rc = -1;
+    }
+    if (fp)
+        fclose(fp);
+    return rc;
+}
+
+static bool probe_same(const probe_result_t *a, const probe_result_t *b)
+{
+    if (a->num_devs != b->num_devs)
+        return false;
+    for (size_t idx = 0; idx < a->num_devs; ++idx) {
+        if (strcmp(a->devs[idx].dev, b->devs[idx].dev) != 0 ||
+            a->devs[idx].num_addrs != b->devs[idx].num_addrs ||
+            memcmp(a->devs[idx].addrs, b->devs[idx].addrs, a->devs[idx].num_addrs) != 0)
+            return false;
+    }
+    return true;
+}
+
+// checks that a parallel and a single threaded scan find the same buses and
+// write the same cache token, that a bus planted in the cache file is
+// returned by the next search without scanning, and that a cache with another
+// token is ignored and rewritten. the real buses, if any, are only compared
+// between the scans
+static int run_probe_cache(void)
+{
+    int rc = 0;
+    char cache[] = "/tmp/ssd1306-probe-XXXXXX";
+    int fd = mkstemp(cache);
+    probe_result_t scan, single, cached, stale;
+    memset(&scan, 0, sizeof(scan));
+    memset(&single, 0, sizeof(single));
+    memset(&cached, 0, sizeof(cached));
+    memset(&stale, 0, sizeof(stale));
+    do {
+        if (fd < 0) {
+            rc = -1;
+            break;
+        }
+        close(fd);
+        unlink(cache);
+        if (probe_search(cache, 0, &scan) < 0 || unlink(cache) < 0 ||
+            probe_search(cache, 1, &single) < 0) {
+            rc = -1;
+            break;
+        }
+        if (!probe_same(&scan, &single) || strcmp(scan.token, single.token) != 0) {
+            fprintf(stderr, "ERROR: probe cache: %zu buses scanned in parallel, %zu in turn\n",
+                    scan.num_devs, single.num_devs);
+            rc = -1;
+            break;
+        }
+        FILE *fp = fopen(cache, "a");
+        if (!fp) {
+            rc = -1;
+            break;
+        }
+        fprintf(fp, "/dev/i2c-cached 2 3c 3d\n");
+        fclose(fp);
+        if (probe_search(cache, 0, &cached) < 0) {
+            rc = -1;
+            break;
+        }
+        const ssd1306_i2c_dev_t *last = cached.num_devs ? &(cached.devs[cached.num_devs - 1]) : NULL;
+        if (cached.num_devs != scan.num_devs + 1 || !last ||
+            strcmp(last->dev, "/dev/i2c-cached") != 0 || last->num_addrs != 2 ||
+            last->addrs[0] != 0x3c || last->addrs[1] != 0x3d) {
+            fprintf(stderr, "ERROR: probe cache: planted bus not returned, got %zu buses\n",
+                    cached.num_devs);
+            rc = -1;
+            break;
+        }
+        // another boot or another set of adapters
+        fp = fopen(cache, "w");
+        if (!fp) {
+            rc = -1;
+            break;
+        }
+        fprintf(fp, "token 0000000000000000\n/dev/i2c-cached 1 3c\n");
+        fclose(fp);
+        if (probe_search(cache, 0, &stale) < 0 || !probe_same(&scan, &stale) ||
+            strcmp(scan.token, stale.token) != 0) {
+            fprintf(stderr, "ERROR: probe cache: stale cache used, got %zu buses\n",
+                    stale.num_devs);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: %zu buses %-26s %8s\n", scan.num_devs, "probe cache", "ok");
+    } while (0);
+    free(scan.devs);
+    free(single.devs);
+    free(cached.devs);
+    free(stale.devs);
+    if (fd >= 0)
+        unlink(cache);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_probe_cache() < 0) {
+        fprintf(stderr, "ERROR: probe cache failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,99 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+#include <sched.h>
+
+// the realtime flush thread with SCHED_OTHER needs no privileges, so this
+// covers starting it with locked memory and its wakeup stats
+static int run_realtime(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        ssd1306_i2c_realtime_t rt = { 0 };
+        rt.policy = SCHED_OTHER;
+        rt.priority = 0;
+        rt.lock_memory = true;
+        if (ssd1306_i2c_async_start_realtime(oled, &rt) < 0) {
+            // a low RLIMIT_MEMLOCK is not a failure of the library
+            fprintf(stderr, "WARN: realtime: cannot lock memory, trying without\n");
+            rt.lock_memory = false;
+            if (ssd1306_i2c_async_start_realtime(oled, &rt) < 0) {
+                rc = -1;
+                break;
+            }
+        }
+        ssd1306_i2c_async_stats_t st = { 0 };
+        for (unsigned int frame = 0; frame < 32 && rc == 0; ++frame) {
+            draw_frame(fbp, frame);
+            rc = ssd1306_i2c_async_present(oled, fbp);
+            // wait for each frame so every one has a wakeup measured
+            for (int tries = 0; rc == 0 && tries < 1000; ++tries) {
+                usleep(1000);
+                if (ssd1306_i2c_async_get_stats(oled, &st) < 0)
+                    rc = -1;
+                else if (st.flushed + st.dropped >= st.submitted)
+                    break;
+            }
+        }
+        if (rc < 0)
+            break;
+        fprintf(stderr, "INFO: 128x64 %-26s %8.1f us wake %6.1f us max %6.1f us jitter\n",
+                "realtime flush thread", st.wake_ns / 1e3, st.wake_max_ns / 1e3,
+                st.jitter_ns / 1e3);
+        if (st.flushed == 0 || st.errors != 0 || st.wake_max_ns == 0 ||
+            st.wake_ns > st.wake_max_ns || !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: realtime: %" PRIu64 " flushed %" PRIu64 " errors %"
+                    PRIu64 " ns max wake\n", st.flushed, st.errors, st.wake_max_ns);
+            rc = -1;
+            break;
+        }
+        // the capture file would be written from the realtime thread
+        const char *path = "/tmp/ssd1306_realtime_capture";
+        ssd1306_err_set_log_callback(oled->err, quiet_log, NULL);
+        int captured = ssd1306_i2c_capture_start(oled, path);
+        ssd1306_err_set_log_callback(oled->err, NULL, NULL);
+        if (captured == 0 || oled->capture) {
+            ssd1306_i2c_capture_stop(oled);
+            unlink(path);
+            fprintf(stderr, "ERROR: realtime: capture started with the realtime thread\n");
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_async_stop(oled);
+        // an invalid priority for the policy leaves no thread running
+        rt.priority = 50;
+        ssd1306_err_set_log_callback(oled->err, quiet_log, NULL);
+        int started = ssd1306_i2c_async_start_realtime(oled, &rt);
+        ssd1306_err_set_log_callback(oled->err, NULL, NULL);
+        if (started == 0 || oled->async) {
+            fprintf(stderr, "ERROR: realtime: priority 50 accepted for SCHED_OTHER\n");
+            rc = -1;
+            break;
+        }
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_realtime() < 0) {
+        fprintf(stderr, "ERROR: realtime flush thread failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,99 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// checks that the register cache leaves out commands that change nothing,
+// including the address window of a full update once the GDDRAM pointer has
+// wrapped back to its start, and sends them again once invalidated
+static int run_regcache(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        uint8_t contrast = 0x42;
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &contrast, 1) < 0 ||
+            ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_INVERTED, 0, 0) < 0 ||
+            emu->stats.cmd_bytes != 3 || emu->contrast != contrast || !emu->inverted) {
+            fprintf(stderr, "ERROR: regcache: first commands sent %" PRIu64 " bytes\n",
+                    emu->stats.cmd_bytes);
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &contrast, 1) < 0 ||
+            ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_INVERTED, 0, 0) < 0 ||
+            emu->stats.bytes != 0) {
+            fprintf(stderr, "ERROR: regcache: repeated commands sent %" PRIu64 " bytes\n",
+                    emu->stats.bytes);
+            rc = -1;
+            break;
+        }
+        // the pointer wraps back to the start of the window after a full
+        // frame, so the next one needs no address commands
+        for (size_t idx = 0; idx < fbp->len; ++idx)
+            fbp->buffer[idx] = (uint8_t)idx;
+        if (ssd1306_i2c_display_update(oled, fbp) < 0) {
+            rc = -1;
+            break;
+        }
+        fbp->buffer[0] ^= 0xFF;
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_display_update(oled, fbp) < 0 || emu->stats.cmd_bytes != 0 ||
+            !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: regcache: update after wrap sent %" PRIu64 " command bytes\n",
+                    emu->stats.cmd_bytes);
+            rc = -1;
+            break;
+        }
+        // a new scroll setup needs its 0x2F even if the last one was 0x2F too
+        uint8_t pages[3] = { 0, 0, 3 };
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_LEFT_HORIZONTAL, pages, 3) < 0 ||
+            ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_RIGHT_HORIZONTAL, pages, 3) < 0 ||
+            ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_DEACTIVATE, 0, 0) < 0 ||
+            emu->stats.cmd_bytes != 17) {
+            fprintf(stderr, "ERROR: regcache: scroll setups sent %" PRIu64 " bytes\n",
+                    emu->stats.cmd_bytes);
+            rc = -1;
+            break;
+        }
+        // after invalidating, or with the cache off, everything goes out
+        ssd1306_i2c_regcache_invalidate(oled);
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &contrast, 1) < 0 ||
+            emu->stats.cmd_bytes != 2 || ssd1306_i2c_regcache_enable(oled, false) < 0 ||
+            ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &contrast, 1) < 0 ||
+            emu->stats.cmd_bytes != 4) {
+            fprintf(stderr, "ERROR: regcache: uncached commands sent %" PRIu64 " bytes\n",
+                    emu->stats.cmd_bytes);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x64 %-26s %8s\n", "register cache", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_regcache() < 0) {
+        fprintf(stderr, "ERROR: register cache failed\n");
+        rc = -1;
+    }
+    return rc;
+}
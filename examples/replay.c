@@ -0,0 +1,77 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// captures a shadow mode animation and replays it into a second emulator,
+// which has to end up with the same GDDRAM after the same traffic
+static int run_replay(uint8_t width, uint8_t height)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 }, fx2 = { 0 };
+    char path[] = "/tmp/ssd1306_captureXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    do {
+        if (emu_fixture_open(&fx, width, height, NULL, EMU_FIXTURE_FB) < 0 ||
+            emu_fixture_open(&fx2, width, height, NULL, 0) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu, *emu2 = fx2.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        // captured from the start, initialization included
+        if (ssd1306_i2c_shadow_enable(oled, true) < 0 ||
+            ssd1306_i2c_capture_start(oled, path) < 0 ||
+            ssd1306_i2c_display_initialize(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        for (unsigned int frame = 0; frame < EMU_TEST_FRAMES && rc == 0; ++frame) {
+            draw_frame(fbp, frame);
+            rc = ssd1306_i2c_display_update(oled, fbp);
+        }
+        if (rc < 0 || ssd1306_i2c_capture_stop(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_replay_stats_t st;
+        if (ssd1306_i2c_replay(fx2.oled, path, false, &st) < 0) {
+            rc = -1;
+            break;
+        }
+        if (st.bytes != emu->stats.bytes || emu2->stats.bytes != emu->stats.bytes ||
+            emu2->stats.transactions != emu->stats.transactions ||
+            memcmp(emu2->gddram, emu->gddram, sizeof(emu->gddram)) != 0 ||
+            emu2->start_line != emu->start_line || emu2->mem_mode != emu->mem_mode) {
+            fprintf(stderr, "ERROR: replay: %" PRIu64 " bytes replayed for %" PRIu64 " captured\n",
+                    emu2->stats.bytes, emu->stats.bytes);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: %ux%u %-26s %8.1f bytes/frame %6.2f submissions/frame\n",
+                width, height, "capture replay", (double)st.bytes / EMU_TEST_FRAMES,
+                (double)st.submissions / EMU_TEST_FRAMES);
+    } while (0);
+    unlink(path);
+    emu_fixture_close(&fx);
+    emu_fixture_close(&fx2);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_replay(128, 64) < 0 || run_replay(128, 32) < 0) {
+        fprintf(stderr, "ERROR: capture replay failed\n");
+        rc = -1;
+    }
+    return rc;
+}
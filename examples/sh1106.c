@@ -0,0 +1,128 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+#define SH1106_TX_MAX 32
+#define SH1106_TX_BYTES 160
+
+// the transactions of one update. the emulator has 128 columns of RAM, so it
+// cannot show where the 132 column SH1106 is written and the bytes are
+// checked as they are sent
+typedef struct {
+    ssd1306_emu_t *emu;
+    size_t ntx;
+    size_t lens[SH1106_TX_MAX];
+    uint8_t bufs[SH1106_TX_MAX][SH1106_TX_BYTES];
+} sh1106_sink_t;
+
+static int sh1106_bus(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata)
+{
+    (void)addr;
+    sh1106_sink_t *sink = (sh1106_sink_t *)cbdata;
+    if (sink->ntx < SH1106_TX_MAX) {
+        sink->lens[sink->ntx] = len;
+        memcpy(sink->bufs[sink->ntx], buf, len < SH1106_TX_BYTES ? len : SH1106_TX_BYTES);
+    }
+    sink->ntx++;
+    // still decoded, so that the initialization is checked
+    return ssd1306_emu_write(sink->emu, buf, len);
+}
+
+// checks that the update sent the pages set in pages and no others, in order,
+// each addressed with 00 B<p> 02 10 and followed by its first ncols columns
+static bool sh1106_pages_sent(const sh1106_sink_t *sink, uint8_t pages, size_t ncols,
+        const ssd1306_framebuffer_t *fbp)
+{
+    size_t tx = 0;
+    for (uint8_t p = 0; p < fbp->height / 8; ++p) {
+        if (!(pages & (1u << p)))
+            continue;
+        if (tx + 2 > sink->ntx || tx + 2 > SH1106_TX_MAX)
+            return false;
+        const uint8_t *cmds = sink->bufs[tx];
+        const uint8_t *data = sink->bufs[tx + 1];
+        if (sink->lens[tx] != 4 || cmds[0] != 0x00 || cmds[1] != (0xB0 | p) ||
+            cmds[2] != 0x02 || cmds[3] != 0x10) {
+            fprintf(stderr, "ERROR: sh1106: page %u addressed with %02x %02x %02x %02x\n",
+                    p, cmds[0], cmds[1], cmds[2], cmds[3]);
+            return false;
+        }
+        if (sink->lens[tx + 1] != ncols + 1 || data[0] != 0x40 ||
+            memcmp(&data[1], &(fbp->buffer[p * fbp->width]), ncols) != 0) {
+            fprintf(stderr, "ERROR: sh1106: page %u sent %zu bytes\n", p, sink->lens[tx + 1]);
+            return false;
+        }
+        tx += 2;
+    }
+    return tx == sink->ntx;
+}
+
+// runs the SH1106 profile with shadow mode over a bus that records each
+// transaction. a full update writes every page from RAM column 2, and an
+// update of the first column of two pages writes only those
+static int run_sh1106(void)
+{
+    int rc = 0;
+    sh1106_sink_t *sink = calloc(1, sizeof(*sink));
+    emu_fixture_t fx = { 0 };
+    fx.tcb.cb = sh1106_bus;
+    fx.tcb.cbdata = sink;
+    do {
+        // the bus needs the emulator before initializing
+        if (!sink || emu_fixture_open(&fx, 128, 64, &ssd1306_i2c_profile_sh1106, 0) < 0) {
+            rc = -1;
+            break;
+        }
+        sink->emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        fx.fbp = ssd1306_i2c_framebuffer_create(oled);
+        if (!fx.fbp || ssd1306_i2c_display_initialize(oled) < 0 ||
+            fx.emu->stats.unknown_cmds != 0 || ssd1306_i2c_shadow_enable(oled, true) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        draw_frame(fbp, 3);
+        sink->ntx = 0;
+        if (ssd1306_i2c_display_update(oled, fbp) < 0 ||
+            !sh1106_pages_sent(sink, 0xFF, fbp->width, fbp)) {
+            fprintf(stderr, "ERROR: sh1106: full update sent %zu transactions\n", sink->ntx);
+            rc = -1;
+            break;
+        }
+        fbp->buffer[3 * fbp->width] ^= 0xFF;
+        fbp->buffer[5 * fbp->width] ^= 0xFF;
+        sink->ntx = 0;
+        if (ssd1306_i2c_display_update(oled, fbp) < 0 ||
+            !sh1106_pages_sent(sink, (1u << 3) | (1u << 5), 1, fbp)) {
+            fprintf(stderr, "ERROR: sh1106: partial update sent %zu transactions\n", sink->ntx);
+            rc = -1;
+            break;
+        }
+        sink->ntx = 0;
+        if (ssd1306_i2c_display_update(oled, fbp) < 0 || sink->ntx != 0) {
+            fprintf(stderr, "ERROR: sh1106: unchanged frame sent %zu transactions\n", sink->ntx);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: %ux%u %-26s %8s\n", 128, 64, "SH1106 page writes", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    free(sink);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_sh1106() < 0) {
+        fprintf(stderr, "ERROR: SH1106 profile failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,151 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// runs an animation through each update strategy against the software
+// emulator and checks what they put on the bus: every one leaves GDDRAM
+// matching the framebuffer, a zero-copy framebuffer sends what a copied one
+// does, shadow mode sends less and chunked transfers fit an SMBus block.
+
+typedef struct {
+    const char *name;
+    bool shadow;
+    size_t chunk_size;
+    bool prefixed; // use ssd1306_i2c_framebuffer_create()
+} strategy_t;
+
+enum {
+    STRATEGY_FULL,
+    STRATEGY_ZERO_COPY,
+    STRATEGY_SHADOW,
+    STRATEGY_CHUNKS,
+    STRATEGY_SHADOW_CHUNKS,
+    STRATEGY_COUNT
+};
+
+static const strategy_t strategies[STRATEGY_COUNT] = {
+    { "full update", false, 0, false },
+    { "zero-copy framebuffer", false, 0, true },
+    { "shadow partial update", true, 0, true },
+    { "SMBus sized chunks", false, SSD1306_I2C_SMBUS_BLOCK_MAX, true },
+    { "shadow with SMBus chunks", true, SSD1306_I2C_SMBUS_BLOCK_MAX, true }
+};
+
+typedef struct {
+    ssd1306_emu_t *emu;
+    size_t max_len; // longest transaction seen
+} strategy_bus_t;
+
+static int strategy_bus(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata)
+{
+    (void)addr;
+    strategy_bus_t *bus = (strategy_bus_t *)cbdata;
+    if (len > bus->max_len)
+        bus->max_len = len;
+    return ssd1306_emu_write(bus->emu, buf, len);
+}
+
+// runs the animation and returns the bytes sent and the longest transaction
+static int run_strategy(const strategy_t *strat, uint8_t width, uint8_t height,
+        uint64_t *bytes, size_t *max_len)
+{
+    int rc = 0;
+    strategy_bus_t bus = { NULL, 0 };
+    emu_fixture_t fx = { 0 };
+    fx.tcb.cb = strategy_bus;
+    fx.tcb.cbdata = &bus;
+    do {
+        // the bus needs the emulator before initializing
+        if (emu_fixture_open(&fx, width, height, NULL, 0) < 0) {
+            rc = -1;
+            break;
+        }
+        bus.emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        if (ssd1306_i2c_display_initialize(oled) < 0 ||
+            ssd1306_i2c_set_chunk_size(oled, strat->chunk_size) < 0 ||
+            ssd1306_i2c_shadow_enable(oled, strat->shadow) < 0) {
+            rc = -1;
+            break;
+        }
+        if (strat->prefixed)
+            fx.fbp = ssd1306_i2c_framebuffer_create(oled);
+        else
+            fx.fbp = ssd1306_framebuffer_create(oled->width, oled->height, oled->err);
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        if (!fbp) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_reset_stats(bus.emu);
+        bus.max_len = 0;
+        for (unsigned int frame = 0; frame < EMU_TEST_FRAMES; ++frame) {
+            draw_frame(fbp, frame);
+            if (ssd1306_i2c_display_update(oled, fbp) < 0) {
+                rc = -1;
+                break;
+            }
+            if (!ssd1306_emu_matches(bus.emu, fbp)) {
+                fprintf(stderr, "ERROR: %s: GDDRAM differs from framebuffer at frame %u\n",
+                        strat->name, frame);
+                rc = -1;
+                break;
+            }
+        }
+        *bytes = bus.emu->stats.bytes;
+        *max_len = bus.max_len;
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+static int run_strategies(uint8_t width, uint8_t height)
+{
+    uint64_t bytes[STRATEGY_COUNT] = { 0 };
+    size_t max_len[STRATEGY_COUNT] = { 0 };
+    for (size_t idx = 0; idx < STRATEGY_COUNT; ++idx) {
+        if (run_strategy(&strategies[idx], width, height, &bytes[idx], &max_len[idx]) < 0) {
+            fprintf(stderr, "ERROR: %ux%u %s failed\n", width, height, strategies[idx].name);
+            return -1;
+        }
+    }
+    if (bytes[STRATEGY_ZERO_COPY] != bytes[STRATEGY_FULL]) {
+        fprintf(stderr, "ERROR: %ux%u zero-copy sent %" PRIu64 " bytes, a copy %" PRIu64 "\n",
+                width, height, bytes[STRATEGY_ZERO_COPY], bytes[STRATEGY_FULL]);
+        return -1;
+    }
+    if (bytes[STRATEGY_SHADOW] >= bytes[STRATEGY_FULL] ||
+        bytes[STRATEGY_SHADOW_CHUNKS] >= bytes[STRATEGY_CHUNKS]) {
+        fprintf(stderr, "ERROR: %ux%u shadow sent %" PRIu64 " and %" PRIu64 " bytes, "
+                "full updates %" PRIu64 " and %" PRIu64 "\n", width, height,
+                bytes[STRATEGY_SHADOW], bytes[STRATEGY_SHADOW_CHUNKS],
+                bytes[STRATEGY_FULL], bytes[STRATEGY_CHUNKS]);
+        return -1;
+    }
+    // the control byte goes in front of each chunk
+    if (max_len[STRATEGY_CHUNKS] > SSD1306_I2C_SMBUS_BLOCK_MAX + 1 ||
+        max_len[STRATEGY_SHADOW_CHUNKS] > SSD1306_I2C_SMBUS_BLOCK_MAX + 1 ||
+        max_len[STRATEGY_FULL] <= SSD1306_I2C_SMBUS_BLOCK_MAX + 1) {
+        fprintf(stderr, "ERROR: %ux%u longest transactions %zu and %zu bytes chunked, "
+                "%zu bytes whole\n", width, height, max_len[STRATEGY_CHUNKS],
+                max_len[STRATEGY_SHADOW_CHUNKS], max_len[STRATEGY_FULL]);
+        return -1;
+    }
+    fprintf(stderr, "INFO: %ux%u %-26s %8s\n", width, height, "update strategies", "ok");
+    return 0;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_strategies(128, 64) < 0 || run_strategies(128, 32) < 0) {
+        fprintf(stderr, "ERROR: update strategies failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,117 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// starts a ticker, moves it to another band and stops it, checking the
+// scroll setup the controller gets and that the old band is put back
+static int run_ticker(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp = ssd1306_framebuffer_create(128, 64, oled->err);
+        if (!fbp) {
+            rc = -1;
+            break;
+        }
+        for (size_t idx = 0; idx < fbp->len; ++idx)
+            fbp->buffer[idx] = (uint8_t)idx;
+        ssd1306_i2c_ticker_t tk = { 0 };
+        tk.page_start = 2;
+        tk.page_end = 3;
+        tk.interval = 7;
+        if (ssd1306_i2c_display_update(oled, fbp) < 0 ||
+            ssd1306_i2c_ticker_start(oled, &tk, fbp) < 0) {
+            rc = -1;
+            break;
+        }
+        if (!emu->scroll_active || emu->scroll_cmd != 0x27 || emu->scroll_start_page != 2 ||
+            emu->scroll_end_page != 3 || emu->scroll_interval != 7 ||
+            !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: ticker: scroll 0x%02x pages %u-%u interval %u\n",
+                    emu->scroll_cmd, emu->scroll_start_page, emu->scroll_end_page,
+                    emu->scroll_interval);
+            rc = -1;
+            break;
+        }
+        // a new band rewrites the rotated old one before scrolling
+        ssd1306_emu_scroll_step(emu, 5);
+        tk.page_start = 5;
+        tk.page_end = 6;
+        tk.scroll_right = true;
+        tk.font = SSD1306_FONT_VERA;
+        tk.font_size = 10;
+        if (ssd1306_i2c_ticker_start(oled, &tk, fbp) < 0) {
+            rc = -1;
+            break;
+        }
+        if (!emu->scroll_active || emu->scroll_cmd != 0x26 || emu->scroll_start_page != 5 ||
+            emu->scroll_end_page != 6 || !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: ticker: restarted scroll 0x%02x pages %u-%u\n",
+                    emu->scroll_cmd, emu->scroll_start_page, emu->scroll_end_page);
+            rc = -1;
+            break;
+        }
+        // text is rendered into the band only
+        bool band_lit = false, rest_same = true;
+        if (ssd1306_i2c_ticker_set_text(oled, "ticker") < 0) {
+            rc = -1;
+            break;
+        }
+        for (uint8_t p = 0; p < SSD1306_EMU_PAGES; ++p) {
+            for (uint8_t x = 0; x < SSD1306_EMU_COLUMNS; ++x) {
+                if (p == 5 || p == 6)
+                    band_lit |= (emu->gddram[p][x] != 0);
+                else
+                    rest_same &= (emu->gddram[p][x] == fbp->buffer[p * 128 + x]);
+            }
+        }
+        if (!band_lit || !rest_same || !emu->scroll_active || emu->scroll_start_page != 5) {
+            fprintf(stderr, "ERROR: ticker: text band lit %d, rest unchanged %d\n",
+                    band_lit, rest_same);
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_ticker_stop(oled) < 0 || emu->scroll_active ||
+            emu->stats.bytes != 2 || emu->stats.cmd_bytes != 1) {
+            fprintf(stderr, "ERROR: ticker: stop sent %" PRIu64 " bytes, scrolling %d\n",
+                    emu->stats.bytes, emu->scroll_active);
+            rc = -1;
+            break;
+        }
+        // without a running ticker there is no band to replace
+        ssd1306_err_set_log_callback(oled->err, quiet_log, NULL);
+        ssd1306_emu_reset_stats(emu);
+        if (ssd1306_i2c_ticker_set_content(oled, fbp) == 0 || emu->scroll_active ||
+            emu->stats.bytes != 0) {
+            fprintf(stderr, "ERROR: ticker: content replaced while stopped\n");
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x64 %-26s %8s\n", "hardware scroll ticker", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_ticker() < 0) {
+        fprintf(stderr, "ERROR: ticker failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,164 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+#include <errno.h>
+
+typedef struct {
+    ssd1306_emu_t *emu;
+    ssd1306_i2c_t *oled;
+    const ssd1306_framebuffer_t *region; // submitted once the frame is on the bus
+    unsigned int ntx;
+    unsigned int region_tx; // transaction that brought the region
+    unsigned int frame_tx; // transaction that brought the frame's last page
+} urgent_bus_t;
+
+// a slow bus that submits an urgent region to page 7 as soon as the first
+// page of an all 0xFF frame has landed and notes when each arrived
+static int urgent_bus(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata)
+{
+    (void)addr;
+    urgent_bus_t *ub = (urgent_bus_t *)cbdata;
+    struct timespec ts = { 0, (long)(len * 2000) };
+    while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+    int rc = ssd1306_emu_write(ub->emu, buf, len);
+    ub->ntx++;
+    if (ub->region && ub->emu->gddram[0][0] == 0xFF) {
+        if (ssd1306_i2c_async_present_region(ub->oled, ub->region, 0, 56, 8, 8, 1) < 0)
+            rc = -1;
+        ub->region = NULL;
+    }
+    if (ub->region_tx == 0 && ub->emu->gddram[7][0] == 0x5A)
+        ub->region_tx = ub->ntx;
+    if (ub->frame_tx == 0 && ub->emu->gddram[7][SSD1306_EMU_COLUMNS - 1] == 0xFF)
+        ub->frame_tx = ub->ntx;
+    return rc;
+}
+
+// waits until the flush thread has handled every frame presented and sent
+// nurgent regions
+static int wait_flushed(ssd1306_i2c_t *oled, uint64_t nurgent, ssd1306_i2c_async_stats_t *st)
+{
+    for (int tries = 0; tries < 1000; ++tries) {
+        if (ssd1306_i2c_async_get_stats(oled, st) < 0)
+            return -1;
+        if (st->flushed + st->dropped >= st->submitted && st->urgent >= nurgent)
+            return 0;
+        usleep(1000);
+    }
+    return -1;
+}
+
+// a preemptible flush thread gets an urgent region while it sends a full
+// frame, which has to land between two of the frame's pages and stay there
+static int run_urgent(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    ssd1306_framebuffer_t *region = NULL;
+    urgent_bus_t ub = { 0 };
+    fx.tcb.cb = urgent_bus;
+    fx.tcb.cbdata = &ub;
+    do {
+        // the bus needs the emulator and the display before initializing
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_FB) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = ub.emu = fx.emu;
+        ssd1306_i2c_t *oled = ub.oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        region = ssd1306_framebuffer_create(oled->width, oled->height, oled->err);
+        ssd1306_i2c_async_stats_t st = { 0 };
+        if (!region || ssd1306_i2c_display_initialize(oled) < 0 ||
+            ssd1306_i2c_async_start(oled) < 0 || ssd1306_i2c_async_set_preemptible(oled, true) < 0 ||
+            ssd1306_i2c_async_present(oled, fbp) < 0 || wait_flushed(oled, 0, &st) < 0) {
+            rc = -1;
+            break;
+        }
+        memset(region->buffer, 0x5A, region->len);
+        memset(fbp->buffer, 0xFF, fbp->len);
+        ub.region = region;
+        if (ssd1306_i2c_async_present(oled, fbp) < 0 || wait_flushed(oled, 1, &st) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_async_stop(oled);
+        // the region is drawn into the rest of the frame so it stays
+        for (size_t idx = 0; idx < 8; ++idx)
+            fbp->buffer[7 * fbp->width + idx] = 0x5A;
+        if (ub.region || ub.region_tx == 0 || ub.frame_tx <= ub.region_tx ||
+            st.urgent != 1 || st.errors != 0 || !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: urgent: region in transaction %u, frame done in %u\n",
+                    ub.region_tx, ub.frame_tx);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x64 %-26s %8u of %u transactions\n",
+                "urgent region", ub.region_tx, ub.frame_tx);
+    } while (0);
+    if (region)
+        ssd1306_framebuffer_destroy(region);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+// an urgent region across a running ticker leaves its band alone and the
+// scroll running
+static int run_urgent_ticker(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_INIT | EMU_FIXTURE_FB) < 0 ||
+            ssd1306_i2c_display_update(fx.oled, fx.fbp) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_i2c_t *oled = fx.oled;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        ssd1306_i2c_ticker_t tk = { 0 };
+        tk.page_start = 2;
+        tk.page_end = 3;
+        tk.interval = 7;
+        ssd1306_i2c_async_stats_t st = { 0 };
+        if (ssd1306_i2c_ticker_start(oled, &tk, fbp) < 0 || ssd1306_i2c_async_start(oled) < 0) {
+            rc = -1;
+            break;
+        }
+        memset(fbp->buffer, 0x33, fbp->len);
+        // pages 1 to 4
+        if (ssd1306_i2c_async_present_region(oled, fbp, 0, 8, 16, 32, 1) < 0 ||
+            wait_flushed(oled, 1, &st) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_async_stop(oled);
+        if (emu->gddram[1][0] != 0x33 || emu->gddram[4][15] != 0x33 ||
+            emu->gddram[2][0] != 0 || emu->gddram[3][15] != 0 || emu->gddram[1][16] != 0 ||
+            !emu->scroll_active || emu->scroll_cmd != 0x27 || emu->scroll_start_page != 2) {
+            fprintf(stderr, "ERROR: urgent: ticker band 0x%02x, region 0x%02x, scrolling %d\n",
+                    emu->gddram[2][0], emu->gddram[1][0], emu->scroll_active);
+            rc = -1;
+            break;
+        }
+        fprintf(stderr, "INFO: 128x64 %-26s %8s\n", "urgent region over ticker", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_urgent() < 0 || run_urgent_ticker() < 0) {
+        fprintf(stderr, "ERROR: urgent regions failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,178 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "emu_test.h"
+
+// puts oled in shadow mode and warm attaches it to path, counting the
+// traffic from there. returns what ssd1306_i2c_warm_attach() returned
+static int attach_warm(ssd1306_emu_t *emu, ssd1306_i2c_t *oled, const char *path)
+{
+    ssd1306_emu_reset_stats(emu);
+    if (ssd1306_i2c_shadow_enable(oled, true) < 0)
+        return -1;
+    return ssd1306_i2c_warm_attach(oled, path);
+}
+
+// opens another display object on the fixture's panel, as a restarted
+// process would, and warm attaches it
+static int open_warm(emu_fixture_t *fx, const char *path, uint8_t height,
+        ssd1306_i2c_t **oledp)
+{
+    *oledp = ssd1306_i2c_open_transport(&ssd1306_i2c_transport_emulator, fx->emu,
+                NULL, 0, 128, height, NULL);
+    if (!*oledp)
+        return -1;
+    ssd1306_err_set_level((*oledp)->err, SSD1306_LOGLEVEL_WARN);
+    return attach_warm(fx->emu, *oledp, path);
+}
+
+// restarts a display object on the same emulated panel through a temporary
+// state file. a clean restart only checks the display answers and then sends
+// partial updates, one after a process that did not save resets the display
+// state it cannot know, and a state file from another boot or display
+// initializes the display again
+static int run_warm(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    ssd1306_i2c_t *oled2 = NULL;
+    char path[] = "/tmp/ssd1306_warm_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    unlink(path);
+    do {
+        if (emu_fixture_open(&fx, 128, 64, NULL, EMU_FIXTURE_FB) < 0 ||
+            attach_warm(fx.emu, fx.oled, path) != 0) {
+            fprintf(stderr, "ERROR: warm start: first attach did not initialize\n");
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        for (size_t idx = 0; idx < fbp->len; ++idx)
+            fbp->buffer[idx] = (uint8_t)idx;
+        if (ssd1306_i2c_display_update(fx.oled, fbp) < 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_close(fx.oled); // saves the state
+        fx.oled = NULL;
+        // the restart sends a NOP and the next update only the changed page
+        rc = open_warm(&fx, path, 64, &fx.oled);
+        uint64_t attach_bytes = emu->stats.bytes;
+        fbp->buffer[0] ^= 0xFF;
+        ssd1306_emu_reset_stats(emu);
+        if (rc != 1 || attach_bytes != 2 || ssd1306_i2c_display_update(fx.oled, fbp) < 0 ||
+            emu->stats.data_bytes > 128 || !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: warm start: attach returned %d after %" PRIu64
+                    " bytes, update sent %" PRIu64 " bytes\n", rc, attach_bytes,
+                    emu->stats.data_bytes);
+            rc = -1;
+            break;
+        }
+        // the state is unknown until oled saves it, as if its process died,
+        // here in the middle of a blink with the panel dimmed
+        emu->inverted = true;
+        emu->entire_on = true;
+        emu->contrast = 0x10;
+        rc = open_warm(&fx, path, 64, &oled2);
+        attach_bytes = emu->stats.bytes;
+        ssd1306_emu_reset_stats(emu);
+        if (rc != 1 || attach_bytes <= 2 || emu->inverted || emu->entire_on ||
+            emu->contrast != 0xFF || !emu->display_on || ssd1306_i2c_display_update(oled2, fbp) < 0 ||
+            emu->stats.data_bytes != fbp->len || !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: warm start: unsaved state attach returned %d, update sent %"
+                    PRIu64 " bytes\n", rc, emu->stats.data_bytes);
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_close(oled2);
+        oled2 = NULL;
+        // the token hashes the boot id, so a different one stands for a state
+        // file left from before a reboot
+        FILE *fp = fopen(path, "r+");
+        if (!fp || fputs("token 0123456789abcdef", fp) < 0 || fclose(fp) != 0) {
+            rc = -1;
+            break;
+        }
+        rc = open_warm(&fx, path, 64, &oled2);
+        if (rc != 0 || emu->display_on != true || emu->stats.cmd_bytes < 20) {
+            fprintf(stderr, "ERROR: warm start: attach with another boot's state returned %d\n",
+                    rc);
+            rc = -1;
+            break;
+        }
+        rc = 0;
+        fprintf(stderr, "INFO: 128x64 %-26s %8s\n", "warm start", "ok");
+    } while (0);
+    if (oled2)
+        ssd1306_i2c_close(oled2);
+    emu_fixture_close(&fx);
+    unlink(path);
+    return rc;
+}
+
+// a display closed while showing the second flip slot of a 128x32 panel
+// has the start line at row 32. the restarted process must not trust the
+// saved registers, or its frames go into RAM the panel does not show
+static int run_warm_flip(void)
+{
+    int rc = 0;
+    emu_fixture_t fx = { 0 };
+    char path[] = "/tmp/ssd1306_warm_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return -1;
+    close(fd);
+    unlink(path);
+    do {
+        if (emu_fixture_open(&fx, 128, 32, NULL, EMU_FIXTURE_FB) < 0 ||
+            attach_warm(fx.emu, fx.oled, path) != 0) {
+            rc = -1;
+            break;
+        }
+        ssd1306_emu_t *emu = fx.emu;
+        ssd1306_framebuffer_t *fbp = fx.fbp;
+        draw_frame(fbp, 0);
+        if (ssd1306_i2c_flip_enable(fx.oled, true) < 0 ||
+            ssd1306_i2c_flip_load(fx.oled, fbp, 1) < 0 ||
+            ssd1306_i2c_flip_show(fx.oled, 1) < 0 || emu->start_line != 32) {
+            fprintf(stderr, "ERROR: warm start: slot 1 not shown before the restart\n");
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_close(fx.oled); // saves the state
+        fx.oled = NULL;
+        rc = open_warm(&fx, path, 32, &fx.oled);
+        memset(fbp->buffer, 0xFF, fbp->len);
+        if (rc != 1 || ssd1306_i2c_display_update(fx.oled, fbp) < 0 ||
+            emu->start_line != 0 || ssd1306_emu_get_pixel(emu, 0, 0) != 1 ||
+            !ssd1306_emu_matches(emu, fbp)) {
+            fprintf(stderr, "ERROR: warm start: attach after flipping returned %d with"
+                    " start line %u\n", rc, emu->start_line);
+            rc = -1;
+            break;
+        }
+        rc = 0;
+        fprintf(stderr, "INFO: 128x32 %-26s %8s\n", "warm start after flipping", "ok");
+    } while (0);
+    emu_fixture_close(&fx);
+    unlink(path);
+    return rc;
+}
+
+int main()
+{
+    int rc = 0;
+    fprintf(stderr, "DEBUG: Using library version: %s\n", ssd1306_i2c_version());
+    if (run_warm() < 0 || run_warm_flip() < 0) {
+        fprintf(stderr, "ERROR: warm start failed\n");
+        rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,372 @@
+#ifndef _INCLUDE_SSD_____CONFIG_H
+#define _INCLUDE_SSD_____CONFIG_H 1
+ 
+/* include/ssd1306_config.h. Generated automatically at end of configure. */
+/* include/_ssd1306_config.h.  Generated from _ssd1306_config.h.in by configure.  */
+/* include/_ssd1306_config.h.in.  Generated from configure.ac by autoheader.  */
+
+/* Debug Mode */
+/* #undef DEBUG */
+
+/* Define to 1 if you have the `calloc' function. */
+#ifndef LIBSSD1306_HAVE_CALLOC
+#define LIBSSD1306_HAVE_CALLOC 1
+#endif
+
+/* Define to 1 if you have the <ctype.h> header file. */
+#ifndef LIBSSD1306_HAVE_CTYPE_H
+#define LIBSSD1306_HAVE_CTYPE_H 1
+#endif
+
+/* Define to 1 if you have the declaration of `strerror_r', and to 0 if you
+   don't. */
+#ifndef LIBSSD1306_HAVE_DECL_STRERROR_R
+#define LIBSSD1306_HAVE_DECL_STRERROR_R 1
+#endif
+
+/* Define to 1 if you have the <dirent.h> header file. */
+#ifndef LIBSSD1306_HAVE_DIRENT_H
+#define LIBSSD1306_HAVE_DIRENT_H 1
+#endif
+
+/* Define to 1 if you have the <dlfcn.h> header file. */
+#ifndef LIBSSD1306_HAVE_DLFCN_H
+#define LIBSSD1306_HAVE_DLFCN_H 1
+#endif
+
+/* Define to 1 if you have the <errno.h> header file. */
+#ifndef LIBSSD1306_HAVE_ERRNO_H
+#define LIBSSD1306_HAVE_ERRNO_H 1
+#endif
+
+/* Have libev.h */
+/* #undef HAVE_EV_H */
+
+/* Define to 1 if you have the <fcntl.h> header file. */
+#ifndef LIBSSD1306_HAVE_FCNTL_H
+#define LIBSSD1306_HAVE_FCNTL_H 1
+#endif
+
+/* Define to 1 if you have the <features.h> header file. */
+#ifndef LIBSSD1306_HAVE_FEATURES_H
+#define LIBSSD1306_HAVE_FEATURES_H 1
+#endif
+
+/* Use Freetype2 */
+#ifndef LIBSSD1306_HAVE_FREETYPE2
+#define LIBSSD1306_HAVE_FREETYPE2 1
+#endif
+
+/* Define to 1 if you have the <i2c/smbus.h> header file. */
+/* #undef HAVE_I2C_SMBUS_H */
+
+/* Define to 1 if the system has the type `intptr_t'. */
+#ifndef LIBSSD1306_HAVE_INTPTR_T
+#define LIBSSD1306_HAVE_INTPTR_T 1
+#endif
+
+/* Define to 1 if you have the <inttypes.h> header file. */
+#ifndef LIBSSD1306_HAVE_INTTYPES_H
+#define LIBSSD1306_HAVE_INTTYPES_H 1
+#endif
+
+/* Define to 1 if you have the `ioctl' function. */
+#ifndef LIBSSD1306_HAVE_IOCTL
+#define LIBSSD1306_HAVE_IOCTL 1
+#endif
+
+/* Have libi2c */
+/* #undef HAVE_LIBI2C */
+
+/* Define to 1 if you have the <linux/i2c-dev.h> header file. */
+#ifndef LIBSSD1306_HAVE_LINUX_I2C_DEV_H
+#define LIBSSD1306_HAVE_LINUX_I2C_DEV_H 1
+#endif
+
+/* Define to 1 if you have the <linux/i2c.h> header file. */
+#ifndef LIBSSD1306_HAVE_LINUX_I2C_H
+#define LIBSSD1306_HAVE_LINUX_I2C_H 1
+#endif
+
+/* Define to 1 if you have the <linux/io_uring.h> header file. */
+#ifndef LIBSSD1306_HAVE_LINUX_IO_URING_H
+#define LIBSSD1306_HAVE_LINUX_IO_URING_H 1
+#endif
+
+/* Define to 1 if you have the `localtime_r' function. */
+#ifndef LIBSSD1306_HAVE_LOCALTIME_R
+#define LIBSSD1306_HAVE_LOCALTIME_R 1
+#endif
+
+/* Define to 1 if you have the <math.h> header file. */
+#ifndef LIBSSD1306_HAVE_MATH_H
+#define LIBSSD1306_HAVE_MATH_H 1
+#endif
+
+/* Define to 1 if you have the `memcpy' function. */
+#ifndef LIBSSD1306_HAVE_MEMCPY
+#define LIBSSD1306_HAVE_MEMCPY 1
+#endif
+
+/* Define to 1 if you have the `memset' function. */
+#ifndef LIBSSD1306_HAVE_MEMSET
+#define LIBSSD1306_HAVE_MEMSET 1
+#endif
+
+/* Undefine this to disable threading support */
+#ifndef LIBSSD1306_HAVE_PTHREAD
+#define LIBSSD1306_HAVE_PTHREAD 1
+#endif
+
+/* Have PTHREAD_PRIO_INHERIT. */
+#ifndef LIBSSD1306_HAVE_PTHREAD_PRIO_INHERIT
+#define LIBSSD1306_HAVE_PTHREAD_PRIO_INHERIT 1
+#endif
+
+/* Define to 1 if you have the <sched.h> header file. */
+#ifndef LIBSSD1306_HAVE_SCHED_H
+#define LIBSSD1306_HAVE_SCHED_H 1
+#endif
+
+/* Define to 1 if stdbool.h conforms to C99. */
+#ifndef LIBSSD1306_HAVE_STDBOOL_H
+#define LIBSSD1306_HAVE_STDBOOL_H 1
+#endif
+
+/* Define to 1 if you have the <stdint.h> header file. */
+#ifndef LIBSSD1306_HAVE_STDINT_H
+#define LIBSSD1306_HAVE_STDINT_H 1
+#endif
+
+/* Define to 1 if you have the <stdio.h> header file. */
+#ifndef LIBSSD1306_HAVE_STDIO_H
+#define LIBSSD1306_HAVE_STDIO_H 1
+#endif
+
+/* Define to 1 if you have the <stdlib.h> header file. */
+#ifndef LIBSSD1306_HAVE_STDLIB_H
+#define LIBSSD1306_HAVE_STDLIB_H 1
+#endif
+
+/* Define to 1 if you have the `strdup' function. */
+#ifndef LIBSSD1306_HAVE_STRDUP
+#define LIBSSD1306_HAVE_STRDUP 1
+#endif
+
+/* Define if you have `strerror_r'. */
+#ifndef LIBSSD1306_HAVE_STRERROR_R
+#define LIBSSD1306_HAVE_STRERROR_R 1
+#endif
+
+/* Define to 1 if you have the <strings.h> header file. */
+#ifndef LIBSSD1306_HAVE_STRINGS_H
+#define LIBSSD1306_HAVE_STRINGS_H 1
+#endif
+
+/* Define to 1 if you have the <string.h> header file. */
+#ifndef LIBSSD1306_HAVE_STRING_H
+#define LIBSSD1306_HAVE_STRING_H 1
+#endif
+
+/* Define to 1 if you have the <sys/eventfd.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_EVENTFD_H
+#define LIBSSD1306_HAVE_SYS_EVENTFD_H 1
+#endif
+
+/* Define to 1 if you have the <sys/file.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_FILE_H
+#define LIBSSD1306_HAVE_SYS_FILE_H 1
+#endif
+
+/* Define to 1 if you have the <sys/ioctl.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_IOCTL_H
+#define LIBSSD1306_HAVE_SYS_IOCTL_H 1
+#endif
+
+/* Define to 1 if you have the <sys/mman.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_MMAN_H
+#define LIBSSD1306_HAVE_SYS_MMAN_H 1
+#endif
+
+/* Define to 1 if you have the <sys/stat.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_STAT_H
+#define LIBSSD1306_HAVE_SYS_STAT_H 1
+#endif
+
+/* Define to 1 if you have the <sys/syscall.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_SYSCALL_H
+#define LIBSSD1306_HAVE_SYS_SYSCALL_H 1
+#endif
+
+/* Define to 1 if you have the <sys/time.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_TIME_H
+#define LIBSSD1306_HAVE_SYS_TIME_H 1
+#endif
+
+/* Define to 1 if you have the <sys/types.h> header file. */
+#ifndef LIBSSD1306_HAVE_SYS_TYPES_H
+#define LIBSSD1306_HAVE_SYS_TYPES_H 1
+#endif
+
+/* Define to 1 if you have <sys/wait.h> that is POSIX.1 compatible. */
+#ifndef LIBSSD1306_HAVE_SYS_WAIT_H
+#define LIBSSD1306_HAVE_SYS_WAIT_H 1
+#endif
+
+/* Define to 1 if the system has the type `uintptr_t'. */
+#ifndef LIBSSD1306_HAVE_UINTPTR_T
+#define LIBSSD1306_HAVE_UINTPTR_T 1
+#endif
+
+/* Define to 1 if you have the <unistd.h> header file. */
+#ifndef LIBSSD1306_HAVE_UNISTD_H
+#define LIBSSD1306_HAVE_UNISTD_H 1
+#endif
+
+/* Have libunistring.h */
+/* #undef HAVE_UNISTR_H */
+
+/* Define to 1 if the system has the type `_Bool'. */
+#ifndef LIBSSD1306_HAVE__BOOL
+#define LIBSSD1306_HAVE__BOOL 1
+#endif
+
+/* Define to the sub-directory where libtool stores uninstalled libraries. */
+#ifndef LIBSSD1306_LT_OBJDIR
+#define LIBSSD1306_LT_OBJDIR ".libs/"
+#endif
+
+/* No Debug Mode */
+#ifndef LIBSSD1306_NDEBUG
+#define LIBSSD1306_NDEBUG /**/
+#endif
+
+/* Name of package */
+#ifndef LIBSSD1306_PACKAGE
+#define LIBSSD1306_PACKAGE "libssd1306"
+#endif
+
+/* Define to the address where bug reports for this package should be sent. */
+#ifndef LIBSSD1306_PACKAGE_BUGREPORT
+#define LIBSSD1306_PACKAGE_BUGREPORT "github@stealthylabs.com"
+#endif
+
+/* Define to the full name of this package. */
+#ifndef LIBSSD1306_PACKAGE_NAME
+#define LIBSSD1306_PACKAGE_NAME "libssd1306"
+#endif
+
+/* Define to the full name and version of this package. */
+#ifndef LIBSSD1306_PACKAGE_STRING
+#define LIBSSD1306_PACKAGE_STRING "libssd1306 0.8"
+#endif
+
+/* Define to the one symbol short name of this package. */
+#ifndef LIBSSD1306_PACKAGE_TARNAME
+#define LIBSSD1306_PACKAGE_TARNAME "libssd1306"
+#endif
+
+/* Define to the home page for this package. */
+#ifndef LIBSSD1306_PACKAGE_URL
+#define LIBSSD1306_PACKAGE_URL ""
+#endif
+
+/* Define to the version of this package. */
+#ifndef LIBSSD1306_PACKAGE_VERSION
+#define LIBSSD1306_PACKAGE_VERSION "0.8"
+#endif
+
+/* Define to necessary symbol if this constant uses a non-standard name on
+   your system. */
+/* #undef PTHREAD_CREATE_JOINABLE */
+
+/* Define to 1 if all of the C90 standard headers exist (not just the ones
+   required in a freestanding environment). This macro is provided for
+   backward compatibility; new code need not use it. */
+#ifndef LIBSSD1306_STDC_HEADERS
+#define LIBSSD1306_STDC_HEADERS 1
+#endif
+
+/* Define to 1 if strerror_r returns char *. */
+/* #undef STRERROR_R_CHAR_P */
+
+/* Define to 1 if you can safely include both <sys/time.h> and <time.h>. This
+   macro is obsolete. */
+#ifndef LIBSSD1306_TIME_WITH_SYS_TIME
+#define LIBSSD1306_TIME_WITH_SYS_TIME 1
+#endif
+
+/* Version number of package */
+#ifndef LIBSSD1306_VERSION
+#define LIBSSD1306_VERSION "0.8"
+#endif
+
+/* Define for Solaris 2.5.1 so the uint32_t typedef from <sys/synch.h>,
+   <pthread.h>, or <semaphore.h> is not used. If the typedef were allowed, the
+   #define below would cause a syntax error. */
+/* #undef _UINT32_T */
+
+/* Define for Solaris 2.5.1 so the uint64_t typedef from <sys/synch.h>,
+   <pthread.h>, or <semaphore.h> is not used. If the typedef were allowed, the
+   #define below would cause a syntax error. */
+/* #undef _UINT64_T */
+
+/* Define for Solaris 2.5.1 so the uint8_t typedef from <sys/synch.h>,
+   <pthread.h>, or <semaphore.h> is not used. If the typedef were allowed, the
+   #define below would cause a syntax error. */
+/* #undef _UINT8_T */
+
+/* Define to `__inline__' or `__inline' if that's what the C compiler
+   calls it, or to nothing if 'inline' is not supported under any name.  */
+#ifndef __cplusplus
+/* #undef inline */
+#endif
+
+/* Define to the type of a signed integer type of width exactly 16 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef int16_t */
+
+/* Define to the type of a signed integer type of width exactly 32 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef int32_t */
+
+/* Define to the type of a signed integer type of width exactly 64 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef int64_t */
+
+/* Define to the type of a signed integer type of width exactly 8 bits if such
+   a type exists and the standard includes do not define it. */
+/* #undef int8_t */
+
+/* Define to the type of a signed integer type wide enough to hold a pointer,
+   if such a type exists, and if the system does not define it. */
+/* #undef intptr_t */
+
+/* Define to `unsigned int' if <sys/types.h> does not define. */
+/* #undef size_t */
+
+/* Define to `int' if <sys/types.h> does not define. */
+/* #undef ssize_t */
+
+/* Define to the type of an unsigned integer type of width exactly 16 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef uint16_t */
+
+/* Define to the type of an unsigned integer type of width exactly 32 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef uint32_t */
+
+/* Define to the type of an unsigned integer type of width exactly 64 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef uint64_t */
+
+/* Define to the type of an unsigned integer type of width exactly 8 bits if
+   such a type exists and the standard includes do not define it. */
+/* #undef uint8_t */
+
+/* Define to the type of an unsigned integer type wide enough to hold a
+   pointer, if such a type exists, and if the system does not define it. */
+/* #undef uintptr_t */
+ 
+/* once: _INCLUDE_SSD_____CONFIG_H */
+#endif
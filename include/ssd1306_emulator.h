@@ -0,0 +1,116 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#ifndef __LIB_SSD1306_EMULATOR_H__
+#define __LIB_SSD1306_EMULATOR_H__
+
+#include <ssd1306_config.h>
+#include <ssd1306_graphics.h>
+#include <ssd1306_i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// software model of the SSD1306 controller. it decodes the I2C byte stream
+// the library sends, control bytes included, and keeps the 128x64 GDDRAM and
+// the registers the commands set. use it to test and benchmark the library
+// without a display attached.
+#define SSD1306_EMU_COLUMNS 128
+#define SSD1306_EMU_PAGES 8
+#define SSD1306_EMU_ROWS (SSD1306_EMU_PAGES * 8)
+
+typedef struct {
+    uint64_t transactions; // I2C transactions received
+    uint64_t cmd_xfers; // transactions starting with a command control byte
+    uint64_t data_xfers; // transactions starting with a data control byte
+    uint64_t bytes; // all bytes received including control bytes
+    uint64_t control_bytes; // control bytes received
+    uint64_t cmd_bytes; // command and command argument bytes
+    uint64_t data_bytes; // bytes written to GDDRAM
+    uint64_t commands; // complete commands decoded
+    uint64_t unknown_cmds; // command bytes that are not supported
+    uint64_t scroll_steps; // steps applied by ssd1306_emu_scroll_step()
+} ssd1306_emu_stats_t;
+
+typedef struct {
+    uint8_t gddram[SSD1306_EMU_PAGES][SSD1306_EMU_COLUMNS]; // page major like the framebuffer
+    // addressing
+    uint8_t mem_mode; // 0 horizontal, 1 vertical, 2 page (reset)
+    uint8_t col_start; // column window set by 0x21
+    uint8_t col_end;
+    uint8_t page_start; // page window set by 0x22
+    uint8_t page_end;
+    uint8_t page_col_start; // page mode start column set by 0x00-0x1F
+    uint8_t col; // GDDRAM pointer
+    uint8_t page;
+    // layout and hardware configuration
+    uint8_t start_line;
+    uint8_t disp_offset;
+    uint8_t contrast;
+    uint8_t mux_ratio; // number of rows - 1
+    uint8_t com_pins;
+    uint8_t clock_divfreq;
+    uint8_t precharge;
+    uint8_t vcomh;
+    bool seg_remap;
+    bool com_invert;
+    bool inverted;
+    bool entire_on;
+    bool display_on;
+    bool charge_pump;
+    uint8_t dcdc; // SH1106 DC-DC setting sent with 0xAD
+    // scrolling
+    bool scroll_active;
+    uint8_t scroll_cmd; // last scroll setup command 0x26, 0x27, 0x29 or 0x2a. 0 if none
+    uint8_t scroll_start_page;
+    uint8_t scroll_end_page;
+    uint8_t scroll_interval; // frame interval code, not modelled in time
+    uint8_t scroll_voffset; // rows per step for vertical scrolling
+    uint8_t vscroll_top; // fixed rows above the vertical scroll area
+    uint8_t vscroll_rows; // rows in the vertical scroll area
+    uint8_t vscroll_pos; // current vertical scroll position within the area
+    // command parser state. commands and arguments may span control bytes
+    uint8_t cmd[8];
+    size_t cmd_len;
+    size_t cmd_need;
+    ssd1306_emu_stats_t stats;
+} ssd1306_emu_t;
+
+// returns a new emulator in the power-on reset state or NULL on error
+ssd1306_emu_t *ssd1306_emu_create(void);
+void ssd1306_emu_destroy(ssd1306_emu_t *emu);
+// reset the registers and clear GDDRAM. the counters are kept
+void ssd1306_emu_reset(ssd1306_emu_t *emu);
+void ssd1306_emu_reset_stats(ssd1306_emu_t *emu);
+
+// consumes one I2C transaction: control byte(s) followed by command or data
+// bytes, exactly as written to the bus. returns 0 on success, -1 on error
+int ssd1306_emu_write(ssd1306_emu_t *emu, const uint8_t *buf, size_t len);
+
+// moves an active scroll by the given number of steps. horizontal scrolling
+// rotates the GDDRAM columns of the scrolled pages like the controller does,
+// vertical scrolling moves the view within the vertical scroll area.
+void ssd1306_emu_scroll_step(ssd1306_emu_t *emu, unsigned int steps);
+
+// returns the pixel visible at panel position (x, y) after applying display
+// on/off, entire on, inversion, segment remap, COM scan direction, start line,
+// display offset and vertical scrolling. returns 1 for on, 0 for off
+int ssd1306_emu_get_pixel(const ssd1306_emu_t *emu, uint8_t x, uint8_t y);
+
+// true if GDDRAM holds the framebuffer contents in its top left corner
+bool ssd1306_emu_matches(const ssd1306_emu_t *emu, const ssd1306_framebuffer_t *fbp);
+
+// transport backend that feeds the emulator. ctx is the ssd1306_emu_t to use,
+// for example ssd1306_i2c_open_transport(&ssd1306_i2c_transport_emulator,
+// emu, NULL, 0, 128, 64, NULL)
+extern const ssd1306_i2c_transport_t ssd1306_i2c_transport_emulator;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif /* __LIB_SSD1306_EMULATOR_H__ */
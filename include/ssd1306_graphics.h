@@ -41,22 +41,79 @@ extern "C" {
 #define SSD1306_ATOMIC_DECREMENT(A) __atomic_sub_fetch((A), 1, __ATOMIC_SEQ_CST)
 #define SSD1306_ATOMIC_ZERO(A) __atomic_clear((A), __ATOMIC_SEQ_CST)
 #define SSD1306_ATOMIC_SET(A,B) __atomic_store_n((A),(B), __ATOMIC_SEQ_CST)
+#define SSD1306_ATOMIC_LOAD(A) __atomic_load_n((A), __ATOMIC_SEQ_CST)
+#define SSD1306_ATOMIC_EXCHANGE(A,B) __atomic_exchange_n((A),(B), __ATOMIC_SEQ_CST)
 #define SSD1306_ATOMIC_IS_EQUAL(A,B) __atomic_compare_exchange_n((A),(B),*(A),1,__ATOMIC_SEQ_CST,__ATOMIC_SEQ_CST)
 
 const char *ssd1306_fb_version(void);
 
+typedef enum {
+    SSD1306_LOGLEVEL_ERROR = 0,
+    SSD1306_LOGLEVEL_WARN = 1,
+    SSD1306_LOGLEVEL_INFO = 2, // default
+    SSD1306_LOGLEVEL_DEBUG = 3
+} ssd1306_loglevel_t;
+
+// receives a formatted message without the level prefix and the newline
+typedef void (*ssd1306_log_cb_t)(ssd1306_loglevel_t level, const char *msg, void *cbdata);
+
 typedef struct {
     int errnum; // store the errno here
     char *errbuf; // error string buffer, allocated on the heap
     size_t errlen; // size of the error string buffer
     FILE *err_fp; // err file pointer for messages. default is stderr
     volatile int _ref; // reference counted
+    ssd1306_loglevel_t level; // messages above this level are not formatted
+    ssd1306_log_cb_t log_cb; // if set, messages go here instead of err_fp
+    void *log_cbdata; // user data passed to log_cb
 } ssd1306_err_t;
 
 ssd1306_err_t *ssd1306_err_create(FILE *fp); // if fp is NULL, stderr is used
 void ssd1306_err_destroy(ssd1306_err_t *err);
 #define SSD1306_ERR_REF_INC(A) if ((A) != NULL) SSD1306_ATOMIC_INCREMENT(&((A)->_ref))
 
+// runtime log threshold. all objects sharing the err object are affected
+void ssd1306_err_set_level(ssd1306_err_t *err, ssd1306_loglevel_t level);
+// set cb to NULL to log to err_fp again
+void ssd1306_err_set_log_callback(ssd1306_err_t *err, ssd1306_log_cb_t cb, void *cbdata);
+// formats and emits a message. use the SSD1306_LOG_* macros instead, they
+// skip the formatting when the level is disabled
+void ssd1306_err_log(const ssd1306_err_t *err, ssd1306_loglevel_t level,
+                const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+// drops everything but errors logged from the calling thread, and sends
+// those to the log callback only, never to err_fp. used by the realtime flush
+// thread to keep stdio off its path
+void ssd1306_err_set_thread_quiet(bool quiet);
+
+// messages above this level are compiled out of the library. release builds
+// keep errors and warnings only.
+#ifndef SSD1306_LOG_COMPILED_LEVEL
+    #ifdef LIBSSD1306_NDEBUG
+        #define SSD1306_LOG_COMPILED_LEVEL 1 // SSD1306_LOGLEVEL_WARN
+    #else
+        #define SSD1306_LOG_COMPILED_LEVEL 3 // SSD1306_LOGLEVEL_DEBUG
+    #endif
+#endif
+#define SSD1306_LOG_ENABLED(E,L) \
+    ((int)(L) <= SSD1306_LOG_COMPILED_LEVEL && \
+     (int)(L) <= (int)(((E) != NULL) ? (E)->level : SSD1306_LOGLEVEL_INFO))
+#define SSD1306_LOG(E,L,...) do { \
+    if (SSD1306_LOG_ENABLED((E),(L))) \
+        ssd1306_err_log((E), (L), __VA_ARGS__); \
+} while (0)
+#define SSD1306_LOG_ERROR(E,...) SSD1306_LOG((E), SSD1306_LOGLEVEL_ERROR, __VA_ARGS__)
+#define SSD1306_LOG_WARN(E,...) SSD1306_LOG((E), SSD1306_LOGLEVEL_WARN, __VA_ARGS__)
+#if SSD1306_LOG_COMPILED_LEVEL >= 2
+    #define SSD1306_LOG_INFO(E,...) SSD1306_LOG((E), SSD1306_LOGLEVEL_INFO, __VA_ARGS__)
+#else
+    #define SSD1306_LOG_INFO(E,...) do {} while (0)
+#endif
+#if SSD1306_LOG_COMPILED_LEVEL >= 3
+    #define SSD1306_LOG_DEBUG(E,...) SSD1306_LOG((E), SSD1306_LOGLEVEL_DEBUG, __VA_ARGS__)
+#else
+    #define SSD1306_LOG_DEBUG(E,...) do {} while (0)
+#endif
+
 typedef struct ssd1306_font_ ssd1306_font_t;
 
 typedef enum { // the paths shown here are on Debian-based systems
@@ -82,6 +139,7 @@ typedef struct {
     size_t len; // length of the buffer
     ssd1306_err_t *err; // pointer to an optional error object
     ssd1306_font_t *font; // pointer to an opaque font library implementation - default is freetype
+    size_t prefix_len; // bytes reserved in front of buffer in the same allocation
 } ssd1306_framebuffer_t;
 
 // ssd1306 has 1:1 correspondence between pixel to bit
@@ -91,6 +149,16 @@ ssd1306_framebuffer_t *ssd1306_framebuffer_create(
                 ssd1306_err_t *err // err object to be re-used. increments errstr_ref
             );
 
+// same as ssd1306_framebuffer_create() but reserves prefix_len bytes in the
+// same allocation right in front of the buffer pointer. a transport can then
+// put its header bytes there and send the framebuffer without copying it.
+ssd1306_framebuffer_t *ssd1306_framebuffer_create_prefixed(
+                uint8_t width, // width of the screen in pixels
+                uint8_t height, // height of the screen in pixels
+                size_t prefix_len, // number of bytes to reserve before the buffer
+                ssd1306_err_t *err // err object to be re-used. increments errstr_ref
+            );
+
 void ssd1306_framebuffer_destroy(ssd1306_framebuffer_t *fbp);
 
 // clear the contents of the framebuffer
@@ -16,16 +16,169 @@ extern "C" {
 
 const char *ssd1306_i2c_version(void);
 
+// maximum number of raw bytes a single command encodes to
+#define SSD1306_I2C_CMD_BYTES_MAX 8
+// maximum size of a command batch including the leading control byte
+#define SSD1306_I2C_CMD_BATCH_MAX 64
+// largest chunk an SMBus I2C block write can carry
+#define SSD1306_I2C_SMBUS_BLOCK_MAX 32
+// default fixed cost of an I2C transaction (syscall, START, address, STOP)
+// expressed in bytes on the bus
+#define SSD1306_I2C_XFER_OVERHEAD_DEFAULT 16
+
+typedef struct ssd1306_i2c_async_ ssd1306_i2c_async_t;
+typedef struct ssd1306_i2c_arbiter_ ssd1306_i2c_arbiter_t;
+typedef struct ssd1306_i2c_fx_ ssd1306_i2c_fx_t;
+typedef struct ssd1306_i2c_lock_ ssd1306_i2c_lock_t;
+typedef struct ssd1306_i2c_ ssd1306_i2c_t;
+
+// hardware scrolled band of pages. refer ssd1306_i2c_ticker_start()
+typedef struct {
+    uint8_t page_start; // first page of the band. 0-7
+    uint8_t page_end; // last page of the band. page_start to height/8 - 1
+    bool scroll_right; // scroll direction. false scrolls to the left
+    uint8_t interval; // frames per step. datasheet encoding 0-7:
+                      // 7: 2, 4: 3, 5: 4, 0: 5, 6: 25, 1: 64, 2: 128, 3: 256
+    ssd1306_fontface_t font; // font for ssd1306_i2c_ticker_set_text()
+    uint8_t font_size; // font size for ssd1306_i2c_ticker_set_text()
+} ssd1306_i2c_ticker_t;
+
+// one I2C transaction: a control byte followed by command or GDDRAM bytes
+typedef struct {
+    const uint8_t *buf; // buf[0] is the control byte, 0x00 for commands, 0x40 for data
+    size_t len; // length including the control byte
+} ssd1306_i2c_seg_t;
+
+// true if the transaction holds GDDRAM data. the D/C# bit of the control byte
+// tells, whatever the Co bit is
+#define SSD1306_I2C_SEG_IS_DATA(S) (((S)->buf[0] & 0x40) != 0)
+
+// transport capabilities
+#define SSD1306_I2C_TRANSPORT_CAP_MULTI 0x01 // xfer() sends several transactions in one submission
+#define SSD1306_I2C_TRANSPORT_CAP_SMBUS 0x02 // transactions limited to SSD1306_I2C_SMBUS_BLOCK_MAX
+#define SSD1306_I2C_TRANSPORT_CAP_FD    0x04 // oled->fd is the open bus device
+
+// transport backend. every byte the library sends to the display goes through
+// these functions. ctx is the pointer given to ssd1306_i2c_open_transport().
+// the write functions receive one complete transaction with the control byte
+// in buf[0] and return 0 on success and -1 on failure, setting oled->err.
 typedef struct {
-    int fd;
+    const char *name;
+    // optional. prepares the bus for oled->addr. dev is the name given at open.
+    int (*open)(ssd1306_i2c_t *oled, void *ctx, const char *dev);
+    int (*write_cmds)(ssd1306_i2c_t *oled, void *ctx, const uint8_t *buf, size_t len);
+    int (*write_data)(ssd1306_i2c_t *oled, void *ctx, const uint8_t *buf, size_t len);
+    // optional. sends several transactions in order. if not set, the library
+    // calls write_cmds()/write_data() per transaction and applies chunk_size
+    // itself, otherwise chunk_size is left to xfer()
+    int (*xfer)(ssd1306_i2c_t *oled, void *ctx, const ssd1306_i2c_seg_t *segs, size_t nsegs);
+    // optional. releases what open() acquired
+    void (*close)(ssd1306_i2c_t *oled, void *ctx);
+    // optional. returns SSD1306_I2C_TRANSPORT_CAP_* flags. called after open()
+    uint32_t (*capabilities)(const ssd1306_i2c_t *oled, void *ctx);
+} ssd1306_i2c_transport_t;
+
+// Linux i2c-dev backend used by ssd1306_i2c_open(). ctx is unused
+extern const ssd1306_i2c_transport_t ssd1306_i2c_transport_i2cdev;
+
+// in-memory sink backend. ctx is a ssd1306_i2c_memsink_t owned by the caller
+// which counts the traffic and optionally keeps a copy of it.
+typedef struct {
+    uint8_t *buf; // optional. receives all transactions back to back
+    size_t buf_size; // capacity of buf. bytes beyond it are counted but not stored
+    size_t buf_len; // bytes stored in buf
+    uint64_t cmd_xfers; // command transactions
+    uint64_t data_xfers; // data transactions
+    uint64_t bytes; // total bytes including control bytes
+} ssd1306_i2c_memsink_t;
+extern const ssd1306_i2c_transport_t ssd1306_i2c_transport_memory;
+
+// user callback backend. ctx is a ssd1306_i2c_transport_cb_t owned by the
+// caller. cb gets every transaction and returns 0 on success or -1 on failure
+typedef struct {
+    int (*cb)(uint8_t addr, const uint8_t *buf, size_t len, void *cbdata);
+    void *cbdata;
+} ssd1306_i2c_transport_cb_t;
+extern const ssd1306_i2c_transport_t ssd1306_i2c_transport_callback;
+
+// last values written to the controller's registers, so commands that would
+// not change anything can be left out. refer ssd1306_i2c_regcache_enable()
+#define SSD1306_I2C_REGCACHE_SIZE 24
+// transfers with more segments than this go out unfiltered
+#define SSD1306_I2C_REGCACHE_SEGS_MAX 24
+typedef struct {
+    uint32_t valid; // bit per register holding a known value
+    uint8_t val[SSD1306_I2C_REGCACHE_SIZE][2]; // command byte or arguments
+    uint8_t col; // GDDRAM pointer position
+    uint8_t page;
+} ssd1306_i2c_regcache_t;
+
+// controller profile. what differs between the SSD1306 and its relatives:
+// the initialization values, the RAM geometry and how RAM is addressed.
+// refer ssd1306_i2c_set_profile()
+typedef struct {
+    const char *name;
+    uint8_t ram_columns; // columns of display RAM. 128, or 132 on the SH1106
+    uint8_t column_offset; // RAM column shown at the left edge of the panel
+    bool page_addressing_only; // no horizontal addressing or 0x21/0x22 windows.
+                               // updates are written one page at a time
+    bool hw_scroll; // has the 0x26-0x2F scroll commands
+    uint8_t clock_divfreq; // 0xD5 argument
+    uint8_t precharge; // 0xD9 argument
+    uint8_t vcomh; // 0xDB argument
+    bool charge_pump; // enable the 0x8D charge pump
+    uint8_t dcdc; // 0xAD argument on the SH1106. 0 to not send it
+} ssd1306_i2c_profile_t;
+extern const ssd1306_i2c_profile_t ssd1306_i2c_profile_ssd1306; // default
+extern const ssd1306_i2c_profile_t ssd1306_i2c_profile_ssd1309;
+extern const ssd1306_i2c_profile_t ssd1306_i2c_profile_sh1106;
+
+struct ssd1306_i2c_ {
+    int fd; // -1 unless the transport uses a file descriptor
     char *dev;      // device name. a copy is made.
     uint8_t addr;   // default 0x3c
     uint8_t width; // default 128
     uint8_t height;  // default 64
-    uint8_t *gddram_buffer; // buffer for GDDRAM size (height x width/8) + 1 bytes
+    // buffer for GDDRAM size (height x width/8) + 1 bytes. shown by
+    // ssd1306_i2c_display_update(oled, NULL) and used to stage framebuffers
+    // that have no control byte in front
+    uint8_t *gddram_buffer;
     size_t gddram_buffer_len; // value = (height x width / 8) + 1
     ssd1306_err_t *err; // for re-entrant error handling
-} ssd1306_i2c_t;
+    unsigned long funcs; // adapter functionality mask returned by I2C_FUNCS
+    size_t chunk_size; // max bytes per transaction after the control byte. 0 = no limit
+    uint8_t *chunk_buffer; // staging for chunked transfers
+    size_t chunk_buffer_len; // allocated bytes of chunk_buffer
+    uint8_t cmd_batch[SSD1306_I2C_CMD_BATCH_MAX]; // control byte + encoded commands of an open batch
+    size_t cmd_batch_len; // 0 when no batch is open
+    // copy of the panel's GDDRAM, preceded by the data control byte. only
+    // allocated in shadow mode, where full updates are sent from it
+    uint8_t *shadow_buffer;
+    uint8_t *xfer_buffer; // staging buffer for partial updates in shadow mode
+    bool shadow_valid; // true when shadow_buffer matches the panel
+    size_t shadow_xfer_overhead; // estimated fixed cost of one I2C transaction in bytes
+                                 // used to decide between partial and full updates
+    ssd1306_i2c_async_t *async; // flush thread state. NULL unless started
+    ssd1306_i2c_lock_t *lock; // serializes device access. NULL without threads
+    const ssd1306_i2c_transport_t *transport; // backend that writes to the device
+    void *transport_ctx; // backend data given at open
+    uint32_t transport_caps; // SSD1306_I2C_TRANSPORT_CAP_* flags of the backend
+    uint64_t tx_bytes; // bytes successfully handed to the transport
+    ssd1306_i2c_ticker_t ticker; // band scrolled by the controller
+    uint8_t *ticker_band; // ticker content of the band pages
+    bool ticker_active; // true while the controller scrolls the band
+    ssd1306_i2c_regcache_t regcache; // controller state as last written
+    bool regcache_enabled; // leave out commands that change nothing. default true
+    char *warm_file; // warm start state file. NULL unless attached
+    const ssd1306_i2c_profile_t *profile; // controller profile. default SSD1306
+    ssd1306_i2c_arbiter_t *arbiter; // bus arbitration. NULL unless enabled
+    bool flip_enabled; // updates go to a hidden GDDRAM slot which is then shown
+    uint8_t flip_front; // GDDRAM slot shown by the start line
+    bool console_active; // a text console owns the start line
+    FILE *capture; // byte stream capture file. NULL unless capturing
+    uint64_t capture_ns; // time of the last captured transaction
+    ssd1306_i2c_fx_t *fx; // hardware effects. NULL until one is started
+};
 
 ssd1306_i2c_t *ssd1306_i2c_open( // open the device for read/write
         const char *dev, // name of the device such as /dev/i2c-1. cannot be NULL
@@ -35,7 +188,19 @@ ssd1306_i2c_t *ssd1306_i2c_open( // open the device for read/write
         FILE *logerr // FILE* log ptr. use NULL or stderr for default
     );
 
-void ssd1306_i2c_close(ssd1306_i2c_t *oled); // free object and close fd
+// same as ssd1306_i2c_open() but writes through the given transport backend.
+// dev is passed to the transport's open() and may be NULL if it does not need it
+ssd1306_i2c_t *ssd1306_i2c_open_transport(
+        const ssd1306_i2c_transport_t *transport, // backend. cannot be NULL
+        void *ctx, // backend data. refer to the backend
+        const char *dev, // device name or NULL
+        uint8_t daddr, // same as ssd1306_i2c_open()
+        uint8_t width, // same as ssd1306_i2c_open()
+        uint8_t height, // same as ssd1306_i2c_open()
+        FILE *logerr // FILE* log ptr. use NULL or stderr for default
+    );
+
+void ssd1306_i2c_close(ssd1306_i2c_t *oled); // free object and close the transport
 
 typedef struct {
     char dev[128]; // valid device name /dev/i2c-[0-9] or /dev/i2c/[0-9] format
@@ -52,6 +217,26 @@ int ssd1306_i2c_search_addresses(
         size_t *num_devs, //number of devices returned
         FILE *logerr // FILE* log ptr. use NULL or stderr for default
     );
+
+#define SSD1306_I2C_SEARCH_MAX_BUSES 32
+#define SSD1306_I2C_SEARCH_THREADS_DEFAULT 4
+#define SSD1306_I2C_SEARCH_THREADS_MAX 16
+typedef struct {
+    bool ssd1306_only; // probe only 0x3c and 0x3d
+    size_t threads; // buses probed in parallel. 0 for the default, 1 for none
+    const char *cache_file; // optional. results are saved here and reused
+                            // until the system reboots or the adapters change.
+                            // remove the file to force a rescan
+} ssd1306_i2c_search_opts_t;
+
+// same as ssd1306_i2c_search_addresses() with options. opts may be NULL.
+// the buses are taken from /sys/bus/i2c/devices if available
+int ssd1306_i2c_search_addresses_ex(
+        ssd1306_i2c_dev_t **devs, // pointer to allocated object that user must free
+        size_t *num_devs, //number of devices returned
+        const ssd1306_i2c_search_opts_t *opts, // search options or NULL
+        FILE *logerr // FILE* log ptr. use NULL or stderr for default
+    );
 typedef enum {
     SSD1306_I2C_CMD_NOP, // no operation
     // power
@@ -93,7 +278,8 @@ typedef enum {
     SSD1306_I2C_CMD_SCROLL_RIGHT_HORIZONTAL, // perform right horizontal scroll
     SSD1306_I2C_CMD_SCROLL_VERTICAL_LEFT_HORIZONTAL, // perform vertical and left horizontal scroll
     SSD1306_I2C_CMD_SCROLL_VERTICAL_RIGHT_HORIZONTAL, // perform vertical and right horizontal scroll
-    SSD1306_I2C_CMD_SCROLL_VERTICAL_AREA // set vertical scroll area.
+    SSD1306_I2C_CMD_SCROLL_VERTICAL_AREA, // set vertical scroll area. does not activate the scroll
+    SSD1306_I2C_CMD_SH1106_DCDC // SH1106 DC-DC converter. data: 0x8B on, 0x8A off
 } ssd1306_i2c_cmd_t;
 
 int ssd1306_i2c_run_cmd(ssd1306_i2c_t *oled, // the ssd1306_i2c_t object
@@ -103,6 +289,24 @@ int ssd1306_i2c_run_cmd(ssd1306_i2c_t *oled, // the ssd1306_i2c_t object
                     // anything more than 6 will be ignored.
     );
 
+// command batching. all commands appended between begin and commit are encoded
+// into a single control stream (Co = 0) and sent to the device in one I2C
+// write when committed. if the batch fills up, the pending commands are sent
+// and the batch continues transparently. return 0 on success and -1 on failure
+int ssd1306_i2c_cmd_batch_begin(ssd1306_i2c_t *oled);
+int ssd1306_i2c_cmd_batch_append(ssd1306_i2c_t *oled, // the ssd1306_i2c_t object
+        ssd1306_i2c_cmd_t cmd, // command to append to the batch
+        uint8_t *data, // optional command data, same as ssd1306_i2c_run_cmd()
+        size_t dlen // length of the data bytes. max is 6.
+    );
+int ssd1306_i2c_cmd_batch_commit(ssd1306_i2c_t *oled);
+
+// selects the controller profile, for displays other than the SSD1306. call it
+// right after opening, before ssd1306_i2c_display_initialize(). with page
+// addressing only, every update is a write per page and in shadow mode
+// unchanged pages are skipped. returns 0 on success and -1 on failure
+int ssd1306_i2c_set_profile(ssd1306_i2c_t *oled, const ssd1306_i2c_profile_t *profile);
+
 // initialize the display before use
 int ssd1306_i2c_display_initialize(ssd1306_i2c_t *oled);
 // clear the display (calls ssd1306_i2c_display_update() internally)
@@ -111,6 +315,417 @@ int ssd1306_i2c_display_clear(ssd1306_i2c_t *oled);
 // this function can be called in an idle loop or on a timer or on-demand
 int ssd1306_i2c_display_update(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp);
 
+// page flipping. GDDRAM has 64 rows, so a 128x32 panel shows one of two
+// panel sized slots, picked with the display start line. with flipping
+// enabled, ssd1306_i2c_display_update() writes the frame into the hidden slot
+// and sets the start line in the same submission, so a frame never shows
+// half written. shadow mode partial updates are not used while flipping, and
+// the ticker, the console and preemptible flushes cannot be combined with it.
+// disabling it shows slot 0 until the next update.
+// ssd1306_i2c_flip_load() writes a framebuffer into a slot without showing it
+// and ssd1306_i2c_flip_show() shows a slot with one command, for example to
+// alternate between two preloaded blink states.
+// return 0 on success and -1 on failure
+int ssd1306_i2c_flip_enable(ssd1306_i2c_t *oled, bool enable);
+int ssd1306_i2c_flip_load(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp, uint8_t slot);
+int ssd1306_i2c_flip_show(ssd1306_i2c_t *oled, uint8_t slot);
+
+// vertical panning over a 64 row image held in GDDRAM. fbp must be as wide as
+// the display and 64 rows high. ssd1306_i2c_pan_set() shows the image from
+// the given row on, wrapping around at the bottom, with one command.
+// return 0 on success and -1 on failure
+int ssd1306_i2c_pan_load(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp);
+int ssd1306_i2c_pan_set(ssd1306_i2c_t *oled, uint8_t row);
+
+// limits every I2C transaction to chunk_size bytes after the control byte.
+// longer command and data streams are split and the control byte is repeated
+// in each chunk. ssd1306_i2c_open() picks SSD1306_I2C_SMBUS_BLOCK_MAX for
+// adapters that only support SMBus block writes and no limit otherwise. use
+// this for adapters with smaller transfer limits or to tune throughput.
+// sizes above a full frame are reduced to it. 0 removes the limit.
+// returns 0 on success and -1 on failure
+int ssd1306_i2c_set_chunk_size(ssd1306_i2c_t *oled, size_t chunk_size);
+
+// creates a framebuffer of the display's size with the I2C data control byte
+// reserved in front of the pixel buffer. ssd1306_i2c_display_update() writes
+// such framebuffers to the device straight from their memory without copying
+// them into gddram_buffer first. destroy it with ssd1306_framebuffer_destroy()
+ssd1306_framebuffer_t *ssd1306_i2c_framebuffer_create(ssd1306_i2c_t *oled);
+
+// shadow mode. when enabled, the object keeps a copy of what the panel's GDDRAM
+// holds and ssd1306_i2c_display_update() sends only the changed pages/columns,
+// each with its own address window. neighbouring changes are merged or a full
+// update is sent when that is estimated to be cheaper based on
+// shadow_xfer_overhead. the first update after enabling is always a full update.
+// returns 0 on success and -1 on failure
+int ssd1306_i2c_shadow_enable(ssd1306_i2c_t *oled, bool enable);
+// forces the next ssd1306_i2c_display_update() to be a full update. call this
+// if the panel lost power or its GDDRAM was modified behind the library's back.
+// the library calls this itself when scrolling is activated.
+void ssd1306_i2c_shadow_invalidate(ssd1306_i2c_t *oled);
+
+// register cache. the library remembers the values written to the display's
+// registers and the position of the GDDRAM pointer, and leaves out commands
+// that would not change them, such as the address window of a full update
+// right after another one, or re-applying the same contrast. it is enabled by
+// default and starts out empty. ssd1306_i2c_display_initialize() empties it.
+// call ssd1306_i2c_regcache_invalidate() after the panel lost power or was
+// written to behind the library's back so everything gets sent again.
+int ssd1306_i2c_regcache_enable(ssd1306_i2c_t *oled, bool enable);
+void ssd1306_i2c_regcache_invalidate(ssd1306_i2c_t *oled);
+
+// warm start. a service that restarts while the display stays powered does not
+// need to initialize and clear it again. ssd1306_i2c_warm_attach() looks for
+// the state a previous process saved in state_file, for example
+// /run/ssd1306-1-3c.state. if it belongs to this display and this boot the
+// initialization is skipped. the register cache is restored, and in shadow
+// mode (enable it first) so is the GDDRAM copy, so the first update is a
+// partial one. otherwise the display is initialized as usual.
+// the state is saved by ssd1306_i2c_warm_save() and ssd1306_i2c_close(). a
+// process that dies without saving leaves the state as unknown, and the next
+// warm start only resets scrolling, the start line, the addressing mode, the
+// contrast and inversion, and turns the display on.
+// returns 1 for a warm start, 0 if the display was initialized, -1 on error
+int ssd1306_i2c_warm_attach(ssd1306_i2c_t *oled, const char *state_file);
+int ssd1306_i2c_warm_save(ssd1306_i2c_t *oled);
+
+// byte stream capture and replay. while capturing, every transaction sent to
+// the display is appended to a compact binary file with its time, address and
+// whether it holds commands or data, after the register cache and before
+// chunking. ssd1306_i2c_replay() sends a capture through another display
+// object, for example one on the memory or emulator transport, so the traffic
+// of a production application can be measured and compared across library
+// versions without the application. transactions are replayed in the
+// submissions they were captured in and bypass the register cache. with
+// realtime the original timing is kept, otherwise they are sent back to back.
+// capturing is refused while a realtime flush thread runs, as the capture
+// file would be written from it.
+// return 0 on success and -1 on failure
+int ssd1306_i2c_capture_start(ssd1306_i2c_t *oled, const char *path);
+int ssd1306_i2c_capture_stop(ssd1306_i2c_t *oled); // also done by ssd1306_i2c_close()
+
+typedef struct {
+    uint64_t submissions; // calls to the transport, each a single syscall on i2c-dev
+                          // when it supports I2C_RDWR and no chunking is needed
+    uint64_t transactions;
+    uint64_t cmd_xfers;
+    uint64_t data_xfers;
+    uint64_t bytes; // including control bytes
+    uint64_t capture_ns; // time the captured traffic took
+    uint64_t elapsed_ns; // time the replay took
+} ssd1306_i2c_replay_stats_t;
+int ssd1306_i2c_replay(ssd1306_i2c_t *oled, const char *path, bool realtime,
+        ssd1306_i2c_replay_stats_t *stats);
+
+// asynchronous updates. ssd1306_i2c_async_start() creates a flush thread for
+// the device with three frame buffers. ssd1306_i2c_async_present() copies the
+// framebuffer into a free buffer, hands it to the thread and returns without
+// waiting for the bus. frames presented faster than the bus can send them are
+// coalesced and only the newest pending frame is sent. the buffer hand-off is
+// lock-free. present must only be called from one thread at a time.
+// other calls on the device remain valid and are serialized with the thread.
+// requires threading support. return 0 on success and -1 on failure
+int ssd1306_i2c_async_start(ssd1306_i2c_t *oled);
+int ssd1306_i2c_async_present(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp);
+// sends the last pending frame and stops the thread. called by ssd1306_i2c_close()
+void ssd1306_i2c_async_stop(ssd1306_i2c_t *oled);
+
+// realtime flush thread. same as ssd1306_i2c_async_start(), but the thread
+// gets its own scheduling policy and CPUs, so a loaded system does not
+// preempt it in the middle of a frame. with lock_memory, the frame buffers,
+// the device's buffers and the thread's stack are touched and locked with
+// mlock() before the first frame, so it does not page fault. enable shadow
+// mode and urgent regions before starting to have their buffers locked too.
+// the thread does not allocate or use stdio. its errors show in the stats
+// and completions and only reach the err object's log callback, if one is
+// set. a byte stream capture cannot run along with it. SCHED_FIFO and
+// SCHED_RR need CAP_SYS_NICE and locking memory may need a higher
+// RLIMIT_MEMLOCK. returns 0 on success and -1 if the thread could not be
+// started or a setting could not be applied, in which case no thread is left
+// running
+#define SSD1306_I2C_RT_STACK_PREFAULT (64 * 1024)
+typedef struct {
+    int policy; // SCHED_OTHER, SCHED_FIFO or SCHED_RR from <sched.h>
+    int priority; // 1-99 for SCHED_FIFO and SCHED_RR, 0 for SCHED_OTHER
+    uint64_t cpus; // bit per CPU the thread may run on. 0 for any
+    bool lock_memory;
+} ssd1306_i2c_realtime_t;
+int ssd1306_i2c_async_start_realtime(ssd1306_i2c_t *oled, const ssd1306_i2c_realtime_t *rt);
+
+// urgent regions. a preemptible flush thread sends frames one page at a time,
+// each page with its own address window, and sends queued regions between
+// two pages, highest priority first. the frame then carries on with its next
+// page, so nothing is sent twice, and its remaining pages get the region so
+// they do not undo it. enabling it enables shadow mode.
+// ssd1306_i2c_async_present_region() copies the rectangle of fbp in pixels,
+// rounded out to whole pages, and queues it ahead of frames. it makes the
+// thread preemptible if it is not yet, which only applies from the next
+// frame. a region still queued for the same rectangle is replaced. pages in
+// the band of a running ticker are left out. draw the region into later
+// frames as well.
+// return 0 on success and -1 on failure or if the queue is full
+#define SSD1306_I2C_ASYNC_URGENT_MAX 8
+int ssd1306_i2c_async_set_preemptible(ssd1306_i2c_t *oled, bool enable);
+int ssd1306_i2c_async_present_region(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp,
+        uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t priority);
+
+typedef struct {
+    uint64_t submitted; // frames given to ssd1306_i2c_async_present()
+    uint64_t flushed; // frames sent to the device
+    uint64_t dropped; // frames replaced by a newer one or dropped for being late
+    uint64_t errors; // frames that failed to be sent
+    uint64_t late; // frames that missed their deadline when pacing
+    uint64_t bus_ns; // moving average of the time a frame spends on the bus
+    uint64_t lost; // completions overwritten before ssd1306_i2c_async_drain()
+    uint64_t urgent; // regions sent by ssd1306_i2c_async_present_region()
+    // wakeup latency: from a frame's slot when pacing, or from its
+    // ssd1306_i2c_async_present() otherwise, until the thread starts sending it
+    uint64_t wake_ns; // moving average
+    uint64_t wake_max_ns;
+    uint64_t jitter_ns; // moving average of the deviation from wake_ns
+} ssd1306_i2c_async_stats_t;
+int ssd1306_i2c_async_get_stats(const ssd1306_i2c_t *oled, ssd1306_i2c_async_stats_t *stats);
+
+// frame pacing for the flush thread. frames are sent at fixed slots of
+// 1/fps seconds instead of as soon as they are presented, and the newest
+// frame presented before a slot wins. a frame is late if it is not expected
+// to be on the bus within deadline_ns of its slot, judged from the measured
+// bus time per frame. what happens to late frames depends on the policy.
+typedef enum {
+    SSD1306_I2C_PACE_DROP, // late frames are not sent. for continuous animations
+    SSD1306_I2C_PACE_MERGE, // late frames wait one slot and merge with newer ones
+    SSD1306_I2C_PACE_DEGRADE // late frames send only the changes that fit
+                             // the deadline and the rest in the next slot.
+                             // enables shadow mode
+} ssd1306_i2c_pace_policy_t;
+
+typedef struct {
+    uint64_t frame; // sequence number of the frame handled by the thread
+    uint64_t seq; // number of the ssd1306_i2c_async_present() call, from 1
+    uint64_t target_ns; // CLOCK_MONOTONIC time of the frame's slot. 0 without pacing
+    uint64_t present_ns; // CLOCK_MONOTONIC time the frame finished on the bus
+    uint64_t bus_ns; // time spent on the bus for this frame
+    uint64_t bus_bytes; // bytes sent for this frame
+    uint64_t wake_ns; // wakeup latency of this frame. refer ssd1306_i2c_async_stats_t
+    bool late; // missed or was expected to miss the deadline
+    bool dropped; // not sent because of the drop policy
+    bool partial; // only part of the changes was sent, the rest follows
+    bool failed; // sending failed
+} ssd1306_i2c_present_info_t;
+
+// called from the flush thread after every frame it handles
+typedef void (*ssd1306_i2c_present_cb_t)(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_present_info_t *info, void *cbdata);
+
+typedef struct {
+    unsigned int fps; // target frames per second. 0 disables pacing
+    uint64_t deadline_ns; // allowed delay after the slot. 0 for one frame period
+    ssd1306_i2c_pace_policy_t policy;
+    ssd1306_i2c_present_cb_t cb; // optional. also called when fps is 0
+    void *cbdata;
+} ssd1306_i2c_pacing_t;
+
+// configures pacing for a started flush thread. NULL turns pacing and the
+// callback off. returns 0 on success and -1 on failure
+int ssd1306_i2c_async_set_pacing(ssd1306_i2c_t *oled, const ssd1306_i2c_pacing_t *pacing);
+
+// completions for event loops. ssd1306_i2c_async_eventfd() returns a
+// non-blocking eventfd that becomes readable when the flush thread is done
+// with frames, for libev, libuv or epoll to watch. from the first call on,
+// every frame that is sent, dropped or fails is recorded, including frames
+// replaced by a newer ssd1306_i2c_async_present(), and a degraded frame is
+// recorded once per part. up to SSD1306_I2C_ASYNC_COMPLETIONS are kept and
+// older ones are overwritten and counted as lost. the fd belongs to the
+// device and is closed by ssd1306_i2c_async_stop(). returns -1 on failure
+#define SSD1306_I2C_ASYNC_COMPLETIONS 64
+int ssd1306_i2c_async_eventfd(ssd1306_i2c_t *oled);
+// copies up to max of the oldest completions into infos and returns how many
+// were copied. the fd stays readable while completions are left
+size_t ssd1306_i2c_async_drain(ssd1306_i2c_t *oled, ssd1306_i2c_present_info_t *infos,
+        size_t max);
+
+// bus arbitration between processes. every transfer to the display is sent
+// in slices of at most chunk_bytes, and each slice holds an exclusive flock()
+// on the bus device node, so other clients of the bus that lock the node the
+// same way, for example a sensor reader, wait at most one slice. a longer
+// flock() on a panel lock file keeps two processes from interleaving their
+// transfers to the same display. clients with high priority hold a shared
+// flock() on the bus priority file while they wait for the bus, and normal
+// clients take it exclusively before they try, so high priority clients get
+// the bus at the next slice. the lock files are <lock_dir>/<bus>.prio and
+// <lock_dir>/<bus>-<addr>.lock, named after the device node such as i2c-1.
+// needs a transport with a bus fd.
+#define SSD1306_I2C_ARB_CHUNK_DEFAULT 128
+#define SSD1306_I2C_ARB_LOCK_DIR_DEFAULT "/run/lock"
+typedef struct {
+    size_t chunk_bytes; // bytes per bus lock including control bytes. 0 for
+                        // SSD1306_I2C_ARB_CHUNK_DEFAULT
+    bool high_priority;
+    const char *lock_dir; // NULL for SSD1306_I2C_ARB_LOCK_DIR_DEFAULT
+} ssd1306_i2c_arbitration_t;
+
+typedef struct {
+    uint64_t locks; // bus lock acquisitions, one per slice
+    uint64_t wait_ns; // total time spent waiting for the bus and panel locks
+    uint64_t wait_max_ns;
+    uint64_t hold_ns; // total time the bus lock was held
+    uint64_t hold_max_ns;
+} ssd1306_i2c_arbitration_stats_t;
+
+// enables arbitration or replaces its settings. NULL disables it. returns 0 on
+// success and -1 on failure, in which case the arbitration in place is kept
+int ssd1306_i2c_arbitration_enable(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_arbitration_t *arb);
+int ssd1306_i2c_arbitration_get_stats(const ssd1306_i2c_t *oled,
+        ssd1306_i2c_arbitration_stats_t *stats);
+
+// ticker. the controller scrolls a band of pages by itself so marquee text
+// costs no bus traffic per step. the band's content is uploaded once and
+// rotates through the display width, so it should fit in one screen width.
+// scrolling is stopped before RAM is written and restarted afterwards, as the
+// datasheet requires, all in one submission.
+// ssd1306_i2c_display_update() keeps the ticker running and leaves the band
+// with the ticker's content, but restarts its scroll position.
+// return 0 on success and -1 on failure
+
+// uploads the band pages of fbp and starts scrolling them. a running ticker
+// is stopped first and its band rewritten with its content unscrolled.
+// refused while flipping pages or while a console is open
+int ssd1306_i2c_ticker_start(ssd1306_i2c_t *oled, const ssd1306_i2c_ticker_t *ticker,
+        const ssd1306_framebuffer_t *fbp);
+// replaces the band's content with the band pages of fbp. fails unless a
+// ticker is running
+int ssd1306_i2c_ticker_set_content(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp);
+// renders text in the ticker's font into the band and uploads it
+int ssd1306_i2c_ticker_set_text(ssd1306_i2c_t *oled, const char *text);
+// stops scrolling. the band is left where it scrolled to, so redraw it with
+// ssd1306_i2c_display_update()
+int ssd1306_i2c_ticker_stop(ssd1306_i2c_t *oled);
+
+// hardware effects. fades, blinks and flashes are done with the contrast,
+// inverse and entire display on commands, so a step costs a few bytes
+// instead of a frame. effects run on the clock: a step that is due goes out
+// at the start of the next transfer to the display, in the same submission,
+// and ssd1306_i2c_fx_run() sends due steps by itself. call it from a timer or
+// an event loop after the time it returns. a running flush thread calls it
+// when idle, so nothing else is needed with ssd1306_i2c_async_start().
+// a fade and one blink per target run at the same time. starting an effect
+// replaces the running one of its kind.
+// return 0 on success and -1 on failure
+typedef enum {
+    SSD1306_I2C_FX_LINEAR = 0,
+    SSD1306_I2C_FX_EASE_IN, // slow start
+    SSD1306_I2C_FX_EASE_OUT, // slow end
+    SSD1306_I2C_FX_EASE_IN_OUT
+} ssd1306_i2c_fx_curve_t;
+typedef enum {
+    SSD1306_I2C_FX_INVERT = 0, // inverse display
+    SSD1306_I2C_FX_ENTIRE_ON // every pixel on
+} ssd1306_i2c_fx_target_t;
+typedef struct {
+    uint64_t steps; // steps that changed the display
+    uint64_t merged; // steps sent along with another transfer
+    uint64_t bytes; // bytes of the steps including control bytes
+} ssd1306_i2c_fx_stats_t;
+// moves the contrast from one value to another. the contrast stays at to
+int ssd1306_i2c_fx_fade(ssd1306_i2c_t *oled, uint8_t from, uint8_t to, uint32_t duration_ms,
+        ssd1306_i2c_fx_curve_t curve);
+// plays pattern, lowest bit first, for nbits steps of step_ms each, where a
+// set bit turns the target on. repeats it repeat times, or until stopped if
+// repeat is 0, and then turns the target off
+int ssd1306_i2c_fx_blink(ssd1306_i2c_t *oled, ssd1306_i2c_fx_target_t target,
+        uint32_t pattern, uint8_t nbits, uint32_t step_ms, unsigned int repeat);
+// turns every pixel on for on_ms and off for as long, count times
+int ssd1306_i2c_fx_flash(ssd1306_i2c_t *oled, unsigned int count, uint32_t on_ms);
+// sends the steps that are due. sets next_ms, if not NULL, to the time until
+// the next step or UINT32_MAX if no effect runs. returns 1 while effects run,
+// 0 when none do and -1 on failure
+int ssd1306_i2c_fx_run(ssd1306_i2c_t *oled, uint32_t *next_ms);
+// ends all effects and returns to a normal display. the contrast stays
+int ssd1306_i2c_fx_stop(ssd1306_i2c_t *oled);
+int ssd1306_i2c_fx_get_stats(const ssd1306_i2c_t *oled, ssd1306_i2c_fx_stats_t *stats);
+
+// display groups. displays added to a group share one open fd per bus and
+// are addressed per message with I2C_RDWR, without I2C_SLAVE switching.
+// the displays belong to the group and are closed by
+// ssd1306_i2c_group_destroy(). all other ssd1306_i2c_* calls, including the
+// asynchronous ones, work on them. calls for displays on the same bus are
+// serialized. displays on different buses can be flushed in parallel with
+// ssd1306_i2c_async_start() on each of them.
+#define SSD1306_I2C_GROUP_MAX 16
+typedef struct ssd1306_i2c_group_ ssd1306_i2c_group_t;
+ssd1306_i2c_group_t *ssd1306_i2c_group_create(FILE *logerr);
+void ssd1306_i2c_group_destroy(ssd1306_i2c_group_t *grp);
+// opens the bus if not already open and adds a display. arguments are the same
+// as ssd1306_i2c_open(). returns the display or NULL on error
+ssd1306_i2c_t *ssd1306_i2c_group_add(ssd1306_i2c_group_t *grp, const char *dev,
+        uint8_t daddr, uint8_t width, uint8_t height);
+// adds a display reached through its own transport, as with
+// ssd1306_i2c_open_transport(). bus names the bus it is on. nothing is
+// opened for it, but displays with the same bus name are serialized and
+// updated by the same thread. the io_uring engine updates such displays
+// through their transport. returns the display or NULL on error
+ssd1306_i2c_t *ssd1306_i2c_group_add_transport(ssd1306_i2c_group_t *grp,
+        const ssd1306_i2c_transport_t *transport, void *ctx, const char *bus,
+        uint8_t daddr, uint8_t width, uint8_t height);
+size_t ssd1306_i2c_group_size(const ssd1306_i2c_group_t *grp);
+// returns the display at idx in the order they were added, or NULL
+ssd1306_i2c_t *ssd1306_i2c_group_get(ssd1306_i2c_group_t *grp, size_t idx);
+int ssd1306_i2c_group_display_initialize(ssd1306_i2c_group_t *grp);
+// updates every display with its own framebuffer. fbps has one entry per
+// display in group order. NULL entries are skipped. the display served first
+// rotates with every call. returns 0 on success and -1 if any update failed
+int ssd1306_i2c_group_update(ssd1306_i2c_group_t *grp,
+        const ssd1306_framebuffer_t *const *fbps, size_t nfbps);
+
+// how ssd1306_i2c_group_update() reaches the displays
+typedef enum {
+    SSD1306_I2C_ENGINE_SERIAL = 0, // one display after the other. default
+    SSD1306_I2C_ENGINE_THREADS, // a thread per bus, displays on a bus in turn
+    SSD1306_I2C_ENGINE_URING // every display's transactions in one io_uring
+                             // submission. each display gets its own fd, so
+                             // the kernel overlaps them across buses
+} ssd1306_i2c_engine_t;
+// selects the engine. SSD1306_I2C_ENGINE_URING falls back to threads if
+// io_uring is not available, and displays that need SMBus or chunked writes
+// are updated through the shared bus while the submission is in flight.
+// returns the engine in use or -1 on error
+int ssd1306_i2c_group_set_engine(ssd1306_i2c_group_t *grp, ssd1306_i2c_engine_t engine);
+// sends the same framebuffer to every display in the group. the frame is
+// encoded once and sent to each display in turn. displays of another size
+// are left alone and count as failed.
+// returns 0 on success and -1 if any display failed
+int ssd1306_i2c_group_mirror(ssd1306_i2c_group_t *grp, const ssd1306_framebuffer_t *fbp);
+
+// text console. GDDRAM is used as a ring of pages with one line of text per
+// page, and the display start line selects the page shown at the top, so a new
+// line costs one page and one command instead of a full frame. text is drawn
+// with a built-in 5x7 fixed width font in 6 pixel wide cells, wraps at the
+// end of the line and is kept in a bounded scrollback.
+// the console owns the start line while it exists, so do not mix it with
+// framebuffer updates or the async worker on the same display. only one
+// console per display, and none while page flipping is enabled or a ticker
+// is running.
+#define SSD1306_I2C_CONSOLE_GLYPH_WIDTH 6
+#define SSD1306_I2C_CONSOLE_TAB_WIDTH 4
+typedef struct ssd1306_i2c_console_ ssd1306_i2c_console_t;
+// clears the display and returns a console keeping scrollback lines of history
+// beyond the screen, or NULL on error
+ssd1306_i2c_console_t *ssd1306_i2c_console_create(ssd1306_i2c_t *oled, size_t scrollback);
+// resets the start line and frees the console. the display is not cleared
+void ssd1306_i2c_console_destroy(ssd1306_i2c_console_t *con);
+// appends text, handling '\n', '\r' and '\t'. if len is 0, text must be NULL
+// terminated. characters outside printable ASCII show as '?'. scrolls the view
+// back to the newest line. returns 0 on success and -1 on error
+int ssd1306_i2c_console_write(ssd1306_i2c_console_t *con, const char *text, size_t len);
+// starts over on a blank screen and drops the scrollback
+int ssd1306_i2c_console_clear(ssd1306_i2c_console_t *con);
+// shows the screen that lines_back lines above the newest one, clamped to the
+// scrollback held. 0 returns to the newest line
+int ssd1306_i2c_console_scroll(ssd1306_i2c_console_t *con, size_t lines_back);
+// number of lines that can be scrolled back to
+size_t ssd1306_i2c_console_scrollback(const ssd1306_i2c_console_t *con);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -0,0 +1,263 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "ssd1306_i2c_internal.h"
+
+// inter-process bus arbitration. refer ssd1306_i2c_arbitration_enable()
+#define SSD1306_I2C_ARB_SEGS_MAX 16
+struct ssd1306_i2c_arbiter_ {
+    size_t chunk_bytes;
+    bool high_priority;
+    int bus_fd; // the transport's fd. not owned
+    int prio_fd; // -1 if the priority file could not be opened
+    int panel_fd; // -1 if the panel lock file could not be opened
+    uint8_t *scratch; // control byte + one slice of a split data transaction
+    uint64_t lock_ns; // when the bus lock was taken
+    ssd1306_i2c_arbitration_stats_t stats;
+};
+
+void ssd1306_i2c_internal_arb_free(ssd1306_i2c_arbiter_t *arb)
+{
+    if (!arb)
+        return;
+    if (arb->prio_fd >= 0)
+        close(arb->prio_fd);
+    if (arb->panel_fd >= 0)
+        close(arb->panel_fd);
+    free(arb->scratch);
+    memset(arb, 0, sizeof(*arb));
+    free(arb);
+}
+
+#ifdef SSD1306_I2C_HAVE_FLOCK
+static int ssd1306_i2c_internal_flock(int fd, int op)
+{
+    int rc;
+    while ((rc = flock(fd, op)) < 0 && errno == EINTR);
+    return rc;
+}
+
+static void ssd1306_i2c_internal_arb_waited(ssd1306_i2c_arbiter_t *arb, uint64_t t0)
+{
+    uint64_t waited = ssd1306_i2c_internal_now_ns() - t0;
+    arb->stats.wait_ns += waited;
+    if (waited > arb->stats.wait_max_ns)
+        arb->stats.wait_max_ns = waited;
+}
+
+static int ssd1306_i2c_internal_arb_lock(ssd1306_i2c_t *oled)
+{
+    ssd1306_i2c_arbiter_t *arb = oled->arbiter;
+    uint64_t t0 = ssd1306_i2c_internal_now_ns();
+    int rc = 0;
+    // normal clients wait here while a high priority client waits for or
+    // holds the bus
+    if (arb->prio_fd >= 0)
+        rc = ssd1306_i2c_internal_flock(arb->prio_fd, arb->high_priority ? LOCK_SH : LOCK_EX);
+    if (rc == 0)
+        rc = ssd1306_i2c_internal_flock(arb->bus_fd, LOCK_EX);
+    if (arb->prio_fd >= 0 && (!arb->high_priority || rc < 0)) {
+        int errnum = errno;
+        ssd1306_i2c_internal_flock(arb->prio_fd, LOCK_UN);
+        errno = errnum;
+    }
+    if (rc < 0) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_ERROR(oled->err, "Failed to lock bus fd %d: %s", arb->bus_fd,
+                oled->err->errbuf);
+        return -1;
+    }
+    arb->lock_ns = ssd1306_i2c_internal_now_ns();
+    ssd1306_i2c_internal_arb_waited(arb, t0);
+    arb->stats.locks++;
+    return 0;
+}
+
+static void ssd1306_i2c_internal_arb_unlock(ssd1306_i2c_t *oled)
+{
+    ssd1306_i2c_arbiter_t *arb = oled->arbiter;
+    ssd1306_i2c_internal_flock(arb->bus_fd, LOCK_UN);
+    if (arb->prio_fd >= 0 && arb->high_priority)
+        ssd1306_i2c_internal_flock(arb->prio_fd, LOCK_UN);
+    uint64_t held = ssd1306_i2c_internal_now_ns() - arb->lock_ns;
+    arb->stats.hold_ns += held;
+    if (held > arb->stats.hold_max_ns)
+        arb->stats.hold_max_ns = held;
+}
+
+static int ssd1306_i2c_internal_arb_slice(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    if (ssd1306_i2c_internal_arb_lock(oled) < 0)
+        return -1;
+    int rc = ssd1306_i2c_internal_xfer_send(oled, segs, nsegs);
+    ssd1306_i2c_internal_arb_unlock(oled);
+    return rc;
+}
+
+// sends the segments in slices of at most chunk_bytes with the bus locked for
+// each slice. whole transactions are grouped into a slice, data transactions
+// that are too long are split and commands are never split. the panel stays
+// locked for the whole transfer
+int ssd1306_i2c_internal_arb_xfer(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_i2c_arbiter_t *arb = oled->arbiter;
+    if (arb->panel_fd >= 0) {
+        uint64_t t0 = ssd1306_i2c_internal_now_ns();
+        if (ssd1306_i2c_internal_flock(arb->panel_fd, LOCK_EX) < 0) {
+            oled->err->errnum = errno;
+            strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+            SSD1306_LOG_ERROR(oled->err, "Failed to lock the panel: %s", oled->err->errbuf);
+            return -1;
+        }
+        ssd1306_i2c_internal_arb_waited(arb, t0);
+    }
+    int rc = 0;
+    size_t idx = 0;
+    while (idx < nsegs && rc == 0) {
+        if (segs[idx].len > arb->chunk_bytes && SSD1306_I2C_SEG_IS_DATA(&segs[idx])) {
+            const uint8_t *payload = &(segs[idx].buf[1]);
+            size_t left = segs[idx].len - 1;
+            arb->scratch[0] = segs[idx].buf[0];
+            while (left > 0 && rc == 0) {
+                size_t n = (left < arb->chunk_bytes - 1) ? left : arb->chunk_bytes - 1;
+                memcpy(&(arb->scratch[1]), payload, n);
+                ssd1306_i2c_seg_t piece = { arb->scratch, n + 1 };
+                rc = ssd1306_i2c_internal_arb_slice(oled, &piece, 1);
+                payload += n;
+                left -= n;
+            }
+            idx++;
+            continue;
+        }
+        size_t n = 1;
+        size_t bytes = segs[idx].len;
+        while (idx + n < nsegs && n < SSD1306_I2C_ARB_SEGS_MAX &&
+                bytes + segs[idx + n].len <= arb->chunk_bytes) {
+            bytes += segs[idx + n].len;
+            n++;
+        }
+        rc = ssd1306_i2c_internal_arb_slice(oled, &segs[idx], n);
+        idx += n;
+    }
+    if (arb->panel_fd >= 0)
+        ssd1306_i2c_internal_flock(arb->panel_fd, LOCK_UN);
+    return rc;
+}
+#endif
+
+#ifdef SSD1306_I2C_HAVE_FLOCK
+// opens a lock file in dir named after the bus node and suffix. returns -1
+// if it cannot be created, which only disables that part of the arbitration
+static int ssd1306_i2c_internal_arb_file(ssd1306_i2c_t *oled, const char *dir,
+        const char *suffix)
+{
+    const char *bus = strrchr(oled->dev, '/');
+    bus = bus ? bus + 1 : oled->dev;
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s%s", dir, bus, suffix);
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_WARN(oled->err, "Cannot open lock file %s: %s", path, oled->err->errbuf);
+    }
+    return fd;
+}
+#endif
+
+#ifdef SSD1306_I2C_HAVE_FLOCK
+// builds an arbiter for cfg. called with the device lock held. returns NULL
+// on error
+static ssd1306_i2c_arbiter_t *ssd1306_i2c_internal_arb_create(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_arbitration_t *cfg)
+{
+    ssd1306_err_t *err = oled->err;
+    if (!(oled->transport_caps & SSD1306_I2C_TRANSPORT_CAP_FD) || oled->fd < 0 || !oled->dev) {
+        SSD1306_LOG_ERROR(err, "Bus arbitration needs a transport with a bus device");
+        return NULL;
+    }
+    size_t chunk = cfg->chunk_bytes ? cfg->chunk_bytes : SSD1306_I2C_ARB_CHUNK_DEFAULT;
+    if (chunk < 2) {
+        SSD1306_LOG_ERROR(err, "Arbitration chunk of %zu bytes is too small", chunk);
+        return NULL;
+    }
+    ssd1306_i2c_arbiter_t *arb = calloc(1, sizeof(*arb));
+    if (!arb) {
+        SSD1306_LOG_ERROR(err, "Failed to allocate memory of size %zu bytes", sizeof(*arb));
+        return NULL;
+    }
+    arb->prio_fd = -1;
+    arb->panel_fd = -1;
+    arb->scratch = calloc(sizeof(uint8_t), chunk);
+    if (!arb->scratch) {
+        SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for arbitration", chunk);
+        ssd1306_i2c_internal_arb_free(arb);
+        return NULL;
+    }
+    arb->chunk_bytes = chunk;
+    arb->high_priority = cfg->high_priority;
+    arb->bus_fd = oled->fd;
+    const char *dir = cfg->lock_dir ? cfg->lock_dir : SSD1306_I2C_ARB_LOCK_DIR_DEFAULT;
+    char suffix[16];
+    snprintf(suffix, sizeof(suffix), "-%02x.lock", oled->addr);
+    arb->prio_fd = ssd1306_i2c_internal_arb_file(oled, dir, ".prio");
+    arb->panel_fd = ssd1306_i2c_internal_arb_file(oled, dir, suffix);
+    return arb;
+}
+#endif
+
+int ssd1306_i2c_arbitration_enable(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_arbitration_t *cfg)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+#ifndef SSD1306_I2C_HAVE_FLOCK
+    if (cfg) {
+        SSD1306_LOG_ERROR(err, "Library built without flock() support");
+        return -1;
+    }
+#endif
+    ssd1306_i2c_arbiter_t *arb = NULL;
+    SSD1306_I2C_LOCK(oled);
+#ifdef SSD1306_I2C_HAVE_FLOCK
+    // a bad configuration leaves the current arbitration in place
+    if (cfg) {
+        arb = ssd1306_i2c_internal_arb_create(oled, cfg);
+        if (!arb) {
+            SSD1306_I2C_UNLOCK(oled);
+            return -1;
+        }
+        SSD1306_LOG_INFO(err, "Arbitrating %s in slices of %zu bytes with %s priority",
+                oled->dev, arb->chunk_bytes, arb->high_priority ? "high" : "normal");
+    }
+#endif
+    ssd1306_i2c_arbiter_t *old = oled->arbiter;
+    oled->arbiter = arb;
+    SSD1306_I2C_UNLOCK(oled);
+    ssd1306_i2c_internal_arb_free(old);
+    return 0;
+}
+
+int ssd1306_i2c_arbitration_get_stats(const ssd1306_i2c_t *oled,
+        ssd1306_i2c_arbitration_stats_t *stats)
+{
+    int rc = 0;
+    if (!oled || !stats)
+        return -1;
+    SSD1306_I2C_LOCK(oled);
+    if (oled->arbiter)
+        *stats = oled->arbiter->stats;
+    else
+        rc = -1;
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
@@ -0,0 +1,340 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "ssd1306_i2c_internal.h"
+
+// 5x7 glyphs for ASCII 0x20-0x7E, one byte per column, LSB is the top row
+static const uint8_t ssd1306_i2c_console_font[][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 }, // ' ' '!'
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 }, // '"' '#'
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 }, // '$' '%'
+    { 0x36, 0x49, 0x56, 0x20, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 }, // '&' '''
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 }, // '(' ')'
+    { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 }, // '*' '+'
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 }, // ',' '-'
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 }, // '.' '/'
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 }, // '0' '1'
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 }, // '2' '3'
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 }, // '4' '5'
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 }, // '6' '7'
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E }, // '8' '9'
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 }, // ':' ';'
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 }, // '<' '='
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 }, // '>' '?'
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E }, // '@' 'A'
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 }, // 'B' 'C'
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 }, // 'D' 'E'
+    { 0x7F, 0x09, 0x09, 0x09, 0x01 }, { 0x3E, 0x41, 0x49, 0x49, 0x7A }, // 'F' 'G'
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 }, // 'H' 'I'
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 }, // 'J' 'K'
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x0C, 0x02, 0x7F }, // 'L' 'M'
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E }, // 'N' 'O'
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E }, // 'P' 'Q'
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 }, // 'R' 'S'
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F }, // 'T' 'U'
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x3F, 0x40, 0x38, 0x40, 0x3F }, // 'V' 'W'
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x07, 0x08, 0x70, 0x08, 0x07 }, // 'X' 'Y'
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 }, // 'Z' '['
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 }, // '\' ']'
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 }, // '^' '_'
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 }, // '`' 'a'
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 }, // 'b' 'c'
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 }, // 'd' 'e'
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E }, // 'f' 'g'
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 }, // 'h' 'i'
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 }, // 'j' 'k'
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 }, // 'l' 'm'
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 }, // 'n' 'o'
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C }, // 'p' 'q'
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 }, // 'r' 's'
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C }, // 't' 'u'
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C }, // 'v' 'w'
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C }, // 'x' 'y'
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 }, // 'z' '{'
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 }, // '|' '}'
+    { 0x08, 0x04, 0x08, 0x10, 0x08 }                                    // '~'
+};
+
+#define SSD1306_I2C_CONSOLE_PAGES 8
+// page_line value of a page whose content is not known
+#define SSD1306_I2C_CONSOLE_STALE -2
+// page_line value of a cleared page
+#define SSD1306_I2C_CONSOLE_BLANK -1
+
+struct ssd1306_i2c_console_ {
+    ssd1306_i2c_t *oled;
+    uint8_t cols; // characters per line
+    uint8_t rows; // lines on screen
+    size_t capacity; // lines kept, scrollback included
+    char *lines; // capacity lines of cols characters, line L at L % capacity
+    int64_t first; // first line not cleared away
+    int64_t last; // number of the line the cursor is on
+    uint8_t cursor; // column of the cursor
+    bool fresh; // nothing written to the cursor line since it was started
+    size_t view; // lines scrolled back from the newest
+    // GDDRAM is a ring of pages and line L always lives in page L % 8. the
+    // start line selects which page shows at the top
+    int64_t page_line[SSD1306_I2C_CONSOLE_PAGES]; // line held by each page
+    int start_page; // start line sent last divided by 8. -1 if unknown
+    uint8_t *page_buffers; // control byte + page for each page
+};
+
+static inline char *ssd1306_i2c_console_line(ssd1306_i2c_console_t *con, int64_t line)
+{
+    return &(con->lines[(size_t)(line % (int64_t)con->capacity) * con->cols]);
+}
+
+static inline int64_t ssd1306_i2c_console_oldest(const ssd1306_i2c_console_t *con)
+{
+    int64_t oldest = con->last - (int64_t)con->capacity + 1;
+    return (oldest < con->first) ? con->first : oldest;
+}
+
+// the newest line shown. an empty cursor line is not scrolled into view until
+// something is written to it, so a line of output costs one page, not two
+static inline int64_t ssd1306_i2c_console_shown(const ssd1306_i2c_console_t *con)
+{
+    return (con->fresh && con->last > con->first) ? con->last - 1 : con->last;
+}
+
+// the line shown on the top row
+static int64_t ssd1306_i2c_console_top(const ssd1306_i2c_console_t *con)
+{
+    int64_t top = ssd1306_i2c_console_shown(con) - con->rows + 1 - (int64_t)con->view;
+    int64_t oldest = ssd1306_i2c_console_oldest(con);
+    return (top < oldest) ? oldest : top;
+}
+
+static void ssd1306_i2c_console_render(ssd1306_i2c_console_t *con, int64_t line,
+        uint8_t *page)
+{
+    const size_t width = con->oled->width;
+    memset(page, 0, width);
+    if (line < 0)
+        return;
+    const char *text = ssd1306_i2c_console_line(con, line);
+    for (size_t c = 0; c < con->cols; ++c) {
+        uint8_t ch = (uint8_t)text[c];
+        if (ch < 0x20 || ch > 0x7E)
+            ch = '?';
+        memcpy(&page[c * SSD1306_I2C_CONSOLE_GLYPH_WIDTH],
+                ssd1306_i2c_console_font[ch - 0x20], 5);
+    }
+}
+
+// sends the pages that do not hold what the screen should show and moves the
+// start line, all in one submission
+static int ssd1306_i2c_console_flush(ssd1306_i2c_console_t *con)
+{
+    ssd1306_i2c_t *oled = con->oled;
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    const size_t width = oled->width;
+    uint8_t cmds[SSD1306_I2C_CONSOLE_PAGES + 1][2 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    ssd1306_i2c_seg_t segs[2 * SSD1306_I2C_CONSOLE_PAGES + 1];
+    int64_t want[SSD1306_I2C_CONSOLE_PAGES];
+    size_t nsegs = 0;
+    int64_t top = ssd1306_i2c_console_top(con);
+    int64_t shown = ssd1306_i2c_console_shown(con);
+    for (size_t p = 0; p < SSD1306_I2C_CONSOLE_PAGES; ++p)
+        want[p] = con->page_line[p];
+    for (uint8_t r = 0; r < con->rows; ++r) {
+        int64_t line = top + r;
+        size_t p = (size_t)(line % SSD1306_I2C_CONSOLE_PAGES);
+        want[p] = (line <= shown) ? line : SSD1306_I2C_CONSOLE_BLANK;
+        if (want[p] == con->page_line[p])
+            continue;
+        ssd1306_i2c_rect_t rect = { p, p, 0, width - 1 };
+        size_t clen = ssd1306_i2c_internal_encode_rect(oled, &rect, cmds[p], sizeof(cmds[p]));
+        if (clen == 0)
+            return -1;
+        uint8_t *page = &(con->page_buffers[p * (width + 1)]);
+        page[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+        ssd1306_i2c_console_render(con, want[p], &page[1]);
+        segs[nsegs].buf = cmds[p];
+        segs[nsegs++].len = clen;
+        segs[nsegs].buf = page;
+        segs[nsegs++].len = width + 1;
+    }
+    int start_page = (int)(top % SSD1306_I2C_CONSOLE_PAGES);
+    if (start_page != con->start_page) {
+        uint8_t *c = cmds[SSD1306_I2C_CONSOLE_PAGES];
+        uint8_t line = (uint8_t)(start_page * 8);
+        c[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+        size_t sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_DISP_START_LINE,
+                        &line, 1, &c[1], sizeof(cmds[0]) - 1);
+        if (sz == 0)
+            return -1;
+        segs[nsegs].buf = c;
+        segs[nsegs++].len = sz + 1;
+    }
+    if (nsegs == 0)
+        return 0;
+    SSD1306_I2C_LOCK(oled);
+    int rc = ssd1306_i2c_internal_xfer(oled, segs, nsegs);
+    SSD1306_I2C_UNLOCK(oled);
+    if (rc < 0) {
+        // some of it may have reached the display
+        for (size_t p = 0; p < SSD1306_I2C_CONSOLE_PAGES; ++p)
+            con->page_line[p] = SSD1306_I2C_CONSOLE_STALE;
+        con->start_page = -1;
+        return -1;
+    }
+    memcpy(con->page_line, want, sizeof(want));
+    con->start_page = start_page;
+    return 0;
+}
+
+static void ssd1306_i2c_console_newline(ssd1306_i2c_console_t *con)
+{
+    con->last++;
+    con->cursor = 0;
+    con->fresh = true;
+    memset(ssd1306_i2c_console_line(con, con->last), ' ', con->cols);
+}
+
+ssd1306_i2c_console_t *ssd1306_i2c_console_create(ssd1306_i2c_t *oled, size_t scrollback)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || oled->width < SSD1306_I2C_CONSOLE_GLYPH_WIDTH ||
+        oled->height < 8) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return NULL;
+    }
+    if (oled->console_active || oled->flip_enabled || oled->ticker_active) {
+        SSD1306_LOG_ERROR(err, "Cannot open a console while %s",
+                oled->flip_enabled ? "flipping pages" :
+                oled->ticker_active ? "the ticker is running" : "another console is open");
+        return NULL;
+    }
+    ssd1306_i2c_console_t *con = calloc(1, sizeof(*con));
+    if (!con) {
+        SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes", sizeof(*con));
+        return NULL;
+    }
+    do {
+        con->oled = oled;
+        con->cols = oled->width / SSD1306_I2C_CONSOLE_GLYPH_WIDTH;
+        con->rows = oled->height / 8;
+        // one more for the cursor line before it is shown
+        con->capacity = con->rows + scrollback + 1;
+        con->lines = calloc(con->capacity, con->cols);
+        con->page_buffers = calloc(SSD1306_I2C_CONSOLE_PAGES, oled->width + 1);
+        if (!con->lines || !con->page_buffers) {
+            SSD1306_LOG_ERROR(err, "Out of memory allocating console of %zu lines",
+                    con->capacity);
+            break;
+        }
+        for (size_t p = 0; p < SSD1306_I2C_CONSOLE_PAGES; ++p)
+            con->page_line[p] = SSD1306_I2C_CONSOLE_STALE;
+        con->start_page = -1;
+        con->last = -1;
+        ssd1306_i2c_console_newline(con);
+        // the console owns the start line, so the shadow no longer matches
+        oled->shadow_valid = false;
+        oled->console_active = true;
+        if (ssd1306_i2c_console_flush(con) < 0)
+            break;
+        SSD1306_LOG_INFO(err, "Console of %ux%u characters with %zu lines of scrollback",
+                con->cols, con->rows, scrollback);
+        return con;
+    } while (0);
+    ssd1306_i2c_console_destroy(con);
+    return NULL;
+}
+
+void ssd1306_i2c_console_destroy(ssd1306_i2c_console_t *con)
+{
+    if (!con)
+        return;
+    if (con->oled && con->start_page != 0) {
+        // leave the display addressed the way the framebuffer updates expect
+        uint8_t cmds[2] = { 0x00, 0x40 }; // Co: 0 D/C#: 0, start line 0
+        SSD1306_I2C_LOCK(con->oled);
+        ssd1306_i2c_internal_write_cmds(con->oled, cmds, sizeof(cmds));
+        SSD1306_I2C_UNLOCK(con->oled);
+    }
+    if (con->oled)
+        con->oled->console_active = false;
+    if (con->lines)
+        free(con->lines);
+    if (con->page_buffers)
+        free(con->page_buffers);
+    memset(con, 0, sizeof(*con));
+    free(con);
+}
+
+int ssd1306_i2c_console_write(ssd1306_i2c_console_t *con, const char *text, size_t len)
+{
+    if (!con || !text)
+        return -1;
+    if (len == 0)
+        len = strlen(text);
+    for (size_t idx = 0; idx < len; ++idx) {
+        uint8_t ch = (uint8_t)text[idx];
+        if (ch == '\n') {
+            ssd1306_i2c_console_newline(con);
+            continue;
+        }
+        if (ch == '\r') {
+            con->cursor = 0;
+            continue;
+        }
+        if (ch >= 0x80 && ch < 0xC0)
+            continue; // UTF-8 continuation bytes. the lead byte shows as '?'
+        if (ch < 0x20 && ch != '\t')
+            continue;
+        uint8_t n = 1;
+        if (ch == '\t') {
+            ch = ' ';
+            n = (uint8_t)(SSD1306_I2C_CONSOLE_TAB_WIDTH -
+                    (con->cursor % SSD1306_I2C_CONSOLE_TAB_WIDTH));
+        }
+        while (n-- > 0) {
+            if (con->cursor >= con->cols)
+                ssd1306_i2c_console_newline(con); // wrap
+            char *line = ssd1306_i2c_console_line(con, con->last);
+            line[con->cursor++] = (char)ch;
+            con->fresh = false;
+            size_t p = (size_t)(con->last % SSD1306_I2C_CONSOLE_PAGES);
+            if (con->page_line[p] == con->last)
+                con->page_line[p] = SSD1306_I2C_CONSOLE_STALE;
+        }
+    }
+    // new output scrolls the view back down
+    con->view = 0;
+    return ssd1306_i2c_console_flush(con);
+}
+
+int ssd1306_i2c_console_clear(ssd1306_i2c_console_t *con)
+{
+    if (!con)
+        return -1;
+    // continue on a fresh line at the top and drop everything before it
+    ssd1306_i2c_console_newline(con);
+    con->first = con->last;
+    con->view = 0;
+    return ssd1306_i2c_console_flush(con);
+}
+
+int ssd1306_i2c_console_scroll(ssd1306_i2c_console_t *con, size_t lines_back)
+{
+    if (!con)
+        return -1;
+    size_t avail = (size_t)(ssd1306_i2c_console_shown(con) -
+                        ssd1306_i2c_console_oldest(con) + 1);
+    size_t max = (avail > con->rows) ? avail - con->rows : 0;
+    con->view = (lines_back > max) ? max : lines_back;
+    return ssd1306_i2c_console_flush(con);
+}
+
+size_t ssd1306_i2c_console_scrollback(const ssd1306_i2c_console_t *con)
+{
+    if (!con)
+        return 0;
+    size_t avail = (size_t)(ssd1306_i2c_console_shown(con) -
+                        ssd1306_i2c_console_oldest(con) + 1);
+    return (avail > con->rows) ? avail - con->rows : 0;
+}
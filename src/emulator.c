@@ -0,0 +1,379 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include <ssd1306_config.h>
+#ifdef LIBSSD1306_HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef LIBSSD1306_HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef LIBSSD1306_HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#include <ssd1306_emulator.h>
+
+#if LIBSSD1306_HAVE_DECL_STRERROR_R
+// do nothing
+#else
+// rewrite it
+#warning "strerror_r is reentrant. strerror is not, so removing usage of strerror_r"
+#define strerror_r(A,B,C) do {} while (0)
+#endif
+
+ssd1306_emu_t *ssd1306_emu_create(void)
+{
+    ssd1306_emu_t *emu = calloc(1, sizeof(*emu));
+    if (emu) {
+        ssd1306_emu_reset(emu);
+    }
+    return emu;
+}
+
+void ssd1306_emu_destroy(ssd1306_emu_t *emu)
+{
+    if (emu) {
+        memset(emu, 0, sizeof(*emu));
+        free(emu);
+    }
+}
+
+void ssd1306_emu_reset(ssd1306_emu_t *emu)
+{
+    if (!emu)
+        return;
+    ssd1306_emu_stats_t stats = emu->stats;
+    memset(emu, 0, sizeof(*emu));
+    emu->stats = stats;
+    // reset values from the datasheet
+    emu->mem_mode = 2;
+    emu->col_end = SSD1306_EMU_COLUMNS - 1;
+    emu->page_end = SSD1306_EMU_PAGES - 1;
+    emu->contrast = 0x7F;
+    emu->mux_ratio = SSD1306_EMU_ROWS - 1;
+    emu->com_pins = 0x12;
+    emu->clock_divfreq = 0x80;
+    emu->precharge = 0x22;
+    emu->vcomh = 0x20;
+    emu->dcdc = 0x8B; // SH1106
+    emu->vscroll_rows = SSD1306_EMU_ROWS;
+}
+
+void ssd1306_emu_reset_stats(ssd1306_emu_t *emu)
+{
+    if (emu)
+        memset(&(emu->stats), 0, sizeof(emu->stats));
+}
+
+// number of argument bytes following the command opcode
+static size_t ssd1306_emu_internal_arg_count(uint8_t op)
+{
+    switch (op) {
+    case 0x20: // memory addressing mode
+    case 0x81: // contrast
+    case 0x8D: // charge pump
+    case 0xA8: // multiplex ratio
+    case 0xAD: // SH1106 DC-DC converter
+    case 0xD3: // display offset
+    case 0xD5: // clock divide/frequency
+    case 0xD9: // precharge period
+    case 0xDA: // COM pins
+    case 0xDB: // VCOMH deselect level
+        return 1;
+    case 0x21: // column address
+    case 0x22: // page address
+    case 0xA3: // vertical scroll area
+        return 2;
+    case 0x29: // vertical and right horizontal scroll
+    case 0x2A: // vertical and left horizontal scroll
+        return 5;
+    case 0x26: // right horizontal scroll
+    case 0x27: // left horizontal scroll
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void ssd1306_emu_internal_run_cmd(ssd1306_emu_t *emu)
+{
+    const uint8_t op = emu->cmd[0];
+    const uint8_t *arg = &(emu->cmd[1]);
+    emu->stats.commands++;
+    if (op <= 0x0F) {
+        emu->page_col_start = (emu->page_col_start & 0xF0) | op;
+        emu->col = emu->page_col_start;
+        return;
+    }
+    if (op >= 0x10 && op <= 0x1F) {
+        emu->page_col_start = (uint8_t)((emu->page_col_start & 0x0F) | ((op & 0x07) << 4));
+        emu->col = emu->page_col_start;
+        return;
+    }
+    if (op >= 0x40 && op <= 0x7F) {
+        emu->start_line = op & 0x3F;
+        return;
+    }
+    if (op >= 0xB0 && op <= 0xB7) {
+        emu->page = op & 0x07;
+        return;
+    }
+    switch (op) {
+    case 0x20:
+        emu->mem_mode = arg[0] & 0x03;
+        if (emu->mem_mode == 3)
+            emu->mem_mode = 2; // invalid, behaves as page mode
+        break;
+    case 0x21:
+        emu->col_start = arg[0] & 0x7F;
+        emu->col_end = arg[1] & 0x7F;
+        emu->col = emu->col_start;
+        break;
+    case 0x22:
+        emu->page_start = arg[0] & 0x07;
+        emu->page_end = arg[1] & 0x07;
+        emu->page = emu->page_start;
+        break;
+    case 0x26:
+    case 0x27:
+        emu->scroll_cmd = op;
+        emu->scroll_start_page = arg[1] & 0x07;
+        emu->scroll_interval = arg[2] & 0x07;
+        emu->scroll_end_page = arg[3] & 0x07;
+        emu->scroll_voffset = 0;
+        break;
+    case 0x29:
+    case 0x2A:
+        emu->scroll_cmd = op;
+        emu->scroll_start_page = arg[1] & 0x07;
+        emu->scroll_interval = arg[2] & 0x07;
+        emu->scroll_end_page = arg[3] & 0x07;
+        emu->scroll_voffset = arg[4] & 0x3F;
+        break;
+    case 0x2E:
+        emu->scroll_active = false;
+        break;
+    case 0x2F:
+        emu->scroll_active = (emu->scroll_cmd != 0);
+        emu->vscroll_pos = 0;
+        break;
+    case 0x81:
+        emu->contrast = arg[0];
+        break;
+    case 0x8D:
+        emu->charge_pump = (arg[0] & 0x04) ? true : false;
+        break;
+    case 0xA0:
+    case 0xA1:
+        emu->seg_remap = (op == 0xA1);
+        break;
+    case 0xA3:
+        emu->vscroll_top = arg[0] & 0x3F;
+        emu->vscroll_rows = arg[1] & 0x7F;
+        break;
+    case 0xA4:
+    case 0xA5:
+        emu->entire_on = (op == 0xA5);
+        break;
+    case 0xA6:
+    case 0xA7:
+        emu->inverted = (op == 0xA7);
+        break;
+    case 0xA8:
+        emu->mux_ratio = arg[0] & 0x3F;
+        break;
+    case 0xAD:
+        emu->dcdc = arg[0];
+        break;
+    case 0xAE:
+    case 0xAF:
+        emu->display_on = (op == 0xAF);
+        break;
+    case 0xC0:
+    case 0xC8:
+        emu->com_invert = (op == 0xC8);
+        break;
+    case 0xD3:
+        emu->disp_offset = arg[0] & 0x3F;
+        break;
+    case 0xD5:
+        emu->clock_divfreq = arg[0];
+        break;
+    case 0xD9:
+        emu->precharge = arg[0];
+        break;
+    case 0xDA:
+        emu->com_pins = arg[0];
+        break;
+    case 0xDB:
+        emu->vcomh = arg[0];
+        break;
+    case 0xE3: // NOP
+        break;
+    default:
+        emu->stats.commands--;
+        emu->stats.unknown_cmds++;
+        break;
+    }
+}
+
+static void ssd1306_emu_internal_cmd_byte(ssd1306_emu_t *emu, uint8_t byte)
+{
+    emu->stats.cmd_bytes++;
+    if (emu->cmd_len == 0) {
+        emu->cmd_need = 1 + ssd1306_emu_internal_arg_count(byte);
+    }
+    emu->cmd[emu->cmd_len++] = byte;
+    if (emu->cmd_len >= emu->cmd_need) {
+        ssd1306_emu_internal_run_cmd(emu);
+        emu->cmd_len = 0;
+        emu->cmd_need = 0;
+    }
+}
+
+// writes one byte at the GDDRAM pointer and advances it the way the
+// addressing mode does
+static void ssd1306_emu_internal_data_byte(ssd1306_emu_t *emu, uint8_t byte)
+{
+    emu->stats.data_bytes++;
+    emu->gddram[emu->page & 0x07][emu->col & 0x7F] = byte;
+    switch (emu->mem_mode) {
+    case 0: // horizontal
+        if (emu->col >= emu->col_end) {
+            emu->col = emu->col_start;
+            emu->page = (emu->page >= emu->page_end) ? emu->page_start : emu->page + 1;
+        } else {
+            emu->col++;
+        }
+        break;
+    case 1: // vertical
+        if (emu->page >= emu->page_end) {
+            emu->page = emu->page_start;
+            emu->col = (emu->col >= emu->col_end) ? emu->col_start : emu->col + 1;
+        } else {
+            emu->page++;
+        }
+        break;
+    default: // page
+        emu->col = (emu->col >= SSD1306_EMU_COLUMNS - 1) ? emu->page_col_start : emu->col + 1;
+        break;
+    }
+}
+
+int ssd1306_emu_write(ssd1306_emu_t *emu, const uint8_t *buf, size_t len)
+{
+    if (!emu || !buf || len == 0)
+        return -1;
+    emu->stats.transactions++;
+    emu->stats.bytes += len;
+    if (buf[0] & 0x40)
+        emu->stats.data_xfers++;
+    else
+        emu->stats.cmd_xfers++;
+    size_t idx = 0;
+    while (idx < len) {
+        const uint8_t ctrl = buf[idx++];
+        emu->stats.control_bytes++;
+        // Co = 1: one byte follows and then another control byte
+        size_t end = (ctrl & 0x80) ? idx + 1 : len;
+        if (end > len)
+            end = len;
+        for (; idx < end; ++idx) {
+            if (ctrl & 0x40)
+                ssd1306_emu_internal_data_byte(emu, buf[idx]);
+            else
+                ssd1306_emu_internal_cmd_byte(emu, buf[idx]);
+        }
+    }
+    return 0;
+}
+
+void ssd1306_emu_scroll_step(ssd1306_emu_t *emu, unsigned int steps)
+{
+    if (!emu || !emu->scroll_active)
+        return;
+    const bool right = (emu->scroll_cmd == 0x26 || emu->scroll_cmd == 0x29);
+    const bool vertical = (emu->scroll_cmd == 0x29 || emu->scroll_cmd == 0x2A);
+    for (unsigned int s = 0; s < steps; ++s) {
+        for (uint8_t p = emu->scroll_start_page; p <= emu->scroll_end_page && p < SSD1306_EMU_PAGES; ++p) {
+            uint8_t *row = emu->gddram[p];
+            if (right) {
+                uint8_t last = row[SSD1306_EMU_COLUMNS - 1];
+                memmove(&row[1], &row[0], SSD1306_EMU_COLUMNS - 1);
+                row[0] = last;
+            } else {
+                uint8_t first = row[0];
+                memmove(&row[0], &row[1], SSD1306_EMU_COLUMNS - 1);
+                row[SSD1306_EMU_COLUMNS - 1] = first;
+            }
+        }
+        if (vertical && emu->vscroll_rows > 0) {
+            emu->vscroll_pos = (uint8_t)((emu->vscroll_pos + emu->scroll_voffset) % emu->vscroll_rows);
+        }
+        emu->stats.scroll_steps++;
+    }
+}
+
+int ssd1306_emu_get_pixel(const ssd1306_emu_t *emu, uint8_t x, uint8_t y)
+{
+    if (!emu || x >= SSD1306_EMU_COLUMNS || y > emu->mux_ratio)
+        return 0;
+    if (!emu->display_on)
+        return 0;
+    if (emu->entire_on)
+        return 1;
+    uint8_t row = emu->com_invert ? (uint8_t)(emu->mux_ratio - y) : y;
+    if (emu->scroll_active && emu->vscroll_rows > 0 && row >= emu->vscroll_top &&
+        row < emu->vscroll_top + emu->vscroll_rows) {
+        row = (uint8_t)(emu->vscroll_top +
+                (row - emu->vscroll_top + emu->vscroll_pos) % emu->vscroll_rows);
+    }
+    row = (uint8_t)((row + emu->start_line + emu->disp_offset) % SSD1306_EMU_ROWS);
+    uint8_t col = emu->seg_remap ? (uint8_t)(SSD1306_EMU_COLUMNS - 1 - x) : x;
+    int bit = (emu->gddram[row / 8][col] >> (row % 8)) & 0x1;
+    return emu->inverted ? !bit : bit;
+}
+
+bool ssd1306_emu_matches(const ssd1306_emu_t *emu, const ssd1306_framebuffer_t *fbp)
+{
+    if (!emu || !fbp || !fbp->buffer || fbp->width > SSD1306_EMU_COLUMNS ||
+        fbp->height > SSD1306_EMU_ROWS)
+        return false;
+    for (uint8_t p = 0; p < fbp->height / 8; ++p) {
+        if (memcmp(emu->gddram[p], &(fbp->buffer[p * fbp->width]), fbp->width) != 0)
+            return false;
+    }
+    return true;
+}
+
+static int ssd1306_emu_internal_transport_open(ssd1306_i2c_t *oled, void *ctx,
+        const char *dev)
+{
+    (void)dev;
+    if (!ctx) {
+        SSD1306_LOG_ERROR(oled->err, "Emulator transport needs a ssd1306_emu_t");
+        return -1;
+    }
+    return 0;
+}
+
+static int ssd1306_emu_internal_transport_write(ssd1306_i2c_t *oled, void *ctx,
+        const uint8_t *buf, size_t len)
+{
+    if (ssd1306_emu_write((ssd1306_emu_t *)ctx, buf, len) < 0) {
+        oled->err->errnum = EINVAL;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        return -1;
+    }
+    return 0;
+}
+
+const ssd1306_i2c_transport_t ssd1306_i2c_transport_emulator = {
+    .name = "emulator",
+    .open = ssd1306_emu_internal_transport_open,
+    .write_cmds = ssd1306_emu_internal_transport_write,
+    .write_data = ssd1306_emu_internal_transport_write
+};
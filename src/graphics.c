@@ -35,6 +35,7 @@
 #ifdef LIBSSD1306_HAVE_MATH_H
 #include <math.h>
 #endif
+#include <stdarg.h>
 
 #if LIBSSD1306_HAVE_DECL_STRERROR_R
 // do nothing
@@ -401,11 +402,63 @@ ssd1306_err_t *ssd1306_err_create(FILE *fp)
         free(err);
         return NULL;
     }
+    err->level = SSD1306_LOGLEVEL_INFO;
+    err->log_cb = NULL;
+    err->log_cbdata = NULL;
     SSD1306_ATOMIC_ZERO(&(err->_ref));
     SSD1306_ATOMIC_INCREMENT(&(err->_ref));
     return err;
 }
 
+void ssd1306_err_set_level(ssd1306_err_t *err, ssd1306_loglevel_t level)
+{
+    if (err) {
+        err->level = level;
+    }
+}
+
+void ssd1306_err_set_log_callback(ssd1306_err_t *err, ssd1306_log_cb_t cb, void *cbdata)
+{
+    if (err) {
+        err->log_cb = cb;
+        err->log_cbdata = cbdata;
+    }
+}
+
+// set per thread, so the realtime flush thread does not affect others
+static _Thread_local bool ssd1306_err_thread_quiet = false;
+
+void ssd1306_err_set_thread_quiet(bool quiet)
+{
+    ssd1306_err_thread_quiet = quiet;
+}
+
+void ssd1306_err_log(const ssd1306_err_t *err, ssd1306_loglevel_t level,
+                const char *fmt, ...)
+{
+    static const char *prefixes[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+    va_list ap;
+    // a quiet thread's errors only reach the callback, never stdio
+    if (ssd1306_err_thread_quiet &&
+        (level > SSD1306_LOGLEVEL_ERROR || !err || !err->log_cb))
+        return;
+    va_start(ap, fmt);
+    if (err && err->log_cb) {
+        char msg[512];
+        vsnprintf(msg, sizeof(msg), fmt, ap);
+        err->log_cb(level, msg, err->log_cbdata);
+    } else {
+        FILE *err_fp = SSD1306_ERR_GET_ERRFP(err);
+        // keep lines from several threads whole
+        flockfile(err_fp);
+        fprintf(err_fp, "%s: ", prefixes[(level <= SSD1306_LOGLEVEL_DEBUG) ? level : SSD1306_LOGLEVEL_DEBUG]);
+        vfprintf(err_fp, fmt, ap);
+        fputc('\n', err_fp);
+        funlockfile(err_fp);
+    }
+    va_end(ap);
+}
+
 void ssd1306_err_destroy(ssd1306_err_t *err)
 {
     if (err) {
@@ -427,6 +480,12 @@ void ssd1306_err_destroy(ssd1306_err_t *err)
 }
 
 ssd1306_framebuffer_t *ssd1306_framebuffer_create(uint8_t width, uint8_t height, ssd1306_err_t *err)
+{
+    return ssd1306_framebuffer_create_prefixed(width, height, 0, err);
+}
+
+ssd1306_framebuffer_t *ssd1306_framebuffer_create_prefixed(uint8_t width, uint8_t height,
+        size_t prefix_len, ssd1306_err_t *err)
 {
     FILE *err_fp = SSD1306_ERR_GET_ERRFP(err);
     if (width == 0 || height == 0) {
@@ -445,14 +504,16 @@ ssd1306_framebuffer_t *ssd1306_framebuffer_create(uint8_t width, uint8_t height,
         fbp->err = err;
         SSD1306_ERR_REF_INC(err);
         fbp->len = sizeof(uint8_t) * (fbp->width * fbp->height) / 8;
-        fbp->len = sizeof(uint8_t) * (fbp->width * fbp->height) / 8;
-        fbp->buffer = calloc(1, fbp->len);
+        fbp->buffer = calloc(1, fbp->len + prefix_len);
         if (!fbp->buffer) {
-            fprintf(err_fp, "ERROR: Failed to allocate memory of size %zu bytes\n", fbp->len);
+            fprintf(err_fp, "ERROR: Failed to allocate memory of size %zu bytes\n", fbp->len + prefix_len);
             fbp->buffer = NULL;
             rc = -1;
             break;
         }
+        // the reserved bytes sit right in front of the pixel data
+        fbp->buffer += prefix_len;
+        fbp->prefix_len = prefix_len;
         fbp->font = ssd1306_font_create(fbp->err);
         if (!fbp->font) {
             fprintf(err_fp, "ERROR: Failed to create font object, exiting\n");
@@ -477,7 +538,7 @@ void ssd1306_framebuffer_destroy(ssd1306_framebuffer_t *fbp)
         ssd1306_err_destroy(fbp->err);
         fbp->err = NULL;
         if (fbp->buffer) {
-            free(fbp->buffer);
+            free(fbp->buffer - fbp->prefix_len);
             fbp->buffer = NULL;
         }
         memset(fbp, 0, sizeof(*fbp));
@@ -0,0 +1,985 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include "ssd1306_i2c_internal.h"
+
+// an i2c-dev bus shared by the displays of a group. transactions carry the
+// display's address in every I2C_RDWR message, so switching between displays
+// costs nothing. without I2C_RDWR the I2C_SLAVE address is switched on demand.
+typedef struct {
+    char *dev;
+    int fd;
+    unsigned long funcs;
+    uint8_t slave; // address last set with I2C_SLAVE. 0 if none
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    pthread_mutex_t lock; // serializes the displays on this bus
+#endif
+} ssd1306_i2c_bus_t;
+
+#ifdef LIBSSD1306_HAVE_PTHREAD
+#define SSD1306_I2C_BUS_LOCK(B) pthread_mutex_lock(&((B)->lock))
+#define SSD1306_I2C_BUS_UNLOCK(B) pthread_mutex_unlock(&((B)->lock))
+#else
+#define SSD1306_I2C_BUS_LOCK(B) do {} while (0)
+#define SSD1306_I2C_BUS_UNLOCK(B) do {} while (0)
+#endif
+
+static int ssd1306_i2c_internal_shared_open(ssd1306_i2c_t *oled, void *ctx,
+        const char *dev)
+{
+    (void)dev;
+    ssd1306_i2c_bus_t *bus = ctx;
+    oled->fd = bus->fd;
+    oled->funcs = bus->funcs;
+    return 0;
+}
+
+static void ssd1306_i2c_internal_shared_close(ssd1306_i2c_t *oled, void *ctx)
+{
+    // the group owns the fd
+    (void)ctx;
+    oled->fd = -1;
+}
+
+static int ssd1306_i2c_internal_shared_xfer(ssd1306_i2c_t *oled, void *ctx,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_i2c_bus_t *bus = ctx;
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    int rc = 0;
+    SSD1306_I2C_BUS_LOCK(bus);
+#ifdef SSD1306_I2C_HAVE_RDWR
+    if ((oled->funcs & I2C_FUNC_I2C) && !(oled->chunk_size > 0 && oled->chunk_buffer) &&
+        nsegs <= I2C_RDWR_IOCTL_MAX_MSGS) {
+        int sent = ssd1306_i2c_internal_rdwr(oled, segs, nsegs);
+        if (sent != (int)nsegs) {
+            err->errnum = (sent < 0) ? errno : EIO;
+            strerror_r(err->errnum, err->errbuf, err->errlen);
+            rc = -1;
+        }
+    } else
+#endif
+    {
+        if (bus->slave != oled->addr) {
+            if (ioctl(bus->fd, I2C_SLAVE, (uint32_t)oled->addr) < 0) {
+                err->errnum = errno;
+                strerror_r(err->errnum, err->errbuf, err->errlen);
+                SSD1306_LOG_ERROR(err, "Failed to set I2C_SLAVE for %s addr 0x%02x: %s",
+                        bus->dev, oled->addr, err->errbuf);
+                rc = -1;
+            } else {
+                bus->slave = oled->addr;
+            }
+        }
+        if (rc == 0)
+            rc = ssd1306_i2c_internal_i2cdev_xfer(oled, NULL, segs, nsegs);
+    }
+    SSD1306_I2C_BUS_UNLOCK(bus);
+    return rc;
+}
+
+static int ssd1306_i2c_internal_shared_write(ssd1306_i2c_t *oled, void *ctx,
+        const uint8_t *buf, size_t len)
+{
+    ssd1306_i2c_seg_t seg = { buf, len };
+    return ssd1306_i2c_internal_shared_xfer(oled, ctx, &seg, 1);
+}
+
+static const ssd1306_i2c_transport_t ssd1306_i2c_transport_shared = {
+    .name = "i2c-dev shared",
+    .open = ssd1306_i2c_internal_shared_open,
+    .write_cmds = ssd1306_i2c_internal_shared_write,
+    .write_data = ssd1306_i2c_internal_shared_write,
+    .xfer = ssd1306_i2c_internal_shared_xfer,
+    .close = ssd1306_i2c_internal_shared_close,
+    .capabilities = ssd1306_i2c_internal_i2cdev_caps
+};
+
+// a display of the group. displays added with their own transport reach it
+// through relay, which holds the bus lock around every call
+typedef struct {
+    ssd1306_i2c_bus_t *bus;
+    const ssd1306_i2c_transport_t *tp; // NULL for displays on the shared i2c-dev bus
+    void *ctx;
+    ssd1306_i2c_transport_t relay;
+} ssd1306_i2c_member_t;
+
+static int ssd1306_i2c_internal_relay_open(ssd1306_i2c_t *oled, void *ctx,
+        const char *dev)
+{
+    ssd1306_i2c_member_t *m = ctx;
+    return m->tp->open ? m->tp->open(oled, m->ctx, dev) : 0;
+}
+
+static void ssd1306_i2c_internal_relay_close(ssd1306_i2c_t *oled, void *ctx)
+{
+    ssd1306_i2c_member_t *m = ctx;
+    if (m->tp->close)
+        m->tp->close(oled, m->ctx);
+}
+
+static int ssd1306_i2c_internal_relay_cmds(ssd1306_i2c_t *oled, void *ctx,
+        const uint8_t *buf, size_t len)
+{
+    ssd1306_i2c_member_t *m = ctx;
+    SSD1306_I2C_BUS_LOCK(m->bus);
+    int rc = m->tp->write_cmds(oled, m->ctx, buf, len);
+    SSD1306_I2C_BUS_UNLOCK(m->bus);
+    return rc;
+}
+
+static int ssd1306_i2c_internal_relay_data(ssd1306_i2c_t *oled, void *ctx,
+        const uint8_t *buf, size_t len)
+{
+    ssd1306_i2c_member_t *m = ctx;
+    SSD1306_I2C_BUS_LOCK(m->bus);
+    int rc = m->tp->write_data(oled, m->ctx, buf, len);
+    SSD1306_I2C_BUS_UNLOCK(m->bus);
+    return rc;
+}
+
+static int ssd1306_i2c_internal_relay_xfer(ssd1306_i2c_t *oled, void *ctx,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_i2c_member_t *m = ctx;
+    SSD1306_I2C_BUS_LOCK(m->bus);
+    int rc = m->tp->xfer(oled, m->ctx, segs, nsegs);
+    SSD1306_I2C_BUS_UNLOCK(m->bus);
+    return rc;
+}
+
+static uint32_t ssd1306_i2c_internal_relay_caps(const ssd1306_i2c_t *oled, void *ctx)
+{
+    ssd1306_i2c_member_t *m = ctx;
+    return m->tp->capabilities ? m->tp->capabilities(oled, m->ctx) : 0;
+}
+
+// transactions of one display collected for the io_uring engine
+typedef struct {
+    uint8_t *buf; // transactions back to back
+    size_t len;
+    size_t size;
+    size_t *lens; // length of each transaction
+    size_t nlens;
+    size_t lens_size;
+} ssd1306_i2c_capture_t;
+
+#ifdef SSD1306_I2C_HAVE_URING
+#define SSD1306_I2C_URING_ENTRIES 128
+typedef struct {
+    int fd;
+    unsigned entries;
+    void *sq_ptr;
+    size_t sq_len;
+    void *cq_ptr; // same as sq_ptr with IORING_FEAT_SINGLE_MMAP
+    size_t cq_len;
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned queued; // written to the queue but not submitted
+    unsigned inflight; // submitted and not completed
+} ssd1306_i2c_uring_t;
+#endif
+
+struct ssd1306_i2c_group_ {
+    ssd1306_err_t *err;
+    ssd1306_i2c_bus_t buses[SSD1306_I2C_GROUP_MAX];
+    size_t nbuses;
+    ssd1306_i2c_t *displays[SSD1306_I2C_GROUP_MAX];
+    ssd1306_i2c_member_t members[SSD1306_I2C_GROUP_MAX]; // same order as displays
+    size_t ndisplays;
+    size_t next; // display served first by the next ssd1306_i2c_group_update()
+    uint8_t *mirror_buffer; // control byte + frame for framebuffers without a prefix
+    size_t mirror_buffer_len;
+    ssd1306_i2c_engine_t engine;
+    // io_uring engine. every display gets its own fd with I2C_SLAVE set, so
+    // plain write()s of different displays can be in flight together
+    int engine_fds[SSD1306_I2C_GROUP_MAX]; // -1 until needed
+    ssd1306_i2c_capture_t captures[SSD1306_I2C_GROUP_MAX];
+#ifdef SSD1306_I2C_HAVE_URING
+    ssd1306_i2c_uring_t ring;
+#endif
+};
+
+#ifdef SSD1306_I2C_HAVE_URING
+static void ssd1306_i2c_internal_uring_destroy(ssd1306_i2c_uring_t *ring)
+{
+    if (ring->sqes)
+        munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ptr && ring->cq_ptr != ring->sq_ptr)
+        munmap(ring->cq_ptr, ring->cq_len);
+    if (ring->sq_ptr)
+        munmap(ring->sq_ptr, ring->sq_len);
+    if (ring->fd >= 0)
+        close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+// sets up the rings with the raw system calls. returns 0 on success and -1
+// with errno set if the kernel does not support io_uring
+static int ssd1306_i2c_internal_uring_setup(ssd1306_i2c_uring_t *ring, unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (ring->fd < 0)
+        return -1;
+    ring->entries = params.sq_entries;
+    ring->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) ? true : false;
+    if (single && ring->cq_len > ring->sq_len)
+        ring->sq_len = ring->cq_len;
+    void *ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    ring->fd, IORING_OFF_SQ_RING);
+    if (ptr == MAP_FAILED) {
+        int errnum = errno;
+        ssd1306_i2c_internal_uring_destroy(ring);
+        errno = errnum;
+        return -1;
+    }
+    ring->sq_ptr = ptr;
+    if (single) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    ring->fd, IORING_OFF_CQ_RING);
+        if (ptr == MAP_FAILED) {
+            int errnum = errno;
+            ssd1306_i2c_internal_uring_destroy(ring);
+            errno = errnum;
+            return -1;
+        }
+        ring->cq_ptr = ptr;
+    }
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ptr = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    ring->fd, IORING_OFF_SQES);
+    if (ptr == MAP_FAILED) {
+        int errnum = errno;
+        ssd1306_i2c_internal_uring_destroy(ring);
+        errno = errnum;
+        return -1;
+    }
+    ring->sqes = ptr;
+    uint8_t *sq = ring->sq_ptr;
+    uint8_t *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+// queues a write() of one transaction. link keeps it ordered before the next
+// one. returns -1 with errno set to EBUSY if the queue is full
+static int ssd1306_i2c_internal_uring_write(ssd1306_i2c_uring_t *ring, int fd,
+        const uint8_t *buf, size_t len, uint64_t user_data, bool link)
+{
+    unsigned tail = *(ring->sq_tail);
+    if (tail - SSD1306_ATOMIC_LOAD(ring->sq_head) >= ring->entries) {
+        errno = EBUSY;
+        return -1;
+    }
+    unsigned idx = tail & *(ring->sq_mask);
+    struct io_uring_sqe *sqe = &(ring->sqes[idx]);
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->off = (uint64_t)-1; // the current position, i2c-dev ignores it
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (uint32_t)len;
+    sqe->flags = link ? IOSQE_IO_LINK : 0;
+    sqe->user_data = user_data;
+    ring->sq_array[idx] = idx;
+    SSD1306_ATOMIC_SET(ring->sq_tail, tail + 1);
+    ring->queued++;
+    return 0;
+}
+
+// submits what is queued and waits for min_complete completions in the same
+// system call
+static int ssd1306_i2c_internal_uring_enter(ssd1306_i2c_uring_t *ring, unsigned min_complete)
+{
+    unsigned flags = (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0;
+    int ret = 0;
+    do {
+        ret = (int)syscall(__NR_io_uring_enter, ring->fd, ring->queued, min_complete,
+                    flags, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    if (ret < 0)
+        return -1;
+    ring->queued -= (unsigned)ret;
+    ring->inflight += (unsigned)ret;
+    return 0;
+}
+#endif
+
+ssd1306_i2c_group_t *ssd1306_i2c_group_create(FILE *logerr)
+{
+    FILE *err_fp = logerr == NULL ? stderr : logerr;
+    ssd1306_i2c_group_t *grp = calloc(1, sizeof(*grp));
+    if (!grp) {
+        fprintf(err_fp, "ERROR: Failed to allocate memory of size %zu bytes\n", sizeof(*grp));
+        return NULL;
+    }
+    grp->err = ssd1306_err_create(err_fp);
+    if (!grp->err) {
+        free(grp);
+        return NULL;
+    }
+#ifdef SSD1306_I2C_HAVE_URING
+    grp->ring.fd = -1;
+#endif
+    return grp;
+}
+
+void ssd1306_i2c_group_destroy(ssd1306_i2c_group_t *grp)
+{
+    if (!grp)
+        return;
+    for (size_t idx = 0; idx < grp->ndisplays; ++idx) {
+        ssd1306_i2c_close(grp->displays[idx]);
+        grp->displays[idx] = NULL;
+    }
+    for (size_t idx = 0; idx < grp->nbuses; ++idx) {
+        ssd1306_i2c_bus_t *bus = &(grp->buses[idx]);
+        if (bus->fd >= 0)
+            close(bus->fd);
+        if (bus->dev)
+            free(bus->dev);
+#ifdef LIBSSD1306_HAVE_PTHREAD
+        pthread_mutex_destroy(&(bus->lock));
+#endif
+    }
+    for (size_t idx = 0; idx < grp->ndisplays; ++idx) {
+        if (grp->engine_fds[idx] >= 0)
+            close(grp->engine_fds[idx]);
+        free(grp->captures[idx].buf);
+        free(grp->captures[idx].lens);
+    }
+#ifdef SSD1306_I2C_HAVE_URING
+    ssd1306_i2c_internal_uring_destroy(&(grp->ring));
+#endif
+    if (grp->mirror_buffer)
+        free(grp->mirror_buffer);
+    ssd1306_err_destroy(grp->err);
+    memset(grp, 0, sizeof(*grp));
+    free(grp);
+}
+
+// finds the bus named dev or adds it. the device is opened only if open_dev
+// is set, buses of displays with their own transport have no fd
+static ssd1306_i2c_bus_t *ssd1306_i2c_internal_group_bus(ssd1306_i2c_group_t *grp,
+        const char *dev, bool open_dev)
+{
+    ssd1306_err_t *err = grp->err;
+    for (size_t idx = 0; idx < grp->nbuses; ++idx) {
+        ssd1306_i2c_bus_t *bus = &(grp->buses[idx]);
+        if (strcmp(bus->dev, dev) != 0)
+            continue;
+        if (open_dev && bus->fd < 0) {
+            SSD1306_LOG_ERROR(err, "Bus %s of the group is not an i2c-dev device", dev);
+            return NULL;
+        }
+        return bus;
+    }
+    if (grp->nbuses >= SSD1306_I2C_GROUP_MAX) {
+        SSD1306_LOG_ERROR(err, "Display group cannot have more than %d buses",
+                SSD1306_I2C_GROUP_MAX);
+        return NULL;
+    }
+    ssd1306_i2c_bus_t *bus = &(grp->buses[grp->nbuses]);
+    memset(bus, 0, sizeof(*bus));
+    bus->dev = strdup(dev);
+    if (!bus->dev) {
+        SSD1306_LOG_ERROR(err, "Failed to copy device name: %s", dev);
+        return NULL;
+    }
+    bus->fd = -1;
+    if (!open_dev) {
+#ifdef LIBSSD1306_HAVE_PTHREAD
+        pthread_mutex_init(&(bus->lock), NULL);
+#endif
+        grp->nbuses++;
+        return bus;
+    }
+    bus->fd = open(dev, O_RDWR);
+    if (bus->fd < 0) {
+        err->errnum = errno;
+        strerror_r(err->errnum, err->errbuf, err->errlen);
+        SSD1306_LOG_ERROR(err, "Failed to open %s in read/write mode: %s",
+                dev, err->errbuf);
+        free(bus->dev);
+        bus->dev = NULL;
+        return NULL;
+    }
+    if (ioctl(bus->fd, I2C_FUNCS, &(bus->funcs)) < 0) {
+        SSD1306_LOG_WARN(err, "I2C Function mask not available for %s. Using write()",
+                dev);
+        bus->funcs = 0;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    pthread_mutex_init(&(bus->lock), NULL);
+#endif
+    SSD1306_LOG_INFO(err, "Opened shared bus %s at fd %d with function mask 0x%08lx",
+            dev, bus->fd, bus->funcs);
+    grp->nbuses++;
+    return bus;
+}
+
+// every error object closes its stream, so each display logs to its own copy
+// of the group's
+static FILE *ssd1306_i2c_internal_group_logerr(ssd1306_i2c_group_t *grp)
+{
+    FILE *fp = grp->err->err_fp;
+    if (!fp || fp == stderr)
+        return stderr;
+    fflush(fp);
+    int fd = dup(fileno(fp));
+    FILE *copy = (fd >= 0) ? fdopen(fd, "a") : NULL;
+    if (!copy) {
+        if (fd >= 0)
+            close(fd);
+        SSD1306_LOG_WARN(grp->err, "Cannot copy the log stream. Display logs to stderr");
+        return stderr;
+    }
+    return copy;
+}
+
+// opens a display on bus through the shared bus, or through relay to tp if
+// tp is set, and adds it to the group
+static ssd1306_i2c_t *ssd1306_i2c_internal_group_add(ssd1306_i2c_group_t *grp,
+        const ssd1306_i2c_transport_t *tp, void *ctx, const char *dev,
+        uint8_t addr, uint8_t width, uint8_t height)
+{
+    ssd1306_err_t *err = grp->err;
+    if (grp->ndisplays >= SSD1306_I2C_GROUP_MAX) {
+        SSD1306_LOG_ERROR(err, "Display group cannot have more than %d displays",
+                SSD1306_I2C_GROUP_MAX);
+        return NULL;
+    }
+    ssd1306_i2c_bus_t *bus = ssd1306_i2c_internal_group_bus(grp, dev, (tp == NULL));
+    if (!bus)
+        return NULL;
+    ssd1306_i2c_member_t *m = &(grp->members[grp->ndisplays]);
+    memset(m, 0, sizeof(*m));
+    m->bus = bus;
+    ssd1306_i2c_t *oled = NULL;
+    if (tp) {
+        m->tp = tp;
+        m->ctx = ctx;
+        m->relay.name = tp->name;
+        m->relay.open = ssd1306_i2c_internal_relay_open;
+        m->relay.write_cmds = ssd1306_i2c_internal_relay_cmds;
+        m->relay.write_data = ssd1306_i2c_internal_relay_data;
+        // without xfer() the library applies chunk_size itself
+        m->relay.xfer = tp->xfer ? ssd1306_i2c_internal_relay_xfer : NULL;
+        m->relay.close = ssd1306_i2c_internal_relay_close;
+        m->relay.capabilities = ssd1306_i2c_internal_relay_caps;
+        oled = ssd1306_i2c_open_transport(&(m->relay), m, dev, addr, width, height,
+                    ssd1306_i2c_internal_group_logerr(grp));
+    } else {
+        oled = ssd1306_i2c_open_transport(&ssd1306_i2c_transport_shared,
+                    bus, dev, addr, width, height, ssd1306_i2c_internal_group_logerr(grp));
+    }
+    if (!oled)
+        return NULL;
+    for (size_t idx = 0; idx < grp->ndisplays; ++idx) {
+        if (grp->members[idx].bus == bus && grp->displays[idx]->addr == oled->addr) {
+            SSD1306_LOG_ERROR(err, "Display 0x%02x on %s is already in the group",
+                    oled->addr, dev);
+            ssd1306_i2c_close(oled);
+            return NULL;
+        }
+    }
+    grp->engine_fds[grp->ndisplays] = -1;
+    grp->displays[grp->ndisplays++] = oled;
+    return oled;
+}
+
+ssd1306_i2c_t *ssd1306_i2c_group_add(ssd1306_i2c_group_t *grp, const char *dev,
+        uint8_t addr, uint8_t width, uint8_t height)
+{
+    if (!grp || !dev) {
+        ssd1306_err_t *err = grp ? grp->err : NULL;
+        SSD1306_LOG_ERROR(err, "Invalid display group or device");
+        return NULL;
+    }
+    return ssd1306_i2c_internal_group_add(grp, NULL, NULL, dev, addr, width, height);
+}
+
+ssd1306_i2c_t *ssd1306_i2c_group_add_transport(ssd1306_i2c_group_t *grp,
+        const ssd1306_i2c_transport_t *transport, void *ctx, const char *bus,
+        uint8_t addr, uint8_t width, uint8_t height)
+{
+    if (!grp || !transport || !transport->write_cmds || !transport->write_data || !bus) {
+        ssd1306_err_t *err = grp ? grp->err : NULL;
+        SSD1306_LOG_ERROR(err, "Invalid display group, transport or bus name");
+        return NULL;
+    }
+    return ssd1306_i2c_internal_group_add(grp, transport, ctx, bus, addr, width, height);
+}
+
+size_t ssd1306_i2c_group_size(const ssd1306_i2c_group_t *grp)
+{
+    return grp ? grp->ndisplays : 0;
+}
+
+ssd1306_i2c_t *ssd1306_i2c_group_get(ssd1306_i2c_group_t *grp, size_t idx)
+{
+    return (grp && idx < grp->ndisplays) ? grp->displays[idx] : NULL;
+}
+
+int ssd1306_i2c_group_display_initialize(ssd1306_i2c_group_t *grp)
+{
+    if (!grp)
+        return -1;
+    int rc = 0;
+    for (size_t idx = 0; idx < grp->ndisplays; ++idx) {
+        if (ssd1306_i2c_display_initialize(grp->displays[idx]) < 0)
+            rc = -1;
+    }
+    return rc;
+}
+
+// updates the displays on bus, or all of them if bus is NULL, in group order
+// from start
+static int ssd1306_i2c_internal_group_serial(ssd1306_i2c_group_t *grp,
+        const ssd1306_framebuffer_t *const *fbps, const ssd1306_i2c_bus_t *bus,
+        size_t start)
+{
+    int rc = 0;
+    for (size_t k = 0; k < grp->ndisplays; ++k) {
+        size_t idx = (start + k) % grp->ndisplays;
+        if (!fbps[idx] || (bus && grp->members[idx].bus != bus))
+            continue;
+        if (ssd1306_i2c_display_update(grp->displays[idx], fbps[idx]) < 0)
+            rc = -1;
+    }
+    return rc;
+}
+
+#ifdef LIBSSD1306_HAVE_PTHREAD
+typedef struct {
+    ssd1306_i2c_group_t *grp;
+    const ssd1306_framebuffer_t *const *fbps;
+    const ssd1306_i2c_bus_t *bus;
+    size_t start;
+    int rc;
+} ssd1306_i2c_group_job_t;
+
+static void *ssd1306_i2c_internal_group_worker(void *arg)
+{
+    ssd1306_i2c_group_job_t *job = arg;
+    job->rc = ssd1306_i2c_internal_group_serial(job->grp, job->fbps, job->bus, job->start);
+    return NULL;
+}
+
+// one thread per bus. the calling thread takes the first bus
+static int ssd1306_i2c_internal_group_threads(ssd1306_i2c_group_t *grp,
+        const ssd1306_framebuffer_t *const *fbps, size_t start)
+{
+    if (grp->nbuses < 2)
+        return ssd1306_i2c_internal_group_serial(grp, fbps, NULL, start);
+    ssd1306_i2c_group_job_t jobs[SSD1306_I2C_GROUP_MAX];
+    pthread_t threads[SSD1306_I2C_GROUP_MAX];
+    bool started[SSD1306_I2C_GROUP_MAX] = { false };
+    for (size_t b = 0; b < grp->nbuses; ++b) {
+        jobs[b].grp = grp;
+        jobs[b].fbps = fbps;
+        jobs[b].bus = &(grp->buses[b]);
+        jobs[b].start = start;
+        jobs[b].rc = 0;
+        if (b > 0) {
+            started[b] = (pthread_create(&threads[b], NULL,
+                            ssd1306_i2c_internal_group_worker, &jobs[b]) == 0);
+        }
+    }
+    for (size_t b = 0; b < grp->nbuses; ++b) {
+        if (!started[b])
+            ssd1306_i2c_internal_group_worker(&jobs[b]);
+    }
+    int rc = 0;
+    for (size_t b = 0; b < grp->nbuses; ++b) {
+        if (started[b])
+            pthread_join(threads[b], NULL);
+        if (jobs[b].rc < 0)
+            rc = -1;
+    }
+    return rc;
+}
+#endif
+
+#ifdef SSD1306_I2C_HAVE_URING
+// backend that collects the transactions of a display for the io_uring engine
+// while its update is encoded
+static int ssd1306_i2c_internal_capture_xfer(ssd1306_i2c_t *oled, void *ctx,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_i2c_capture_t *cap = ctx;
+    for (size_t idx = 0; idx < nsegs; ++idx) {
+        if (cap->len + segs[idx].len > cap->size) {
+            size_t size = cap->size ? cap->size : 2048;
+            while (size < cap->len + segs[idx].len)
+                size *= 2;
+            uint8_t *buf = realloc(cap->buf, size);
+            if (!buf) {
+                oled->err->errnum = ENOMEM;
+                strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+                return -1;
+            }
+            cap->buf = buf;
+            cap->size = size;
+        }
+        if (cap->nlens == cap->lens_size) {
+            size_t size = cap->lens_size ? 2 * cap->lens_size : 16;
+            size_t *lens = realloc(cap->lens, size * sizeof(size_t));
+            if (!lens) {
+                oled->err->errnum = ENOMEM;
+                strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+                return -1;
+            }
+            cap->lens = lens;
+            cap->lens_size = size;
+        }
+        memcpy(&(cap->buf[cap->len]), segs[idx].buf, segs[idx].len);
+        cap->len += segs[idx].len;
+        cap->lens[cap->nlens++] = segs[idx].len;
+    }
+    return 0;
+}
+
+static int ssd1306_i2c_internal_capture_write(ssd1306_i2c_t *oled, void *ctx,
+        const uint8_t *buf, size_t len)
+{
+    ssd1306_i2c_seg_t seg = { buf, len };
+    return ssd1306_i2c_internal_capture_xfer(oled, ctx, &seg, 1);
+}
+
+static const ssd1306_i2c_transport_t ssd1306_i2c_transport_capture = {
+    .name = "capture",
+    .write_cmds = ssd1306_i2c_internal_capture_write,
+    .write_data = ssd1306_i2c_internal_capture_write,
+    .xfer = ssd1306_i2c_internal_capture_xfer
+};
+
+// returns the display's own fd for write(), or -1 if the display has to be
+// updated through the shared bus
+static int ssd1306_i2c_internal_group_engine_fd(ssd1306_i2c_group_t *grp, size_t idx)
+{
+    ssd1306_i2c_t *oled = grp->displays[idx];
+    ssd1306_err_t *err = grp->err;
+    // write() needs a real I2C adapter and takes a whole transaction
+    if (grp->members[idx].tp || !(oled->funcs & I2C_FUNC_I2C) ||
+        (oled->chunk_size > 0 && oled->chunk_buffer) || oled->arbiter)
+        return -1;
+    if (grp->engine_fds[idx] != -1)
+        return (grp->engine_fds[idx] >= 0) ? grp->engine_fds[idx] : -1;
+    const ssd1306_i2c_bus_t *bus = grp->members[idx].bus;
+    int fd = open(bus->dev, O_RDWR);
+    if (fd < 0 || ioctl(fd, I2C_SLAVE, (uint32_t)oled->addr) < 0) {
+        err->errnum = errno;
+        strerror_r(err->errnum, err->errbuf, err->errlen);
+        SSD1306_LOG_WARN(err, "Cannot open %s for addr 0x%02x: %s. Using the shared bus",
+                bus->dev, oled->addr, err->errbuf);
+        if (fd >= 0)
+            close(fd);
+        grp->engine_fds[idx] = -2; // do not try again
+        return -1;
+    }
+    grp->engine_fds[idx] = fd;
+    return fd;
+}
+
+// collects finished writes. the low 32 bits of user_data are the expected
+// length and the high 32 bits the display
+static void ssd1306_i2c_internal_group_reap(ssd1306_i2c_group_t *grp, bool *failed)
+{
+    ssd1306_i2c_uring_t *ring = &(grp->ring);
+    unsigned head = *(ring->cq_head);
+    unsigned tail = SSD1306_ATOMIC_LOAD(ring->cq_tail);
+    for (; head != tail; ++head) {
+        const struct io_uring_cqe *cqe = &(ring->cqes[head & *(ring->cq_mask)]);
+        size_t idx = (size_t)(cqe->user_data >> 32);
+        if (cqe->res != (int32_t)(cqe->user_data & 0xFFFFFFFF) && idx < grp->ndisplays) {
+            if (!failed[idx]) {
+                ssd1306_err_t *err = grp->displays[idx]->err;
+                err->errnum = (cqe->res < 0) ? -cqe->res : EIO;
+                strerror_r(err->errnum, err->errbuf, err->errlen);
+            }
+            failed[idx] = true;
+        }
+        ring->inflight--;
+    }
+    SSD1306_ATOMIC_SET(ring->cq_head, head);
+}
+
+// submits everything queued and waits for all of it
+static int ssd1306_i2c_internal_group_drain(ssd1306_i2c_group_t *grp, bool *failed)
+{
+    ssd1306_i2c_uring_t *ring = &(grp->ring);
+    if (ring->queued > 0) {
+        // a chain cannot continue into the next submission
+        unsigned last = (*(ring->sq_tail) - 1) & *(ring->sq_mask);
+        ring->sqes[last].flags &= (uint8_t)~IOSQE_IO_LINK;
+    }
+    while (ring->queued + ring->inflight > 0) {
+        if (ssd1306_i2c_internal_uring_enter(ring, ring->queued + ring->inflight) < 0)
+            return -1;
+        ssd1306_i2c_internal_group_reap(grp, failed);
+    }
+    return 0;
+}
+
+// encodes every display's update, queues the transactions as write()s on
+// the displays' own fds and submits them together. the transactions of one
+// display are linked so they stay in order, the kernel runs the displays in
+// parallel. displays that cannot be written this way are updated while the
+// submission is on the buses
+static int ssd1306_i2c_internal_group_uring(ssd1306_i2c_group_t *grp,
+        const ssd1306_framebuffer_t *const *fbps, size_t start)
+{
+    ssd1306_err_t *err = grp->err;
+    ssd1306_i2c_uring_t *ring = &(grp->ring);
+    bool failed[SSD1306_I2C_GROUP_MAX] = { false };
+    bool queued[SSD1306_I2C_GROUP_MAX] = { false };
+    bool direct[SSD1306_I2C_GROUP_MAX] = { false };
+    int rc = 0;
+    for (size_t k = 0; k < grp->ndisplays; ++k) {
+        size_t idx = (start + k) % grp->ndisplays;
+        ssd1306_i2c_t *oled = grp->displays[idx];
+        if (!fbps[idx])
+            continue;
+        int fd = ssd1306_i2c_internal_group_engine_fd(grp, idx);
+        if (fd < 0) {
+            direct[idx] = true;
+            continue;
+        }
+        // held until the writes complete, so the flush thread cannot get in between
+        SSD1306_I2C_LOCK(oled);
+        queued[idx] = true;
+        ssd1306_i2c_capture_t *cap = &(grp->captures[idx]);
+        cap->len = 0;
+        cap->nlens = 0;
+        const ssd1306_i2c_transport_t *tp = oled->transport;
+        void *ctx = oled->transport_ctx;
+        oled->transport = &ssd1306_i2c_transport_capture;
+        oled->transport_ctx = cap;
+        int urc = ssd1306_i2c_display_update(oled, fbps[idx]);
+        oled->transport = tp;
+        oled->transport_ctx = ctx;
+        if (urc < 0) {
+            failed[idx] = true;
+            continue;
+        }
+        size_t off = 0;
+        for (size_t s = 0; s < cap->nlens; ++s) {
+            if (ring->queued + ring->inflight >= ring->entries &&
+                ssd1306_i2c_internal_group_drain(grp, failed) < 0) {
+                break;
+            }
+            uint64_t user_data = ((uint64_t)idx << 32) | (uint64_t)cap->lens[s];
+            if (ssd1306_i2c_internal_uring_write(ring, fd, &(cap->buf[off]), cap->lens[s],
+                        user_data, (s + 1 < cap->nlens)) < 0) {
+                break;
+            }
+            off += cap->lens[s];
+        }
+        if (off != cap->len) {
+            err->errnum = errno;
+            strerror_r(err->errnum, err->errbuf, err->errlen);
+            SSD1306_LOG_ERROR(err, "Failed to submit to io_uring: %s", err->errbuf);
+            failed[idx] = true;
+        }
+    }
+    if (ssd1306_i2c_internal_uring_enter(ring, 0) < 0) {
+        err->errnum = errno;
+        strerror_r(err->errnum, err->errbuf, err->errlen);
+        SSD1306_LOG_ERROR(err, "Failed to submit to io_uring: %s", err->errbuf);
+    }
+    for (size_t k = 0; k < grp->ndisplays; ++k) {
+        size_t idx = (start + k) % grp->ndisplays;
+        if (direct[idx] && ssd1306_i2c_display_update(grp->displays[idx], fbps[idx]) < 0)
+            rc = -1;
+    }
+    if (ssd1306_i2c_internal_group_drain(grp, failed) < 0) {
+        // the kernel still owns the buffers, so wait for it to give up
+        err->errnum = errno;
+        strerror_r(err->errnum, err->errbuf, err->errlen);
+        SSD1306_LOG_ERROR(err, "Failed to wait for io_uring: %s. Closing it", err->errbuf);
+        ssd1306_i2c_internal_uring_destroy(ring);
+        grp->engine = SSD1306_I2C_ENGINE_THREADS;
+        for (size_t idx = 0; idx < grp->ndisplays; ++idx)
+            failed[idx] = failed[idx] || queued[idx];
+    }
+    for (size_t k = grp->ndisplays; k > 0; --k) {
+        size_t idx = (start + k - 1) % grp->ndisplays;
+        if (!queued[idx])
+            continue;
+        ssd1306_i2c_t *oled = grp->displays[idx];
+        if (failed[idx]) {
+            // unknown how much of it arrived
+            SSD1306_LOG_ERROR(err, "Failed to update display 0x%02x: %s", oled->addr,
+                    oled->err->errbuf);
+            oled->regcache.valid = 0;
+            oled->shadow_valid = false;
+            rc = -1;
+        }
+        SSD1306_I2C_UNLOCK(oled);
+    }
+    return rc;
+}
+#endif
+
+int ssd1306_i2c_group_set_engine(ssd1306_i2c_group_t *grp, ssd1306_i2c_engine_t engine)
+{
+    ssd1306_err_t *err = grp ? grp->err : NULL;
+    if (!grp || engine < SSD1306_I2C_ENGINE_SERIAL || engine > SSD1306_I2C_ENGINE_URING) {
+        SSD1306_LOG_ERROR(err, "Invalid display group or engine");
+        return -1;
+    }
+    if (engine == SSD1306_I2C_ENGINE_URING) {
+#ifdef SSD1306_I2C_HAVE_URING
+        if (grp->ring.fd < 0 &&
+            ssd1306_i2c_internal_uring_setup(&(grp->ring), SSD1306_I2C_URING_ENTRIES) < 0) {
+            err->errnum = errno;
+            strerror_r(err->errnum, err->errbuf, err->errlen);
+            SSD1306_LOG_WARN(err, "io_uring not available: %s. Using a thread per bus",
+                    err->errbuf);
+            engine = SSD1306_I2C_ENGINE_THREADS;
+        }
+#else
+        SSD1306_LOG_WARN(err, "Library built without io_uring support. Using a thread per bus");
+        engine = SSD1306_I2C_ENGINE_THREADS;
+#endif
+    }
+#ifndef LIBSSD1306_HAVE_PTHREAD
+    if (engine == SSD1306_I2C_ENGINE_THREADS) {
+        SSD1306_LOG_WARN(err, "Library built without threading support. Updating displays in turn");
+        engine = SSD1306_I2C_ENGINE_SERIAL;
+    }
+#endif
+#ifdef SSD1306_I2C_HAVE_URING
+    if (engine != SSD1306_I2C_ENGINE_URING && grp->ring.fd >= 0)
+        ssd1306_i2c_internal_uring_destroy(&(grp->ring));
+#endif
+    grp->engine = engine;
+    SSD1306_LOG_INFO(err, "Display group uses engine %d", (int)engine);
+    return (int)engine;
+}
+
+int ssd1306_i2c_group_update(ssd1306_i2c_group_t *grp,
+        const ssd1306_framebuffer_t *const *fbps, size_t nfbps)
+{
+    ssd1306_err_t *err = grp ? grp->err : NULL;
+    if (!grp || !fbps || nfbps != grp->ndisplays) {
+        SSD1306_LOG_ERROR(err, "Need one framebuffer pointer per display in the group");
+        return -1;
+    }
+    if (grp->ndisplays == 0)
+        return 0;
+    // start with a different display every time so that no display always
+    // waits for all the others
+    size_t start = grp->next;
+    grp->next = (start + 1) % grp->ndisplays;
+    switch (grp->engine) {
+#ifdef SSD1306_I2C_HAVE_URING
+    case SSD1306_I2C_ENGINE_URING:
+        return ssd1306_i2c_internal_group_uring(grp, fbps, start);
+#endif
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    case SSD1306_I2C_ENGINE_THREADS:
+        return ssd1306_i2c_internal_group_threads(grp, fbps, start);
+#endif
+    default:
+        return ssd1306_i2c_internal_group_serial(grp, fbps, NULL, start);
+    }
+}
+
+// marks the frame as what the display now shows, or invalidates the shadow
+static void ssd1306_i2c_internal_mirror_done(ssd1306_i2c_t *oled,
+        const ssd1306_framebuffer_t *fbp, bool ok)
+{
+    if (oled->shadow_buffer) {
+        if (ok)
+            memcpy(oled->shadow_buffer, fbp->buffer, fbp->len);
+        oled->shadow_valid = ok;
+    }
+}
+
+int ssd1306_i2c_group_mirror(ssd1306_i2c_group_t *grp, const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = grp ? grp->err : NULL;
+    if (!grp || !fbp || !fbp->buffer || fbp->len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid display group or framebuffer object");
+        return -1;
+    }
+    // the address window and the data stream are encoded once for all displays
+    uint8_t cmds[2 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    size_t clen = ssd1306_i2c_internal_encode_window(err, 0, fbp->width - 1,
+                        0, (fbp->height / 8) - 1, cmds, sizeof(cmds));
+    if (clen == 0)
+        return -1;
+    const uint8_t *xfer = ssd1306_i2c_internal_fb_xfer(fbp);
+    if (!xfer) {
+        if (grp->mirror_buffer_len < fbp->len + 1) {
+            uint8_t *buf = realloc(grp->mirror_buffer, fbp->len + 1);
+            if (!buf) {
+                SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for mirror buffer",
+                        fbp->len + 1);
+                return -1;
+            }
+            grp->mirror_buffer = buf;
+            grp->mirror_buffer_len = fbp->len + 1;
+        }
+        grp->mirror_buffer[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+        memcpy(&(grp->mirror_buffer[1]), fbp->buffer, fbp->len);
+        xfer = grp->mirror_buffer;
+    }
+    ssd1306_i2c_seg_t segs[2] = {
+        { cmds, clen },
+        { xfer, fbp->len + 1 }
+    };
+    int rc = 0;
+    for (size_t idx = 0; idx < grp->ndisplays; ++idx) {
+        ssd1306_i2c_t *oled = grp->displays[idx];
+        if (oled->width != fbp->width || oled->height != fbp->height) {
+            SSD1306_LOG_ERROR(err, "Display 0x%02x on %s is %ux%u, the framebuffer is %ux%u",
+                    oled->addr, oled->dev, oled->width, oled->height, fbp->width, fbp->height);
+            rc = -1;
+            continue;
+        }
+        if (oled->profile->page_addressing_only || oled->profile->column_offset != 0) {
+            // the shared window commands do not fit this controller
+            if (ssd1306_i2c_display_update(oled, fbp) < 0)
+                rc = -1;
+            continue;
+        }
+        // the display's own transfer path keeps its register cache, capture,
+        // effects and bus arbitration in step
+        SSD1306_I2C_LOCK(oled);
+        bool ok = (ssd1306_i2c_internal_xfer(oled, segs, 2) == 0);
+        ssd1306_i2c_internal_mirror_done(oled, fbp, ok);
+        SSD1306_I2C_UNLOCK(oled);
+        if (!ok)
+            rc = -1;
+    }
+    return rc;
+}
@@ -4,62 +4,41 @@
  * SOFTWARE: libssd1306-i2c
  * LICENSE: Refer license file
  */
-#include <ssd1306_config.h>
-#ifdef LIBSSD1306_HAVE_FEATURES_H
-#include <features.h>
-#endif
-#ifdef LIBSSD1306_HAVE_ERRNO_H
-#include <errno.h>
-#endif
-#ifdef LIBSSD1306_HAVE_UNISTD_H
-#include <unistd.h>
-#endif
-#ifdef LIBSSD1306_HAVE_FCNTL_H
-#include <fcntl.h>
-#endif
-#ifdef LIBSSD1306_HAVE_SYS_IOCTL_H
-#include <sys/ioctl.h>
-#endif
-#ifdef LIBSSD1306_HAVE_STDIO_H
-#include <stdio.h>
-#endif
-#ifdef LIBSSD1306_HAVE_STRING_H
-#include <string.h>
-#endif
-#ifdef LIBSSD1306_HAVE_STDLIB_H
-#include <stdlib.h>
-#endif
+#include "ssd1306_i2c_internal.h"
 
-#if LIBSSD1306_HAVE_LINUX_I2C_DEV_H
-#include <linux/i2c-dev.h>
-#else
-#warning "You need to install libi2c-dev and i2c-tools"
-// forcibly defining the ioctl number
-#undef I2C_SLAVE
-#define I2C_SLAVE 0x0703
-#undef I2C_FUNCS
-#define I2C_FUNCS 0x0705
-#undef I2C_SMBUS
-#undef I2C_SMBUS
-#define I2C_SMBUS 0x0720
-#endif
-#if LIBSSD1306_HAVE_I2C_SMBUS_H
-#include <i2c/smbus.h>
+#ifdef SSD1306_I2C_HAVE_REALTIME
+// faults in every page of buf and keeps them resident. returns 0 or the errno
+static int ssd1306_i2c_internal_mlock(void *buf, size_t len)
+{
+    volatile uint8_t *p = buf;
+    for (size_t off = 0; off < len; off += 4096)
+        p[off] = p[off];
+    return (mlock(buf, len) < 0) ? errno : 0;
+}
 #endif
-#include <ssd1306_i2c.h>
 
-#if LIBSSD1306_HAVE_DECL_STRERROR_R
-// do nothing
+// buffers created or freed after a realtime flush thread locked its memory
+// follow suit. called with the lock guarding buf held
+static void ssd1306_i2c_internal_rt_lock(ssd1306_i2c_t *oled, void *buf, size_t len, bool lock)
+{
+#ifdef SSD1306_I2C_HAVE_REALTIME
+    if (!oled->async || !oled->async->locked || !buf || len == 0)
+        return;
+    if (!lock) {
+        munlock(buf, len);
+        return;
+    }
+    int rc = ssd1306_i2c_internal_mlock(buf, len);
+    if (rc != 0) {
+        SSD1306_LOG_WARN(oled->err, "Unable to lock %zu bytes in memory. errno %d", len, rc);
+    }
 #else
-// rewrite it
-#warning "strerror_r is reentrant. strerror is not, so removing usage of strerror_r"
-#define strerror_r(A,B,C) do {} while (0)
+    (void)oled;
+    (void)buf;
+    (void)len;
+    (void)lock;
 #endif
-
-// helpful macros
-#ifndef SSD1306_I2C_GET_ERRFP
-#define SSD1306_I2C_GET_ERRFP(P) ((P) != NULL && (P)->err != NULL && (P)->err->err_fp != NULL) ? (P)->err->err_fp : stderr
-#endif // SSD1306_I2C_GET_ERRFP
+}
 
 ssd1306_i2c_t *ssd1306_i2c_open(
         const char *dev, // name of the device such as /dev/i2c-1. cannot be NULL
@@ -68,13 +47,31 @@ ssd1306_i2c_t *ssd1306_i2c_open(
         uint8_t height, // OLED display height. valid values: 0 (default) or 32 or 64
         FILE *logerr
     )
+{
+    if (!dev) {
+        fprintf(logerr == NULL ? stderr : logerr, "ERROR: No device given.\n");
+        return NULL;
+    }
+    return ssd1306_i2c_open_transport(&ssd1306_i2c_transport_i2cdev, NULL,
+            dev, addr, width, height, logerr);
+}
+
+ssd1306_i2c_t *ssd1306_i2c_open_transport(
+        const ssd1306_i2c_transport_t *transport,
+        void *ctx,
+        const char *dev,
+        uint8_t addr,
+        uint8_t width,
+        uint8_t height,
+        FILE *logerr
+    )
 {
     ssd1306_i2c_t *oled = NULL;
     int rc = 0;
     FILE *err_fp = logerr == NULL ? stderr : logerr;
     do {
-        if (!dev) {
-            fprintf(err_fp, "ERROR: No device given.\n");
+        if (!transport || !transport->write_cmds || !transport->write_data) {
+            fprintf(err_fp, "ERROR: Invalid transport given.\n");
             rc = -1;
             break;
         }
@@ -90,11 +87,25 @@ ssd1306_i2c_t *ssd1306_i2c_open(
             rc = -1;
             break;
         }
-        oled->dev = strdup(dev);
-        if (!oled->dev) {
+#ifdef LIBSSD1306_HAVE_PTHREAD
+        oled->lock = calloc(1, sizeof(*oled->lock));
+        if (!oled->lock) {
+            SSD1306_LOG_ERROR(oled->err, "Failed to allocate memory of size %zu bytes",
+                    sizeof(*oled->lock));
+            rc = -1;
+            break;
+        }
+        pthread_mutexattr_t mattr;
+        pthread_mutexattr_init(&mattr);
+        pthread_mutexattr_settype(&mattr, PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(&(oled->lock->mutex), &mattr);
+        pthread_mutexattr_destroy(&mattr);
+#endif
+        oled->dev = dev ? strdup(dev) : NULL;
+        if (dev && !oled->dev) {
             oled->err->errnum = errno;
             strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
-            fprintf(err_fp, "WARN: Failed to copy device name: %s. Ignoring potential memory error: %s\n", dev, oled->err->errbuf);
+            SSD1306_LOG_WARN(oled->err, "Failed to copy device name: %s. Ignoring potential memory error: %s", dev, oled->err->errbuf);
         } else {
             oled->err->errnum = 0;
             memset(oled->err->errbuf, 0, oled->err->errlen);
@@ -105,7 +116,7 @@ ssd1306_i2c_t *ssd1306_i2c_open(
         } else if (addr == 0x3d) {
             oled->addr = 0x3d;
         } else {
-            fprintf(err_fp, "WARN: I2C device addr cannot be 0x%02x. Using 0x3c\n",
+            SSD1306_LOG_WARN(oled->err, "I2C device addr cannot be 0x%02x. Using 0x3c",
                     addr);
             oled->addr = 0x3c;
         }
@@ -114,7 +125,7 @@ ssd1306_i2c_t *ssd1306_i2c_open(
         } else if (width == 96) {
             oled->width = 96;
         } else {
-            fprintf(err_fp, "WARN: OLED screen width cannot be %d. has to be either 96 or 128. Using 128\n",
+            SSD1306_LOG_WARN(oled->err, "OLED screen width cannot be %d. has to be either 96 or 128. Using 128",
                     width);
             oled->width = 128;
         }
@@ -125,43 +136,40 @@ ssd1306_i2c_t *ssd1306_i2c_open(
         } else if (height == 16) {
             oled->height = 16;
         } else {
-            fprintf(err_fp, "WARN: OLED screen height cannot be %d. has to be either 16, 32 or 64. Using %d\n",
+            SSD1306_LOG_WARN(oled->err, "OLED screen height cannot be %d. has to be either 16, 32 or 64. Using %d",
                     height, (oled->width == 96) ? 16 : 64);
             oled->height = (oled->width == 96) ? 16 : 64;
         }
+        oled->shadow_xfer_overhead = SSD1306_I2C_XFER_OVERHEAD_DEFAULT;
+        oled->regcache_enabled = true;
+        oled->profile = &ssd1306_i2c_profile_ssd1306;
         // this is width x height bits of GDDRAM
         oled->gddram_buffer_len = sizeof(uint8_t) * (oled->width * oled->height) / 8 + 1;
         oled->gddram_buffer = calloc(sizeof(uint8_t), oled->gddram_buffer_len);
         if (!oled->gddram_buffer) {
             oled->err->errnum = errno;
             strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
-            fprintf(err_fp, "ERROR: Out of memory allocating %zu bytes for screen buffer\n",
+            SSD1306_LOG_ERROR(oled->err, "Out of memory allocating %zu bytes for screen buffer",
                     oled->gddram_buffer_len);
             rc = -1;
             break;
         }
-        oled->fd = open(dev, O_RDWR);
-        if (oled->fd < 0) {
-            oled->err->errnum = errno;
-            strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
-            fprintf(err_fp, "ERROR: Failed to open %s in read/write mode: %s\n",
-                    dev, oled->err->errbuf);
+        if (transport->open && transport->open(oled, ctx, dev) < 0) {
             rc = -1;
             break;
-        } else {
-            fprintf(err_fp, "INFO: Opened %s at fd %d\n", dev, oled->fd);
-            uint32_t addr = (uint32_t)oled->addr;
-            if (ioctl(oled->fd, I2C_SLAVE, addr) < 0) {
-                oled->err->errnum = errno;
-                strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
-                fprintf(err_fp, "ERROR: Failed to set I2C_SLAVE for %s addr 0x%02x: %s\n",
-                        dev, addr, oled->err->errbuf);
+        }
+        // close() is only called for transports that were opened
+        oled->transport = transport;
+        oled->transport_ctx = ctx;
+        oled->transport_caps = transport->capabilities ?
+                    transport->capabilities(oled, ctx) : 0;
+        SSD1306_LOG_INFO(oled->err, "Using %s transport with capabilities 0x%02x",
+                transport->name ? transport->name : "custom", oled->transport_caps);
+        // SMBus only adapters get SMBus sized chunks
+        if (oled->transport_caps & SSD1306_I2C_TRANSPORT_CAP_SMBUS) {
+            if (ssd1306_i2c_set_chunk_size(oled, SSD1306_I2C_SMBUS_BLOCK_MAX) < 0) {
                 rc = -1;
                 break;
-            } else {
-                fprintf(err_fp, "INFO: I2C_SLAVE for %s addr 0x%02x opened in RDWR mode\n",
-                        dev, addr);
-                rc = 0;
             }
         }
     } while (0);
@@ -175,487 +183,4140 @@ ssd1306_i2c_t *ssd1306_i2c_open(
 void ssd1306_i2c_close(ssd1306_i2c_t *oled)
 {
     if (oled) {
-        if (oled->fd > 0) {
-            close(oled->fd);
+        ssd1306_i2c_async_stop(oled);
+        if (oled->warm_file) {
+            ssd1306_i2c_warm_save(oled);
+            free(oled->warm_file);
+        }
+        oled->warm_file = NULL;
+        ssd1306_i2c_capture_stop(oled);
+        free(oled->fx);
+        oled->fx = NULL;
+        ssd1306_i2c_internal_arb_free(oled->arbiter);
+        oled->arbiter = NULL;
+        if (oled->transport && oled->transport->close) {
+            oled->transport->close(oled, oled->transport_ctx);
         }
+        oled->transport = NULL;
         if (oled->gddram_buffer) {
             free(oled->gddram_buffer);
         }
         oled->gddram_buffer = NULL;
+        if (oled->shadow_buffer) {
+            free(oled->shadow_buffer - 1);
+        }
+        oled->shadow_buffer = NULL;
+        if (oled->xfer_buffer) {
+            free(oled->xfer_buffer);
+        }
+        oled->xfer_buffer = NULL;
+        if (oled->chunk_buffer) {
+            free(oled->chunk_buffer);
+        }
+        oled->chunk_buffer = NULL;
+        oled->chunk_buffer_len = 0;
+        if (oled->ticker_band) {
+            free(oled->ticker_band);
+        }
+        oled->ticker_band = NULL;
         if (oled->dev) {
             free(oled->dev);
         }
         oled->dev = NULL;
         ssd1306_err_destroy(oled->err);
         oled->err = NULL;
+#ifdef LIBSSD1306_HAVE_PTHREAD
+        if (oled->lock) {
+            pthread_mutex_destroy(&(oled->lock->mutex));
+            free(oled->lock);
+        }
+#endif
+        oled->lock = NULL;
         memset(oled, 0, sizeof(*oled));
         free(oled);
         oled = NULL;
     }
 }
 
+// encodes the raw command bytes for the given command into cmdbuf. the caller
+// is responsible for prepending the control byte. returns the number of bytes
+// written or 0 on error.
 static size_t ssd1306_i2c_internal_get_cmd_bytes(ssd1306_i2c_cmd_t cmd,
         uint8_t *data, size_t dlen, uint8_t *cmdbuf, size_t cmd_buf_max)
 {
-    size_t sz = 2; // default
-    if (!cmdbuf || cmd_buf_max < 16 || (data != NULL && dlen == 0)) {
+    size_t sz = 1; // default
+    if (!cmdbuf || cmd_buf_max < SSD1306_I2C_CMD_BYTES_MAX || (data != NULL && dlen == 0)) {
         return 0;//error
     }
-    // fill it up
-    for (size_t idx = 0; idx < cmd_buf_max; ++idx) {
-        if (idx % 2 == 0) {
-            cmdbuf[idx] = 0x80; // Co: 1 D/C#: 0 0b10000000
-        } else {
-            cmdbuf[idx] = 0xE3; // NOP by default
-        }
-    }
     switch (cmd) {
-    case SSD1306_I2C_CMD_POWER_OFF: cmdbuf[1] = 0xAE; break;
-    case SSD1306_I2C_CMD_POWER_ON: cmdbuf[1] = 0xAF; break;
+    case SSD1306_I2C_CMD_POWER_OFF: cmdbuf[0] = 0xAE; break;
+    case SSD1306_I2C_CMD_POWER_ON: cmdbuf[0] = 0xAF; break;
     case SSD1306_I2C_CMD_MEM_ADDR_HORIZ:
-        cmdbuf[1] = 0x20; // Set memory address
-        cmdbuf[3] = 0x00; // horizontal
-        sz = 4;
+        cmdbuf[0] = 0x20; // Set memory address
+        cmdbuf[1] = 0x00; // horizontal
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_MEM_ADDR_VERT:
-        cmdbuf[1] = 0x20; // Set memory address
-        cmdbuf[3] = 0x01; // vertical
-        sz = 4;
+        cmdbuf[0] = 0x20; // Set memory address
+        cmdbuf[1] = 0x01; // vertical
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_MEM_ADDR_PAGE:
-        cmdbuf[1] = 0x20; // Set memory address
-        cmdbuf[3] = 0x02; // page / reset
-        sz = 4;
+        cmdbuf[0] = 0x20; // Set memory address
+        cmdbuf[1] = 0x02; // page / reset
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_COLUMN_ADDR:
-        cmdbuf[1] = 0x21; // set column address
+        cmdbuf[0] = 0x21; // set column address
         if (data && dlen >= 2) {
-            cmdbuf[3] = data[0] & 0x7F;
-            cmdbuf[5] = data[1] & 0x7F;
+            cmdbuf[1] = data[0] & 0x7F;
+            cmdbuf[2] = data[1] & 0x7F;
         } else {
-            cmdbuf[3] = 0x00; // RESET
-            cmdbuf[5] = 0x7F; // RESET
+            cmdbuf[1] = 0x00; // RESET
+            cmdbuf[2] = 0x7F; // RESET
         }
-        sz = 6;
+        sz = 3;
         break;
     case SSD1306_I2C_CMD_PAGE_ADDR:
-        cmdbuf[1] = 0x22; // set page address
+        cmdbuf[0] = 0x22; // set page address
         if (data && dlen >= 2) {
-            cmdbuf[3] = data[0] & 0x07;
-            cmdbuf[5] = data[1] & 0x07;
+            cmdbuf[1] = data[0] & 0x07;
+            cmdbuf[2] = data[1] & 0x07;
         } else {
-            cmdbuf[3] = 0x00; // RESET
-            cmdbuf[5] = 0x07; // RESET
+            cmdbuf[1] = 0x00; // RESET
+            cmdbuf[2] = 0x07; // RESET
         }
-        sz = 6;
+        sz = 3;
         break;
     case SSD1306_I2C_CMD_DISP_START_LINE:
         if (data && dlen > 0) {
-            cmdbuf[1] = 0x40 | (data[0] & 0x3F); // set display start line bytes. 40-7F
+            cmdbuf[0] = 0x40 | (data[0] & 0x3F); // set display start line bytes. 40-7F
         } else {
-            cmdbuf[1] = 0x40; // set display start line bytes. 40-7F
+            cmdbuf[0] = 0x40; // set display start line bytes. 40-7F
         }
         break;
     case SSD1306_I2C_CMD_DISP_OFFSET:
-        cmdbuf[1] = 0xD3;
-        cmdbuf[3] = (data && dlen > 0) ? data[0] & 0x3F : 0x00; // 0x00-0x3F;
-        sz = 4;
+        cmdbuf[0] = 0xD3;
+        cmdbuf[1] = (data && dlen > 0) ? data[0] & 0x3F : 0x00; // 0x00-0x3F;
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_DISP_CLOCK_DIVFREQ:
-        cmdbuf[1] = 0xD5;
-        cmdbuf[3] = (data && dlen > 0) ? data[0] : 0x80;
-        sz = 4;
+        cmdbuf[0] = 0xD5;
+        cmdbuf[1] = (data && dlen > 0) ? data[0] : 0x80;
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_DISP_CONTRAST:
-        cmdbuf[1] = 0x81;
-        cmdbuf[3] = (data && dlen > 0) ? data[0] : 0x7F;
-        sz = 4;
+        cmdbuf[0] = 0x81;
+        cmdbuf[1] = (data && dlen > 0) ? data[0] : 0x7F;
+        sz = 2;
         break;
-    case SSD1306_I2C_CMD_DISP_NORMAL: cmdbuf[1] = 0xA6; break;
-    case SSD1306_I2C_CMD_DISP_INVERTED: cmdbuf[1] = 0xA7; break;
-    case SSD1306_I2C_CMD_DISP_DISABLE_ENTIRE_ON: cmdbuf[1] = 0xA4; break;
-    case SSD1306_I2C_CMD_DISP_ENTIRE_ON: cmdbuf[1] = 0xA5; break;
+    case SSD1306_I2C_CMD_DISP_NORMAL: cmdbuf[0] = 0xA6; break;
+    case SSD1306_I2C_CMD_DISP_INVERTED: cmdbuf[0] = 0xA7; break;
+    case SSD1306_I2C_CMD_DISP_DISABLE_ENTIRE_ON: cmdbuf[0] = 0xA4; break;
+    case SSD1306_I2C_CMD_DISP_ENTIRE_ON: cmdbuf[0] = 0xA5; break;
     case SSD1306_I2C_CMD_SEG_REMAP:
         if (data && dlen > 0) {
-            cmdbuf[1] = 0xA0 | (data[0] & 0x1);
+            cmdbuf[0] = 0xA0 | (data[0] & 0x1);
         } else {
-            cmdbuf[1] = 0xA0;
+            cmdbuf[0] = 0xA0;
         }
         break;
     case SSD1306_I2C_CMD_MUX_RATIO:
-        cmdbuf[1] = 0xA8;
-        cmdbuf[3] = (data && dlen > 0) ? data[0] : 0xFF;
-        sz = 4;
+        cmdbuf[0] = 0xA8;
+        cmdbuf[1] = (data && dlen > 0) ? data[0] : 0xFF;
+        sz = 2;
         break;
-    case SSD1306_I2C_CMD_COM_SCAN_DIRXN_NORMAL: cmdbuf[1] = 0xC0; break;
-    case SSD1306_I2C_CMD_COM_SCAN_DIRXN_INVERT: cmdbuf[1] = 0xC8; break;
+    case SSD1306_I2C_CMD_COM_SCAN_DIRXN_NORMAL: cmdbuf[0] = 0xC0; break;
+    case SSD1306_I2C_CMD_COM_SCAN_DIRXN_INVERT: cmdbuf[0] = 0xC8; break;
     case SSD1306_I2C_CMD_COM_PIN_CFG:
-        cmdbuf[1] = 0xDA;
-        cmdbuf[3] = (data && dlen > 0) ? (data[0] & 0x32) : 0x02; // valid values: 0x02, 0x12, 0x22, 0x32
-        sz = 4;
+        cmdbuf[0] = 0xDA;
+        cmdbuf[1] = (data && dlen > 0) ? (data[0] & 0x32) : 0x02; // valid values: 0x02, 0x12, 0x22, 0x32
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_PRECHARGE_PERIOD:
-        cmdbuf[1] = 0xD9;
-        cmdbuf[3] = (data && dlen > 0) ? data[0] : 0x22; // 0 is invalid
-        sz = 4;
+        cmdbuf[0] = 0xD9;
+        cmdbuf[1] = (data && dlen > 0) ? data[0] : 0x22; // 0 is invalid
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_VCOMH_DESELECT:
-        cmdbuf[1] = 0xDB;
-        cmdbuf[3] = (data && dlen > 0) ? (data[0] & 0x70) : 0x30; // 0b0AAA0000
-        sz = 4;
+        cmdbuf[0] = 0xDB;
+        cmdbuf[1] = (data && dlen > 0) ? (data[0] & 0x70) : 0x30; // 0b0AAA0000
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_ENABLE_CHARGE_PUMP:
-        cmdbuf[1] = 0x8D;
-        cmdbuf[3] = 0x14; // 0b00010100
-        sz = 4;
+        cmdbuf[0] = 0x8D;
+        cmdbuf[1] = 0x14; // 0b00010100
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_DISABLE_CHARGE_PUMP:
-        cmdbuf[1] = 0x8D;
-        cmdbuf[3] = 0x10; // 0b00010000
-        sz = 4;
+        cmdbuf[0] = 0x8D;
+        cmdbuf[1] = 0x10; // 0b00010000
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_SCROLL_DEACTIVATE:
-        cmdbuf[1] = 0x2E;
+        cmdbuf[0] = 0x2E;
         break;
     case SSD1306_I2C_CMD_SCROLL_LEFT_HORIZONTAL:
     case SSD1306_I2C_CMD_SCROLL_RIGHT_HORIZONTAL:
         // perform the scroll settings
         if (cmd == SSD1306_I2C_CMD_SCROLL_LEFT_HORIZONTAL) {
-            cmdbuf[1] = 0x27;// deactivate existing settings
-            cmdbuf[2] = 0x27; // 0b00100111 for left horizontal scroll
+            cmdbuf[0] = 0x27; // 0b00100111 for left horizontal scroll
         } else {
-            cmdbuf[1] = 0x26;// deactivate existing settings
-            cmdbuf[2] = 0x26; // 0b00100110 for right horizontal scroll
-        }
-        cmdbuf[3] = 0x00; // dummy byte
-        cmdbuf[4] = (data && dlen > 0) ? (data[0] & 0x07) : 0x00; // 3-bit Start page address. Default 0b000
-        cmdbuf[5] = (data && dlen > 1) ? (data[1] & 0x07) : 0x00; // 3-bit scroll step in frame frequency
-        cmdbuf[6] = (data && dlen > 2) ? (data[2] & 0x07) : 0x07; // 3-bit end page address. default is last page
-        if (cmdbuf[6] < cmdbuf[4]) {
+            cmdbuf[0] = 0x26; // 0b00100110 for right horizontal scroll
+        }
+        cmdbuf[1] = 0x00; // dummy byte
+        cmdbuf[2] = (data && dlen > 0) ? (data[0] & 0x07) : 0x00; // 3-bit Start page address. Default 0b000
+        cmdbuf[3] = (data && dlen > 1) ? (data[1] & 0x07) : 0x00; // 3-bit scroll step in frame frequency
+        cmdbuf[4] = (data && dlen > 2) ? (data[2] & 0x07) : 0x07; // 3-bit end page address. default is last page
+        if (cmdbuf[4] < cmdbuf[2]) {
             // end page must be larger or equal
             // overwriting
-            cmdbuf[6] = cmdbuf[4];
+            cmdbuf[4] = cmdbuf[2];
         }
-        cmdbuf[7] = 0x00; // dummy byte
-        cmdbuf[8] = 0XFF; // dummy byte
-        cmdbuf[9] = 0x2F; // activate the scroll
-        sz = 10;
+        cmdbuf[5] = 0x00; // dummy byte
+        cmdbuf[6] = 0XFF; // dummy byte
+        cmdbuf[7] = 0x2F; // activate the scroll
+        sz = 8;
         break;
     case SSD1306_I2C_CMD_SCROLL_VERTICAL_LEFT_HORIZONTAL:
     case SSD1306_I2C_CMD_SCROLL_VERTICAL_RIGHT_HORIZONTAL:
         if (cmd == SSD1306_I2C_CMD_SCROLL_VERTICAL_LEFT_HORIZONTAL) {
-            cmdbuf[1] = 0x2A; // 0b00101010 for vertical and left horizontal scroll
-            cmdbuf[2] = 0x2A; // 0b00101010 for vertical and left horizontal scroll
+            cmdbuf[0] = 0x2A; // 0b00101010 for vertical and left horizontal scroll
         } else {
-            cmdbuf[1] = 0x29; // 0b00101001 for vertical and right horizontal scroll
-            cmdbuf[2] = 0x29; // 0b00101001 for vertical and right horizontal scroll
-        }
-        cmdbuf[3] = 0x00; // dummy byte
-        cmdbuf[4] = (data && dlen > 0) ? (data[0] & 0x07) : 0x00; // 3-bit Start page address. Default 0b000
-        cmdbuf[5] = (data && dlen > 1) ? (data[1] & 0x07) : 0x00; // 3-bit scroll step in frame frequency
-        cmdbuf[6] = (data && dlen > 2) ? (data[2] & 0x07) : 0x07; // 3-bit end page address. default is last page
-        if (cmdbuf[6] < cmdbuf[4]) {
+            cmdbuf[0] = 0x29; // 0b00101001 for vertical and right horizontal scroll
+        }
+        cmdbuf[1] = 0x00; // dummy byte
+        cmdbuf[2] = (data && dlen > 0) ? (data[0] & 0x07) : 0x00; // 3-bit Start page address. Default 0b000
+        cmdbuf[3] = (data && dlen > 1) ? (data[1] & 0x07) : 0x00; // 3-bit scroll step in frame frequency
+        cmdbuf[4] = (data && dlen > 2) ? (data[2] & 0x07) : 0x07; // 3-bit end page address. default is last page
+        if (cmdbuf[4] < cmdbuf[2]) {
             // end page must be larger or equal
             // overwriting
-            cmdbuf[6] = cmdbuf[4];
+            cmdbuf[4] = cmdbuf[2];
         }
-        cmdbuf[7] = (data && dlen > 3) ? (data[3] & 0x3F) : 0x01; // 1-63 rows of vertical offset scrolling
-        cmdbuf[8] = 0x2F; // activate the scroll
-        sz = 9;
+        cmdbuf[5] = (data && dlen > 3) ? (data[3] & 0x3F) : 0x01; // 1-63 rows of vertical offset scrolling
+        cmdbuf[6] = 0x2F; // activate the scroll
+        sz = 7;
         break;
     case SSD1306_I2C_CMD_SCROLL_VERTICAL_AREA:
-        cmdbuf[1] = 0xA3; //0b10100011
-        cmdbuf[2] = 0xA3; //0b10100011
-        cmdbuf[3] = (data && dlen > 0) ? (data[0] & 0x3F) : 0x00; // no. of rows in top fixed area. 0 is RESET
-        cmdbuf[4] = (data && dlen > 1) ? (data[1] & 0x7F) : 0x40; // no. of rows in scroll area. 64 is RESET
-        cmdbuf[5] = 0x2F; // activate the scroll
-        sz = 6;
+        cmdbuf[0] = 0xA3; //0b10100011
+        cmdbuf[1] = (data && dlen > 0) ? (data[0] & 0x3F) : 0x00; // no. of rows in top fixed area. 0 is RESET
+        cmdbuf[2] = (data && dlen > 1) ? (data[1] & 0x7F) : 0x40; // no. of rows in scroll area. 64 is RESET
+        sz = 3;
+        break;
+    case SSD1306_I2C_CMD_SH1106_DCDC:
+        cmdbuf[0] = 0xAD;
+        cmdbuf[1] = (data && dlen > 0) ? data[0] : 0x8B; // 0x8B on, 0x8A off
+        sz = 2;
         break;
     case SSD1306_I2C_CMD_NOP: // fallthrough
     default:
-        cmdbuf[1] = 0xE3; // NOP
+        cmdbuf[0] = 0xE3; // NOP
         break;
     }
     return sz;
 }
 
-int ssd1306_i2c_display_initialize(ssd1306_i2c_t *oled)
-{
-    int rc = 0;
-    uint8_t data;
-    FILE *err_fp = SSD1306_I2C_GET_ERRFP(oled);
-    if (!oled || oled->fd < 0) {
-        fprintf(err_fp, "ERROR: Invalid ssd1306 I2C object\n");
-        return -1;
-    }
-    do {
-        // power off the display before doing anything
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_POWER_OFF, 0, 0);
-        if (rc < 0) break;
-        // force horizontal memory addressing
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_MEM_ADDR_HORIZ, 0, 0);
-        if (rc < 0) break;
-        // these instructions are from the software configuration section 15.2.3 in
-        // the datasheet
-        // Set MUX Ratio 0xA8, 0x3F
-        data = oled->height - 1;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_MUX_RATIO, &data, 1);
-        if (rc < 0) break;
-        // Set display offset 0xD3, 0x00
-        data = 0x00;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_OFFSET, &data, 1);
-        if (rc < 0) break;
-        // set display start line 0x40
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_START_LINE, 0, 0);
-        if (rc < 0) break;
-        // set segment remap 0xA0/0xA1
-        data = 0x01;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SEG_REMAP, &data, 1);
-        if (rc < 0) break;
-        // set com output scan direction 0xC0/0xC8
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_COM_SCAN_DIRXN_INVERT, 0, 0);
-        if (rc < 0) break;
-        // set com pins hardware config 0xDA, 0x02
-        data = (oled->height == 32) ? 0x02 : 0x12;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_COM_PIN_CFG, &data, 1);
-        if (rc < 0) break;
-        // set contrast control 0x81, 0xFF
-        data = 0xFF;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_CONTRAST, &data, 1);
-        if (rc < 0) break;
-        // disable entire display on 0xA4
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_DISABLE_ENTIRE_ON, 0, 0);
-        if (rc < 0) break;
-        // set normal display 0xA6
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_NORMAL, 0, 0);
-        if (rc < 0) break;
-        // set osc frequency 0xD5, 0x80
-        data = 0x80;//RESET 0b10000000
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_DISP_CLOCK_DIVFREQ, &data, 1);
-        if (rc < 0) break;
-        // set precharge period 0xD9, 0xF1
-        data = 0xF1;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_PRECHARGE_PERIOD, &data, 1);
-        if (rc < 0) break;
-        // set Vcomh Deselect 0xDB 0x30
-        data = 0x30;
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_VCOMH_DESELECT, &data, 1);
-        if (rc < 0) break;
-        // enable charge pump regulator 0x8D, 0x14
-        // charge pump has to be followed by a power on. section 15.2.1 in datasheet
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_ENABLE_CHARGE_PUMP, 0, 0);
-        if (rc < 0) break;
-        // power display on 0xAF
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_POWER_ON, 0, 0);
-        if (rc < 0) break;
-        // deactivate scrolling
-        rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_SCROLL_DEACTIVATE, 0, 0);
-        if (rc < 0) break;
-        // clear the screen
-        rc |= ssd1306_i2c_display_clear(oled);
-        if (rc < 0) break;
-    } while (0);
-    return rc;
-}
-
-int ssd1306_i2c_run_cmd(ssd1306_i2c_t *oled, ssd1306_i2c_cmd_t cmd, uint8_t *data, size_t dlen)
+// sanitizes the data/dlen pair like ssd1306_i2c_run_cmd() always did and
+// appends the encoded command to the control stream in buf. returns the
+// number of bytes appended or 0 on error.
+size_t ssd1306_i2c_internal_append_cmd(ssd1306_err_t *err, ssd1306_i2c_cmd_t cmd,
+        uint8_t *data, size_t dlen, uint8_t *buf, size_t buf_max)
 {
-    FILE *err_fp = SSD1306_I2C_GET_ERRFP(oled);
-    if (!oled || oled->fd < 0) {
-        fprintf(err_fp, "ERROR: Invalid ssd1306 I2C object\n");
-        return -1;
-    }
     if (dlen > 0 && !data) {
-        fprintf(err_fp, "WARN: data pointer is NULL but dlen is %zu. Ignoring\n", dlen);
+        SSD1306_LOG_WARN(err, "data pointer is NULL but dlen is %zu. Ignoring", dlen);
         dlen = 0;
         data = NULL;
     }
     if (dlen > 6 && data != NULL) {
-        fprintf(err_fp, "WARN: the maximum accepted data bytes for a command is 6. You gave %zu, adjusting to 6\n", dlen);
+        SSD1306_LOG_WARN(err, "the maximum accepted data bytes for a command is 6. You gave %zu, adjusting to 6", dlen);
         dlen = 6;
     }
-    uint8_t cmd_buf[16] = { 0 };
-    const size_t cmd_buf_max = 16;
+    uint8_t cmd_buf[SSD1306_I2C_CMD_BYTES_MAX] = { 0 };
     size_t cmd_sz = ssd1306_i2c_internal_get_cmd_bytes(cmd, data, dlen,
-                        cmd_buf, cmd_buf_max);
-    if (cmd_sz == 0 || cmd_sz > cmd_buf_max) {
-        fprintf(err_fp, "WARN: Unknown cmd given %d\n", cmd);
-        return -1;
+                        cmd_buf, sizeof(cmd_buf));
+    if (cmd_sz == 0 || cmd_sz > sizeof(cmd_buf)) {
+        SSD1306_LOG_WARN(err, "Unknown cmd given %d", cmd);
+        return 0;
     }
-    ssize_t nb = write(oled->fd, cmd_buf, cmd_sz);
-    if (nb < 0) {
-        oled->err->errnum = errno;
-        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
-        fprintf(err_fp, "ERROR: Failed to write cmd ");
-        for (size_t idx = 0; idx < cmd_sz; ++idx) {
-            fprintf(err_fp, "%c0x%02x%c", (idx == 0) ? '[' : ' ',
-                    cmd_buf[idx], (idx == (cmd_sz - 1)) ? ']' : ',');
+    if (cmd_sz > buf_max) {
+        return 0;
+    }
+    memcpy(buf, cmd_buf, cmd_sz);
+    return cmd_sz;
+}
+
+// active scrolling rotates the GDDRAM contents, so the shadow no longer
+// matches what the panel holds
+static bool ssd1306_i2c_internal_cmd_moves_gddram(ssd1306_i2c_cmd_t cmd)
+{
+    switch (cmd) {
+    case SSD1306_I2C_CMD_SCROLL_LEFT_HORIZONTAL:
+    case SSD1306_I2C_CMD_SCROLL_RIGHT_HORIZONTAL:
+    case SSD1306_I2C_CMD_SCROLL_VERTICAL_LEFT_HORIZONTAL:
+    case SSD1306_I2C_CMD_SCROLL_VERTICAL_RIGHT_HORIZONTAL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void ssd1306_i2c_internal_log_seg(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *seg, bool failed)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    ssd1306_loglevel_t level = failed ? SSD1306_LOGLEVEL_ERROR : SSD1306_LOGLEVEL_INFO;
+    // nothing gets formatted unless the message will be emitted
+    if (!SSD1306_LOG_ENABLED(err, level))
+        return;
+    if (seg->len > 0 && SSD1306_I2C_SEG_IS_DATA(seg)) {
+        if (failed) {
+            SSD1306_LOG_ERROR(err, "Failed to write %zu bytes of screen buffer to device fd %d : %s",
+                    seg->len, oled->fd, oled->err->errbuf);
+        } else {
+            SSD1306_LOG_INFO(err, "Wrote %zu bytes of screen buffer to device fd %d",
+                    seg->len, oled->fd);
         }
-        fprintf(err_fp, " to device fd %d: %s\n",
+        return;
+    }
+    char hex[6 * SSD1306_I2C_CMD_BATCH_MAX + 8];
+    size_t off = 0;
+    for (size_t idx = 0; idx < seg->len && off + 8 < sizeof(hex); ++idx) {
+        off += snprintf(&hex[off], sizeof(hex) - off, "%c0x%02x%c", (idx == 0) ? '[' : ' ',
+                seg->buf[idx], (idx == (seg->len - 1)) ? ']' : ',');
+    }
+    if (off == 0) {
+        snprintf(hex, sizeof(hex), "[]");
+    }
+    if (failed) {
+        SSD1306_LOG_ERROR(err, "Failed to write cmd %s to device fd %d: %s", hex,
                 oled->fd, oled->err->errbuf);
+    } else {
+        SSD1306_LOG_INFO(err, "Wrote %zu bytes of cmd %s to device fd %d", seg->len,
+                hex, oled->fd);
+    }
+}
+
+// true if the adapter can only do SMBus I2C block writes and not plain I2C
+static bool ssd1306_i2c_internal_smbus_only(const ssd1306_i2c_t *oled)
+{
+#ifdef SSD1306_I2C_HAVE_SMBUS_BLOCK
+    return !(oled->funcs & I2C_FUNC_I2C) &&
+            (oled->funcs & I2C_FUNC_SMBUS_WRITE_I2C_BLOCK);
+#else
+    (void)oled;
+    return false;
+#endif
+}
+
+#ifdef SSD1306_I2C_HAVE_SMBUS_BLOCK
+// SMBus I2C block write. the SMBus command byte is the SSD1306 control byte
+static int ssd1306_i2c_internal_smbus_block_write(int fd, uint8_t ctrl,
+        const uint8_t *buf, size_t len)
+{
+#if LIBSSD1306_HAVE_I2C_SMBUS_H
+    return i2c_smbus_write_i2c_block_data(fd, ctrl, (uint8_t)len, buf);
+#else
+    union i2c_smbus_data data;
+    data.block[0] = (uint8_t)len;
+    memcpy(&data.block[1], buf, len);
+    struct i2c_smbus_ioctl_data args = {
+        .read_write = I2C_SMBUS_WRITE,
+        .command = ctrl,
+        .size = I2C_SMBUS_I2C_BLOCK_DATA,
+        .data = &data
+    };
+    return ioctl(fd, I2C_SMBUS, &args);
+#endif
+}
+#endif
+
+static int ssd1306_i2c_internal_i2cdev_open(ssd1306_i2c_t *oled, void *ctx,
+        const char *dev)
+{
+    (void)ctx;
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!dev) {
+        SSD1306_LOG_ERROR(err, "No device given.");
+        return -1;
+    }
+    int fd = open(dev, O_RDWR);
+    if (fd < 0) {
+        err->errnum = errno;
+        strerror_r(err->errnum, err->errbuf, err->errlen);
+        SSD1306_LOG_ERROR(err, "Failed to open %s in read/write mode: %s",
+                dev, err->errbuf);
         return -1;
     }
-    fprintf(err_fp, "INFO: Wrote %zd bytes of cmd ", nb);
-    for (size_t idx = 0; idx < cmd_sz; ++idx) {
-        fprintf(err_fp, "%c0x%02x%c", (idx == 0) ? '[' : ' ',
-                cmd_buf[idx], (idx == (cmd_sz - 1)) ? ']' : ',');
+    SSD1306_LOG_INFO(err, "Opened %s at fd %d", dev, fd);
+    uint32_t addr = (uint32_t)oled->addr;
+    if (ioctl(fd, I2C_SLAVE, addr) < 0) {
+        err->errnum = errno;
+        strerror_r(err->errnum, err->errbuf, err->errlen);
+        SSD1306_LOG_ERROR(err, "Failed to set I2C_SLAVE for %s addr 0x%02x: %s",
+                dev, addr, err->errbuf);
+        close(fd);
+        return -1;
+    }
+    SSD1306_LOG_INFO(err, "I2C_SLAVE for %s addr 0x%02x opened in RDWR mode",
+            dev, addr);
+    if (ioctl(fd, I2C_FUNCS, &(oled->funcs)) < 0) {
+        SSD1306_LOG_WARN(err, "I2C Function mask not available for %s. Using write()",
+                dev);
+        oled->funcs = 0;
+    } else {
+        SSD1306_LOG_INFO(err, "I2C Function mask for %s is 0x%08lx",
+                dev, oled->funcs);
     }
-    fprintf(err_fp, " to device fd %d\n", oled->fd);
+    oled->fd = fd;
     return 0;
 }
 
-int ssd1306_i2c_display_update(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp)
+static void ssd1306_i2c_internal_i2cdev_close(ssd1306_i2c_t *oled, void *ctx)
 {
-    FILE *err_fp = SSD1306_I2C_GET_ERRFP(oled);
-    if (!oled || oled->fd < 0 || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
-        fprintf(err_fp, "ERROR: Invalid ssd1306 I2C object\n");
-        return -1;
+    (void)ctx;
+    if (oled->fd >= 0) {
+        close(oled->fd);
+    }
+    oled->fd = -1;
+}
+
+uint32_t ssd1306_i2c_internal_i2cdev_caps(const ssd1306_i2c_t *oled, void *ctx)
+{
+    (void)ctx;
+    uint32_t caps = SSD1306_I2C_TRANSPORT_CAP_FD;
+#ifdef SSD1306_I2C_HAVE_RDWR
+    if (oled->funcs & I2C_FUNC_I2C)
+        caps |= SSD1306_I2C_TRANSPORT_CAP_MULTI;
+#endif
+    if (ssd1306_i2c_internal_smbus_only(oled))
+        caps |= SSD1306_I2C_TRANSPORT_CAP_SMBUS;
+    return caps;
+}
+
+#ifdef SSD1306_I2C_HAVE_RDWR
+// submits the messages with a single I2C_RDWR ioctl(). returns the number of
+// messages the adapter sent or -1 on error
+static int ssd1306_i2c_internal_rdwr_msgs(ssd1306_i2c_t *oled, struct i2c_msg *msgs,
+        size_t nmsgs)
+{
+    struct i2c_rdwr_ioctl_data rdwr = { .msgs = msgs, .nmsgs = (uint32_t)nmsgs };
+    return ioctl(oled->fd, I2C_RDWR, &rdwr);
+}
+
+// submits all segments, at most I2C_RDWR_IOCTL_MAX_MSGS, addressed to
+// oled->addr with a single I2C_RDWR ioctl(). returns the number of segments
+// sent or -1 on error
+int ssd1306_i2c_internal_rdwr(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    for (size_t idx = 0; idx < nsegs; ++idx) {
+        msgs[idx].addr = oled->addr;
+        msgs[idx].flags = 0; // write
+        msgs[idx].len = (uint16_t)segs[idx].len;
+        msgs[idx].buf = (uint8_t *)segs[idx].buf;
     }
+    return ssd1306_i2c_internal_rdwr_msgs(oled, msgs, nsegs);
+}
+
+// called after I2C_RDWR failed. if the adapter does not really support it,
+// write() is used from now on and true is returned
+static bool ssd1306_i2c_internal_rdwr_fallback(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    err->errnum = errno;
+    strerror_r(err->errnum, err->errbuf, err->errlen);
+    if (err->errnum != ENOTTY && err->errnum != EOPNOTSUPP && err->errnum != EINVAL)
+        return false;
+    SSD1306_LOG_WARN(err, "I2C_RDWR not supported by device fd %d: %s. Using write()",
+            oled->fd, err->errbuf);
+    oled->funcs &= ~I2C_FUNC_I2C;
+    oled->transport_caps &= ~SSD1306_I2C_TRANSPORT_CAP_MULTI;
+    return true;
+}
+#endif
+
+// sends the segments split into transactions of at most chunk_size bytes
+// after the control byte. the control byte is repeated in every chunk.
+static int ssd1306_i2c_internal_i2cdev_chunked(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    const size_t chunk = oled->chunk_size;
+    const bool smbus = ssd1306_i2c_internal_smbus_only(oled);
+#ifdef SSD1306_I2C_HAVE_RDWR
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    // segment and payload offset each message starts at, to resume from
+    size_t msg_seg[I2C_RDWR_IOCTL_MAX_MSGS];
+    size_t msg_off[I2C_RDWR_IOCTL_MAX_MSGS];
+    bool rdwr = !smbus && (oled->funcs & I2C_FUNC_I2C);
+#else
+    const bool rdwr = false;
+#endif
+    size_t nmsgs = 0;
+    size_t idx = 0, off = 0; // segment and payload offset to send next
+    size_t failed = 0;
     int rc = 0;
-    uint8_t x[2] = { 0, oled->width - 1 };
-    rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_COLUMN_ADDR, x, 2);
-    x[0] = 0;
-    x[1] = (oled->height / 8) - 1; // number of pages
-    rc |= ssd1306_i2c_run_cmd(oled, SSD1306_I2C_CMD_PAGE_ADDR, x, 2);
-    if (rc != 0) {
-        fprintf(err_fp, "WARN: Unable to update display, exiting from earlier errors\n");
+    while (rc == 0) {
+        while (idx < nsegs && off + 1 >= segs[idx].len) {
+            ++idx;
+            off = 0;
+        }
+#ifdef SSD1306_I2C_HAVE_RDWR
+        if (nmsgs > 0 && (idx == nsegs || nmsgs == I2C_RDWR_IOCTL_MAX_MSGS)) {
+            int sent = ssd1306_i2c_internal_rdwr_msgs(oled, msgs, nmsgs);
+            if (sent < 0 && !ssd1306_i2c_internal_rdwr_fallback(oled)) {
+                failed = msg_seg[0];
+                rc = -1;
+                break;
+            }
+            if (sent < 0 || (size_t)sent < nmsgs) {
+                // the rest goes with write() from the first message not sent
+                size_t first = (sent < 0) ? 0 : (size_t)sent;
+                idx = msg_seg[first];
+                off = msg_off[first];
+                rdwr = false;
+            }
+            nmsgs = 0;
+            continue;
+        }
+#endif
+        if (idx == nsegs)
+            break;
+        const uint8_t ctrl = segs[idx].buf[0];
+        const uint8_t *payload = &(segs[idx].buf[1 + off]);
+        const size_t left = segs[idx].len - 1 - off;
+        const size_t n = (left < chunk) ? left : chunk;
+        if (smbus) {
+#ifdef SSD1306_I2C_HAVE_SMBUS_BLOCK
+            rc = ssd1306_i2c_internal_smbus_block_write(oled->fd, ctrl, payload, n);
+#endif
+        } else if (rdwr) {
+#ifdef SSD1306_I2C_HAVE_RDWR
+            uint8_t *slot = &(oled->chunk_buffer[nmsgs * (chunk + 1)]);
+            slot[0] = ctrl;
+            memcpy(&slot[1], payload, n);
+            msgs[nmsgs].addr = oled->addr;
+            msgs[nmsgs].flags = 0; // write
+            msgs[nmsgs].len = (uint16_t)(n + 1);
+            msgs[nmsgs].buf = slot;
+            msg_seg[nmsgs] = idx;
+            msg_off[nmsgs] = off;
+            nmsgs++;
+#endif
+        } else {
+            oled->chunk_buffer[0] = ctrl;
+            memcpy(&(oled->chunk_buffer[1]), payload, n);
+            rc = (write(oled->fd, oled->chunk_buffer, n + 1) < 0) ? -1 : 0;
+        }
+        if (rc < 0) {
+            err->errnum = errno;
+            strerror_r(err->errnum, err->errbuf, err->errlen);
+            failed = idx;
+        }
+        off += n;
+    }
+    if (rc < 0) {
+        SSD1306_LOG_ERROR(err, "Failed to send %s segment %zu of %zu in chunks of %zu bytes to device fd %d: %s",
+                SSD1306_I2C_SEG_IS_DATA(&segs[failed]) ? "data" : "command",
+                failed + 1, nsegs, chunk, oled->fd, err->errbuf);
         return -1;
     }
-    oled->gddram_buffer[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
-    // if the framebuffer pointer is provided, we copy it to GDDRAM, otherwise
-    // we just display the GDDRAM
-    if (fbp) {
-        // invalid data in pointer
-        if (!(fbp->buffer) || fbp->len == 0 || (fbp->len != (oled->gddram_buffer_len - 1))) {
-            fprintf(err_fp, "ERROR: Invalid ssd1306 framebuffer object\n");
+    SSD1306_LOG_INFO(err, "Sent %zu segments in chunks of %zu bytes to device fd %d",
+            nsegs, chunk, oled->fd);
+    return 0;
+}
+
+// if the adapter supports plain I2C transfers all segments are submitted with
+// a single I2C_RDWR ioctl(), otherwise each is written with write()
+int ssd1306_i2c_internal_i2cdev_xfer(ssd1306_i2c_t *oled, void *ctx,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    (void)ctx;
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (oled->chunk_size > 0 && oled->chunk_buffer) {
+        return ssd1306_i2c_internal_i2cdev_chunked(oled, segs, nsegs);
+    }
+    size_t first = 0;
+#ifdef SSD1306_I2C_HAVE_RDWR
+    if ((oled->funcs & I2C_FUNC_I2C) && nsegs > 1 && nsegs <= I2C_RDWR_IOCTL_MAX_MSGS) {
+        int sent = ssd1306_i2c_internal_rdwr(oled, segs, nsegs);
+        if (sent == (int)nsegs)
+            return 0;
+        if (sent < 0 && !ssd1306_i2c_internal_rdwr_fallback(oled))
+            return -1;
+        // the rest goes with write() from the first segment not sent
+        first = (sent < 0) ? 0 : (size_t)sent;
+    }
+#endif
+    for (size_t idx = first; idx < nsegs; ++idx) {
+        if (write(oled->fd, segs[idx].buf, segs[idx].len) < 0) {
+            err->errnum = errno;
+            strerror_r(err->errnum, err->errbuf, err->errlen);
+            if (nsegs > 1)
+                SSD1306_LOG_ERROR(err, "Failed to write %s segment %zu of %zu to device fd %d: %s",
+                        SSD1306_I2C_SEG_IS_DATA(&segs[idx]) ? "data" : "command",
+                        idx + 1, nsegs, oled->fd, err->errbuf);
             return -1;
         }
-        memcpy(&(oled->gddram_buffer[1]), fbp->buffer, fbp->len);
     }
-    // the rest is framebuffer data for the GDDRAM as in section 8.1.5.2
-    ssize_t nb = write(oled->fd, oled->gddram_buffer, oled->gddram_buffer_len);
-    if (nb < 0) {
-        oled->err->errnum = errno;
-        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
-        fprintf(err_fp, "ERROR: Failed to write %zu bytes of screen buffer to device fd %d : %s\n",
-                oled->gddram_buffer_len, oled->fd, oled->err->errbuf);
-        return -1;
+    return 0;
+}
+
+static int ssd1306_i2c_internal_i2cdev_write(ssd1306_i2c_t *oled, void *ctx,
+        const uint8_t *buf, size_t len)
+{
+    ssd1306_i2c_seg_t seg = { buf, len };
+    return ssd1306_i2c_internal_i2cdev_xfer(oled, ctx, &seg, 1);
+}
+
+const ssd1306_i2c_transport_t ssd1306_i2c_transport_i2cdev = {
+    .name = "i2c-dev",
+    .open = ssd1306_i2c_internal_i2cdev_open,
+    .write_cmds = ssd1306_i2c_internal_i2cdev_write,
+    .write_data = ssd1306_i2c_internal_i2cdev_write,
+    .xfer = ssd1306_i2c_internal_i2cdev_xfer,
+    .close = ssd1306_i2c_internal_i2cdev_close,
+    .capabilities = ssd1306_i2c_internal_i2cdev_caps
+};
+
+// writes one transaction with write_cmds() or write_data() depending on the
+// D/C# bit of the control byte, split into chunk_size pieces if set
+static int ssd1306_i2c_internal_write_seg(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *seg)
+{
+    const ssd1306_i2c_transport_t *tp = oled->transport;
+    int (*wr)(ssd1306_i2c_t *, void *, const uint8_t *, size_t) =
+            SSD1306_I2C_SEG_IS_DATA(seg) ? tp->write_data : tp->write_cmds;
+    const size_t chunk = oled->chunk_size;
+    if (chunk == 0 || !oled->chunk_buffer || seg->len <= chunk + 1) {
+        return wr(oled, oled->transport_ctx, seg->buf, seg->len);
+    }
+    const uint8_t *payload = &(seg->buf[1]);
+    size_t left = seg->len - 1;
+    while (left > 0) {
+        size_t n = (left < chunk) ? left : chunk;
+        oled->chunk_buffer[0] = seg->buf[0];
+        memcpy(&(oled->chunk_buffer[1]), payload, n);
+        if (wr(oled, oled->transport_ctx, oled->chunk_buffer, n + 1) < 0)
+            return -1;
+        payload += n;
+        left -= n;
     }
-    fprintf(err_fp, "INFO: Wrote %zd bytes of screen buffer to device fd %d\n", nb, oled->fd);
     return 0;
 }
 
-int ssd1306_i2c_display_clear(ssd1306_i2c_t *oled)
+// registers tracked by the register cache
+enum {
+    SSD1306_I2C_REG_DISPLAY_ON = 0, // AE/AF
+    SSD1306_I2C_REG_MEM_MODE, // 20
+    SSD1306_I2C_REG_COLUMN, // 21
+    SSD1306_I2C_REG_PAGE, // 22
+    SSD1306_I2C_REG_START_LINE, // 40-7F
+    SSD1306_I2C_REG_OFFSET, // D3
+    SSD1306_I2C_REG_CLOCK, // D5
+    SSD1306_I2C_REG_CONTRAST, // 81
+    SSD1306_I2C_REG_INVERT, // A6/A7
+    SSD1306_I2C_REG_ENTIRE_ON, // A4/A5
+    SSD1306_I2C_REG_SEG_REMAP, // A0/A1
+    SSD1306_I2C_REG_MUX, // A8
+    SSD1306_I2C_REG_COM_SCAN, // C0/C8
+    SSD1306_I2C_REG_COM_PINS, // DA
+    SSD1306_I2C_REG_PRECHARGE, // D9
+    SSD1306_I2C_REG_VCOMH, // DB
+    SSD1306_I2C_REG_CHARGE_PUMP, // 8D
+    SSD1306_I2C_REG_VSCROLL_AREA, // A3
+    SSD1306_I2C_REG_SCROLL, // 2E/2F
+    SSD1306_I2C_REG_POINTER_COL, // GDDRAM pointer column
+    SSD1306_I2C_REG_POINTER_PAGE, // GDDRAM pointer page
+    SSD1306_I2C_REG_COUNT
+};
+#if SSD1306_I2C_REG_COUNT > SSD1306_I2C_REGCACHE_SIZE
+#error "SSD1306_I2C_REGCACHE_SIZE is too small"
+#endif
+
+// returned by ssd1306_i2c_internal_cmd_reg() for opcodes whose argument count
+// is not known
+#define SSD1306_I2C_REG_UNKNOWN (-2)
+
+// maps a command byte to the register it sets and the number of argument
+// bytes that follow it. returns -1 for commands that are not cached
+static int ssd1306_i2c_internal_cmd_reg(uint8_t op, size_t *nargs)
 {
-    if (oled != NULL && oled->gddram_buffer != NULL && oled->gddram_buffer_len > 0) {
-        memset(oled->gddram_buffer, 0, sizeof(uint8_t) * oled->gddram_buffer_len);
-        return ssd1306_i2c_display_update(oled, NULL);
-    } else {
-        FILE *err_fp = SSD1306_I2C_GET_ERRFP(oled);
-        fprintf(err_fp, "ERROR: Invalid OLED object. Failed to clear display\n");
-        return -1;
+    *nargs = 0;
+    if (op >= 0x40 && op <= 0x7F)
+        return SSD1306_I2C_REG_START_LINE;
+    switch (op) {
+    case 0xAE: case 0xAF: return SSD1306_I2C_REG_DISPLAY_ON;
+    case 0x20: *nargs = 1; return SSD1306_I2C_REG_MEM_MODE;
+    case 0x21: *nargs = 2; return SSD1306_I2C_REG_COLUMN;
+    case 0x22: *nargs = 2; return SSD1306_I2C_REG_PAGE;
+    case 0xD3: *nargs = 1; return SSD1306_I2C_REG_OFFSET;
+    case 0xD5: *nargs = 1; return SSD1306_I2C_REG_CLOCK;
+    case 0x81: *nargs = 1; return SSD1306_I2C_REG_CONTRAST;
+    case 0xA6: case 0xA7: return SSD1306_I2C_REG_INVERT;
+    case 0xA4: case 0xA5: return SSD1306_I2C_REG_ENTIRE_ON;
+    case 0xA0: case 0xA1: return SSD1306_I2C_REG_SEG_REMAP;
+    case 0xA8: *nargs = 1; return SSD1306_I2C_REG_MUX;
+    case 0xC0: case 0xC8: return SSD1306_I2C_REG_COM_SCAN;
+    case 0xDA: *nargs = 1; return SSD1306_I2C_REG_COM_PINS;
+    case 0xD9: *nargs = 1; return SSD1306_I2C_REG_PRECHARGE;
+    case 0xDB: *nargs = 1; return SSD1306_I2C_REG_VCOMH;
+    case 0x8D: *nargs = 1; return SSD1306_I2C_REG_CHARGE_PUMP;
+    case 0xA3: *nargs = 2; return SSD1306_I2C_REG_VSCROLL_AREA;
+    case 0x2E: case 0x2F: return SSD1306_I2C_REG_SCROLL;
+    case 0x26: case 0x27: *nargs = 6; return -1; // scroll setup
+    case 0x29: case 0x2A: *nargs = 5; return -1;
+    case 0x2C: case 0x2D: *nargs = 6; return -1; // content scroll
+    case 0x23: *nargs = 1; return -1; // fade out and blink
+    case 0xD6: *nargs = 1; return -1; // zoom in
+    case 0xFD: *nargs = 1; return -1; // command lock
+    case 0xAD: *nargs = 1; return -1; // SH1106 DC-DC
+    case 0xE3: return -1; // nop
+    default:
+        // page addressing mode pointer and SH1106 pump voltage
+        if (op <= 0x1F || (op >= 0xB0 && op <= 0xB7) || (op >= 0x30 && op <= 0x33))
+            return -1;
+        return SSD1306_I2C_REG_UNKNOWN;
     }
 }
 
-const char *ssd1306_i2c_version(void)
+#define SSD1306_I2C_REG_VALID(RC,R) (((RC)->valid >> (R)) & 1)
+#define SSD1306_I2C_REG_POINTER_BITS \
+    ((1U << SSD1306_I2C_REG_POINTER_COL) | (1U << SSD1306_I2C_REG_POINTER_PAGE))
+
+// true if the GDDRAM pointer moves through a window in horizontal or vertical
+// addressing mode and its position is known
+static inline bool ssd1306_i2c_internal_regcache_windowed(const ssd1306_i2c_regcache_t *rc)
 {
-    return LIBSSD1306_PACKAGE_VERSION;
+    return SSD1306_I2C_REG_VALID(rc, SSD1306_I2C_REG_MEM_MODE) &&
+        rc->val[SSD1306_I2C_REG_MEM_MODE][0] < 2;
 }
 
-int ssd1306_i2c_search_addresses(ssd1306_i2c_dev_t **devs, size_t *num_devs, FILE *logerr)
+// updates the cache with one command. returns true if the command would not
+// change anything on the controller and can be left out
+static bool ssd1306_i2c_internal_regcache_cmd(ssd1306_i2c_regcache_t *rc,
+        const uint8_t *cmd, size_t nargs, int reg)
 {
-#if LIBSSD1306_HAVE_I2C_SMBUS_H
-    if (devs && num_devs) {
-        FILE *err_fp = logerr == NULL ? stderr : logerr;
-        const size_t max_devs = 32;
-        ssd1306_i2c_dev_t *devarr = calloc(max_devs, sizeof(ssd1306_i2c_dev_t));
-        if (!devarr) {
-            fprintf(err_fp, "ERROR: Failed to allocate memory of size %zu bytes\n",
-                    sizeof(ssd1306_i2c_dev_t) * max_devs);
-            return -1;
+    const uint8_t op = cmd[0];
+    // values are the command byte for opcode selected settings, else the args
+    uint8_t v[2] = { (nargs > 0) ? cmd[1] : op, (nargs > 1) ? cmd[2] : 0 };
+    // a new scroll setup only takes effect with the next 0x2F, which must
+    // not be left out even if the last one sent was 0x2F too
+    if (op == 0x26 || op == 0x27 || op == 0x29 || op == 0x2A || op == 0xA3)
+        rc->valid &= ~(1U << SSD1306_I2C_REG_SCROLL);
+    if (reg < 0) {
+        // page addressing mode commands move the pointer in ways not modelled
+        if (op <= 0x1F || (op >= 0xB0 && op <= 0xB7))
+            rc->valid &= ~SSD1306_I2C_REG_POINTER_BITS;
+        return false;
+    }
+    bool same = SSD1306_I2C_REG_VALID(rc, reg) && rc->val[reg][0] == v[0] &&
+                rc->val[reg][1] == v[1];
+    if (reg == SSD1306_I2C_REG_COLUMN || reg == SSD1306_I2C_REG_PAGE) {
+        // setting the window also moves the pointer to its start, so it is
+        // only a no-op if the pointer is there already
+        const bool col = (reg == SSD1306_I2C_REG_COLUMN);
+        const int ptr = col ? SSD1306_I2C_REG_POINTER_COL : SSD1306_I2C_REG_POINTER_PAGE;
+        uint8_t *pos = col ? &(rc->col) : &(rc->page);
+        bool at_start = SSD1306_I2C_REG_VALID(rc, ptr) && *pos == v[0];
+        rc->val[reg][0] = v[0];
+        rc->val[reg][1] = v[1];
+        rc->valid |= (1U << reg);
+        if (!ssd1306_i2c_internal_regcache_windowed(rc)) {
+            rc->valid &= ~SSD1306_I2C_REG_POINTER_BITS;
+            return false;
+        }
+        *pos = v[0];
+        rc->valid |= (1U << ptr);
+        return same && at_start;
+    }
+    if (reg == SSD1306_I2C_REG_MEM_MODE && !same)
+        rc->valid &= ~SSD1306_I2C_REG_POINTER_BITS;
+    rc->val[reg][0] = v[0];
+    rc->val[reg][1] = v[1];
+    rc->valid |= (1U << reg);
+    return same;
+}
+
+// advances the GDDRAM pointer past len bytes of data
+static void ssd1306_i2c_internal_regcache_data(ssd1306_i2c_regcache_t *rc, size_t len)
+{
+    if ((rc->valid & SSD1306_I2C_REG_POINTER_BITS) != SSD1306_I2C_REG_POINTER_BITS ||
+        !ssd1306_i2c_internal_regcache_windowed(rc)) {
+        rc->valid &= ~SSD1306_I2C_REG_POINTER_BITS;
+        return;
+    }
+    const uint8_t c0 = rc->val[SSD1306_I2C_REG_COLUMN][0];
+    const uint8_t p0 = rc->val[SSD1306_I2C_REG_PAGE][0];
+    const size_t ncols = rc->val[SSD1306_I2C_REG_COLUMN][1] - c0 + 1;
+    const size_t npages = rc->val[SSD1306_I2C_REG_PAGE][1] - p0 + 1;
+    if (rc->val[SSD1306_I2C_REG_COLUMN][1] < c0 || rc->val[SSD1306_I2C_REG_PAGE][1] < p0 ||
+        rc->col < c0 || rc->page < p0) {
+        rc->valid &= ~SSD1306_I2C_REG_POINTER_BITS;
+        return;
+    }
+    if (rc->val[SSD1306_I2C_REG_MEM_MODE][0] == 0) {
+        size_t off = ((rc->page - p0) * ncols + (rc->col - c0) + len) % (ncols * npages);
+        rc->page = (uint8_t)(p0 + off / ncols);
+        rc->col = (uint8_t)(c0 + off % ncols);
+    } else {
+        size_t off = ((rc->col - c0) * npages + (rc->page - p0) + len) % (ncols * npages);
+        rc->col = (uint8_t)(c0 + off / npages);
+        rc->page = (uint8_t)(p0 + off % npages);
+    }
+}
+
+// runs the segments through the cache, dropping commands that change nothing
+// into scratch. returns the number of segments left in out
+static size_t ssd1306_i2c_internal_regcache_filter(ssd1306_i2c_regcache_t *rc,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs, ssd1306_i2c_seg_t *out,
+        uint8_t *scratch, size_t scratch_max)
+{
+    size_t nout = 0, used = 0;
+    for (size_t idx = 0; idx < nsegs; ++idx) {
+        const ssd1306_i2c_seg_t *seg = &segs[idx];
+        if (seg->len == 0)
+            continue;
+        if (SSD1306_I2C_SEG_IS_DATA(seg)) {
+            ssd1306_i2c_internal_regcache_data(rc, seg->len - 1);
+            out[nout++] = *seg;
+            continue;
         }
-        size_t devarridx = 0;
-        char errbuf[128];
-        for (size_t idx = 0; idx < max_devs; ++idx) {
-            //fill the buffer in the allocated path.
-            snprintf(devarr[devarridx].dev, 128, "/dev/i2c-%d", idx);
-            int fd = open(devarr[devarridx].dev, O_RDWR);
-            if (fd < 0) {
-                int errnum = errno;
-                if (errnum == ENODEV || errnum == ENOENT) {
-                    //try another format
-                    snprintf(devarr[devarridx].dev, 128, "/dev/i2c/%d", idx);
-                    fd = open(devarr[devarridx].dev, O_RDWR);
-                    if (fd < 0) {
-                        errnum = errno;
-                        if (errnum == ENODEV || errnum == ENOENT) {
-                            continue;
-                        } else {
-                            fprintf(err_fp, "Device %s has unexpected error: %s (%d)\n",
-                                devarr[devarridx].dev,
-                                strerror_r(errnum, errbuf, sizeof(errbuf)), errnum);
-                        }
-                    }
-                } else {
-                    fprintf(err_fp, "Device %s has unexpected error: %s (%d)\n",
-                            devarr[devarridx].dev,
-                            strerror_r(errnum, errbuf, sizeof(errbuf)), errnum);
+        // a stream with Co set or no room to filter goes out unchanged, and
+        // leaves the cache unsure of what it did
+        bool copy = !(seg->buf[0] & 0x80) && (used + seg->len <= scratch_max);
+        uint8_t *dst = &scratch[used];
+        size_t dlen = 0;
+        if (copy)
+            dst[dlen++] = seg->buf[0];
+        for (size_t pos = 1; pos < seg->len; ) {
+            size_t nargs = 0;
+            int reg = ssd1306_i2c_internal_cmd_reg(seg->buf[pos], &nargs);
+            size_t n = 1 + nargs;
+            if (reg == SSD1306_I2C_REG_UNKNOWN) {
+                // cannot tell arguments from opcodes past here, so send the
+                // rest of the segment as is and forget what the cache knows
+                n = seg->len - pos;
+                if (copy) {
+                    memcpy(&dst[dlen], &seg->buf[pos], n);
+                    dlen += n;
                 }
+                rc->valid = 0;
+                break;
             }
-            if (fd > 0) {
-                fprintf(err_fp, "INFO: Opened %s at fd %d. Device exists!\n",
-                        devarr[devarridx].dev, fd);
-                devarr[devarridx].num_addrs = 0;
-                unsigned long ifunc = 0;
-                if (ioctl(fd, I2C_FUNCS, &ifunc) < 0) {
-                    fprintf(err_fp, "WARN: I2C Function mask not set. Return value: %ld\n",
-                            ifunc);
-                } else {
-                    fprintf(err_fp, "INFO: I2C Function mask set. Return value: %ld\n",
-                            ifunc);
-                    //is the check allowed
-                    if (ifunc & (I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_READ_BYTE)) {
-                        for (uint32_t adx = 0; adx < 0x80; adx++) {
-                            //iterate over all addresses to see if they exist
-                            int rc = ioctl(fd, I2C_SLAVE, adx);
-                            if (rc < 0) {
-                                if (errno == EBUSY) {
-                                    fprintf(err_fp, "INFO: Found address 0x%02x at fd %d but it is in use.\n",
-                                        adx, fd);
-                                }
-                                continue;
-                            }
-                            int do_read = 0;
-                            if (adx >= 0x30 || adx <= 0x37) {
-                                do_read = 1;
-                            } else if (adx >= 0x50 || adx <= 0x5F) {
-                                do_read = 1;
-                            }
-                            if ((ifunc & I2C_FUNC_SMBUS_READ_BYTE) && do_read) {
-                                rc = i2c_smbus_read_byte(fd);
-                            } else if (ifunc & I2C_FUNC_SMBUS_QUICK) {
-                                rc = i2c_smbus_write_quick(fd, I2C_SMBUS_WRITE);
-                            }
-                            if (rc < 0) {
-                                //skip
-                            } else {
-                                devarr[devarridx].addrs[devarr[devarridx].num_addrs++] = (uint8_t)adx;
-                                fprintf(err_fp, "INFO: Found address 0x%02x at fd %d.\n",
-                                        adx, fd);
-                            }
-                        }
-                    }
-                }
-                close(fd);
-                fprintf(err_fp, "INFO: Closed device %s\n",
-                        devarr[devarridx].dev);
-                devarridx++;
+            if (pos + n > seg->len) {
+                // arguments continue in another transaction
+                n = seg->len - pos;
+                if (reg >= 0)
+                    rc->valid &= ~(1U << reg);
+                reg = -1;
+                nargs = 0;
             }
+            bool noop = copy ? ssd1306_i2c_internal_regcache_cmd(rc, &seg->buf[pos],
+                                    nargs, reg) : false;
+            if (!copy) {
+                rc->valid = 0;
+            } else if (!noop) {
+                memcpy(&dst[dlen], &seg->buf[pos], n);
+                dlen += n;
+            }
+            pos += n;
+        }
+        if (!copy) {
+            out[nout++] = *seg;
+        } else if (dlen > 1) {
+            out[nout].buf = dst;
+            out[nout++].len = dlen;
+            used += dlen;
         }
-        *devs = devarr;
-        *num_devs = devarridx;
-        return 0;
     }
-#endif
-    return -1;
+    return nout;
+}
+
+uint64_t ssd1306_i2c_internal_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// capture file format, integers are little endian:
+//   header: the magic "SSD1306C", u8 version, u8 addr, u8 width, u8 height,
+//           u32 reserved
+//   record: u32 microseconds since the previous record, u8 addr, u8 flags,
+//           u16 length, followed by the transaction with its control byte
+#define SSD1306_I2C_CAPTURE_MAGIC "SSD1306C"
+#define SSD1306_I2C_CAPTURE_VERSION 1
+#define SSD1306_I2C_CAPTURE_HDR_LEN 16
+#define SSD1306_I2C_CAPTURE_REC_LEN 8
+#define SSD1306_I2C_CAPTURE_DATA 0x01 // data transaction
+#define SSD1306_I2C_CAPTURE_MORE 0x02 // the next record is in the same submission
+
+static void ssd1306_i2c_internal_put_le(uint8_t *buf, uint64_t val, size_t len)
+{
+    for (size_t idx = 0; idx < len; ++idx)
+        buf[idx] = (uint8_t)(val >> (8 * idx));
+}
+
+static uint64_t ssd1306_i2c_internal_get_le(const uint8_t *buf, size_t len)
+{
+    uint64_t val = 0;
+    for (size_t idx = 0; idx < len; ++idx)
+        val |= (uint64_t)buf[idx] << (8 * idx);
+    return val;
+}
+
+// appends a submission that went out to the capture file. a write error
+// ends the capture
+static void ssd1306_i2c_internal_capture(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    uint64_t now = ssd1306_i2c_internal_now_ns();
+    for (size_t idx = 0; idx < nsegs; ++idx) {
+        uint8_t rec[SSD1306_I2C_CAPTURE_REC_LEN];
+        uint64_t usecs = (now - oled->capture_ns) / 1000;
+        ssd1306_i2c_internal_put_le(rec, (usecs > UINT32_MAX) ? UINT32_MAX : usecs, 4);
+        rec[4] = oled->addr;
+        rec[5] = (SSD1306_I2C_SEG_IS_DATA(&segs[idx]) ? SSD1306_I2C_CAPTURE_DATA : 0) |
+                    ((idx + 1 < nsegs) ? SSD1306_I2C_CAPTURE_MORE : 0);
+        ssd1306_i2c_internal_put_le(&rec[6], segs[idx].len, 2);
+        if (segs[idx].len > UINT16_MAX ||
+            fwrite(rec, 1, sizeof(rec), oled->capture) != sizeof(rec) ||
+            fwrite(segs[idx].buf, 1, segs[idx].len, oled->capture) != segs[idx].len) {
+            SSD1306_LOG_WARN(oled->err, "Failed to write the capture. Stopping it");
+            fclose(oled->capture);
+            oled->capture = NULL;
+            return;
+        }
+        oled->capture_ns = now;
+    }
+}
+
+// sends the segments to the device through the transport, in one call if it
+// has xfer() or one transaction at a time otherwise
+int ssd1306_i2c_internal_xfer_send(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    const ssd1306_i2c_transport_t *tp = oled->transport;
+    if (tp->xfer) {
+        if (tp->xfer(oled, oled->transport_ctx, segs, nsegs) < 0) {
+            if (nsegs == 1) {
+                ssd1306_i2c_internal_log_seg(oled, &segs[0], true);
+            } else {
+                SSD1306_LOG_ERROR(err, "Failed to send %zu transactions to device fd %d: %s",
+                        nsegs, oled->fd, oled->err->errbuf);
+            }
+            return -1;
+        }
+        for (size_t idx = 0; idx < nsegs; ++idx) {
+            ssd1306_i2c_internal_log_seg(oled, &segs[idx], false);
+            oled->tx_bytes += segs[idx].len;
+        }
+        if (oled->capture)
+            ssd1306_i2c_internal_capture(oled, segs, nsegs);
+        return 0;
+    }
+    for (size_t idx = 0; idx < nsegs; ++idx) {
+        int rc = ssd1306_i2c_internal_write_seg(oled, &segs[idx]);
+        ssd1306_i2c_internal_log_seg(oled, &segs[idx], rc < 0);
+        if (rc < 0) {
+            if (oled->capture && idx > 0)
+                ssd1306_i2c_internal_capture(oled, segs, idx);
+            return -1;
+        }
+        oled->tx_bytes += segs[idx].len;
+    }
+    if (oled->capture)
+        ssd1306_i2c_internal_capture(oled, segs, nsegs);
+    return 0;
+}
+
+static int ssd1306_i2c_internal_xfer_raw(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+#ifdef SSD1306_I2C_HAVE_FLOCK
+    if (oled->arbiter)
+        return ssd1306_i2c_internal_arb_xfer(oled, segs, nsegs);
+#endif
+    return ssd1306_i2c_internal_xfer_send(oled, segs, nsegs);
+}
+
+// hardware effects. refer ssd1306_i2c_fx_fade()
+#define SSD1306_I2C_FX_STEP_NS 16000000ULL // fade steps, about 60 per second
+#define SSD1306_I2C_FX_MERGE_SEGS 32 // transfers with more segments are not merged into
+typedef struct {
+    bool active;
+    uint32_t pattern;
+    uint8_t nbits;
+    unsigned int repeat;
+    uint64_t step_ns;
+    uint64_t start_ns;
+} ssd1306_i2c_fx_blink_t;
+
+struct ssd1306_i2c_fx_ {
+    bool fading;
+    uint8_t from;
+    uint8_t to;
+    ssd1306_i2c_fx_curve_t curve;
+    uint64_t fade_start_ns;
+    uint64_t fade_ns;
+    ssd1306_i2c_fx_blink_t blink[2]; // by ssd1306_i2c_fx_target_t
+    // values last sent. -1 when not known
+    int contrast;
+    int state[2];
+    uint64_t next_ns; // when the next step is due. 0 when nothing runs
+    ssd1306_i2c_fx_stats_t stats;
+};
+
+// curve value at t of 0-65536 for 0-1, scaled the same
+static uint64_t ssd1306_i2c_internal_fx_curve(ssd1306_i2c_fx_curve_t curve, uint64_t t)
+{
+    const uint64_t one = 65536;
+    switch (curve) {
+    case SSD1306_I2C_FX_EASE_IN:
+        return t * t / one;
+    case SSD1306_I2C_FX_EASE_OUT:
+        return one - (one - t) * (one - t) / one;
+    case SSD1306_I2C_FX_EASE_IN_OUT:
+        return (3 * one - 2 * t) * (t * t / one) / one;
+    default:
+        return t;
+    }
+}
+
+// state of a blink pattern at now, and when it changes next. 0 when it ended
+static int ssd1306_i2c_internal_fx_blink_at(ssd1306_i2c_fx_blink_t *b, uint64_t now,
+        uint64_t *next)
+{
+    uint64_t step = (now - b->start_ns) / b->step_ns;
+    if (b->repeat > 0 && step >= (uint64_t)b->nbits * b->repeat) {
+        b->active = false;
+        return 0;
+    }
+    uint64_t when = b->start_ns + (step + 1) * b->step_ns;
+    if (*next == 0 || when < *next)
+        *next = when;
+    return (b->pattern >> (step % b->nbits)) & 0x1;
+}
+
+// encodes the steps of the running effects that differ from what the
+// controller shows into cmds, after a control byte. returns the length or 0
+// if there is nothing to send
+static size_t ssd1306_i2c_internal_fx_encode(ssd1306_i2c_fx_t *fx, uint64_t now,
+        uint8_t *cmds)
+{
+    size_t len = 1;
+    uint64_t next = 0;
+    cmds[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    if (fx->fading) {
+        int value = fx->to;
+        if (now < fx->fade_start_ns + fx->fade_ns) {
+            uint64_t t = (now - fx->fade_start_ns) * 65536 / fx->fade_ns;
+            int64_t span = (int64_t)fx->to - fx->from;
+            value = fx->from + (int)(span * (int64_t)ssd1306_i2c_internal_fx_curve(fx->curve, t) / 65536);
+            next = now + SSD1306_I2C_FX_STEP_NS;
+            if (next > fx->fade_start_ns + fx->fade_ns)
+                next = fx->fade_start_ns + fx->fade_ns;
+        } else {
+            fx->fading = false;
+        }
+        if (value != fx->contrast) {
+            cmds[len++] = 0x81; // contrast
+            cmds[len++] = (uint8_t)value;
+            fx->contrast = value;
+        }
+    }
+    static const uint8_t opcodes[2][2] = { { 0xA6, 0xA7 }, { 0xA4, 0xA5 } };
+    for (size_t idx = 0; idx < 2; ++idx) {
+        if (!fx->blink[idx].active)
+            continue;
+        int on = ssd1306_i2c_internal_fx_blink_at(&(fx->blink[idx]), now, &next);
+        if (on != fx->state[idx]) {
+            cmds[len++] = opcodes[idx][on];
+            fx->state[idx] = on;
+        }
+    }
+    fx->next_ns = next;
+    if (len == 1)
+        return 0;
+    fx->stats.steps++;
+    fx->stats.bytes += len;
+    return len;
+}
+
+// after the controller was initialized or written to behind our back
+static void ssd1306_i2c_internal_fx_forget(ssd1306_i2c_fx_t *fx)
+{
+    if (fx) {
+        fx->contrast = -1;
+        fx->state[0] = fx->state[1] = -1;
+    }
+}
+
+// sends the segments leaving out commands that would not change the
+// controller's state
+static int ssd1306_i2c_internal_xfer_cached(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    if (!oled->regcache_enabled)
+        return ssd1306_i2c_internal_xfer_raw(oled, segs, nsegs);
+    if (nsegs > SSD1306_I2C_REGCACHE_SEGS_MAX) {
+        oled->regcache.valid = 0;
+        return ssd1306_i2c_internal_xfer_raw(oled, segs, nsegs);
+    }
+    ssd1306_i2c_regcache_t rc = oled->regcache;
+    ssd1306_i2c_seg_t out[SSD1306_I2C_REGCACHE_SEGS_MAX];
+    uint8_t scratch[SSD1306_I2C_REGCACHE_SEGS_MAX * SSD1306_I2C_CMD_BYTES_MAX];
+    size_t nout = ssd1306_i2c_internal_regcache_filter(&rc, segs, nsegs, out,
+                        scratch, sizeof(scratch));
+    if (nout == 0) {
+        oled->regcache = rc;
+        return 0;
+    }
+    if (ssd1306_i2c_internal_xfer_raw(oled, out, nout) < 0) {
+        // part of it may have reached the controller
+        oled->regcache.valid = 0;
+        return -1;
+    }
+    oled->regcache = rc;
+    return 0;
+}
+
+// sends the segments, led by the effect steps that are due
+int ssd1306_i2c_internal_xfer(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs)
+{
+    ssd1306_i2c_fx_t *fx = oled->fx;
+    uint64_t now = 0;
+    if (!fx || fx->next_ns == 0 || (now = ssd1306_i2c_internal_now_ns()) < fx->next_ns)
+        return ssd1306_i2c_internal_xfer_cached(oled, segs, nsegs);
+    uint8_t cmds[8];
+    ssd1306_i2c_seg_t merged[SSD1306_I2C_FX_MERGE_SEGS];
+    merged[0].buf = cmds;
+    merged[0].len = ssd1306_i2c_internal_fx_encode(fx, now, cmds);
+    if (merged[0].len == 0)
+        return ssd1306_i2c_internal_xfer_cached(oled, segs, nsegs);
+    if (nsegs + 1 > SSD1306_I2C_FX_MERGE_SEGS) {
+        if (ssd1306_i2c_internal_xfer_cached(oled, merged, 1) < 0) {
+            ssd1306_i2c_internal_fx_forget(fx);
+            return -1;
+        }
+        return ssd1306_i2c_internal_xfer_cached(oled, segs, nsegs);
+    }
+    memcpy(&merged[1], segs, nsegs * sizeof(*segs));
+    fx->stats.merged++;
+    int rc = ssd1306_i2c_internal_xfer_cached(oled, merged, nsegs + 1);
+    if (rc < 0)
+        ssd1306_i2c_internal_fx_forget(fx);
+    return rc;
+}
+
+// sends the step that is due, if any, and returns the CLOCK_MONOTONIC time
+// of the next one in next_ns, 0 if there is none
+static int ssd1306_i2c_internal_fx_run(ssd1306_i2c_t *oled, uint64_t *now_ns,
+        uint64_t *next_ns)
+{
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    ssd1306_i2c_fx_t *fx = oled->fx;
+    uint64_t now = ssd1306_i2c_internal_now_ns();
+    if (fx && fx->next_ns > 0 && now >= fx->next_ns) {
+        uint8_t cmds[8];
+        ssd1306_i2c_seg_t seg = { cmds, ssd1306_i2c_internal_fx_encode(fx, now, cmds) };
+        if (seg.len > 0 && ssd1306_i2c_internal_xfer_cached(oled, &seg, 1) < 0) {
+            ssd1306_i2c_internal_fx_forget(fx);
+            rc = -1;
+        }
+    }
+    *now_ns = now;
+    *next_ns = fx ? fx->next_ns : 0;
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+// writes a complete control stream (control byte followed by command bytes)
+// to the device in a single transaction
+int ssd1306_i2c_internal_write_cmds(ssd1306_i2c_t *oled,
+        const uint8_t *cmd_buf, size_t cmd_sz)
+{
+    ssd1306_i2c_seg_t seg = { cmd_buf, cmd_sz };
+    return ssd1306_i2c_internal_xfer(oled, &seg, 1);
+}
+
+// contrast set by ssd1306_i2c_display_initialize() and a warm start recovery
+#define SSD1306_I2C_INIT_CONTRAST 0xFF
+
+int ssd1306_i2c_display_initialize(ssd1306_i2c_t *oled)
+{
+    int rc = 0;
+    uint8_t data;
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    const ssd1306_i2c_profile_t *prof = oled->profile;
+    // the whole sequence is encoded into a single control stream and sent in
+    // one transaction
+    uint8_t cmds[SSD1306_I2C_CMD_BATCH_MAX];
+    size_t clen = 0;
+    cmds[clen++] = 0x00; // Co: 0 D/C#: 0 0b00000000
+#define SSD1306_I2C_INIT_CMD(C,D,L) do { \
+    size_t _sz = ssd1306_i2c_internal_append_cmd(err, (C), (D), (L), \
+                        &cmds[clen], sizeof(cmds) - clen); \
+    if (_sz == 0) \
+        rc = -1; \
+    clen += _sz; \
+} while (0)
+    do {
+        // power off the display before doing anything
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_POWER_OFF, 0, 0);
+        if (rc < 0) break;
+        // force horizontal memory addressing, if the controller has it
+        if (!prof->page_addressing_only) {
+            SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_MEM_ADDR_HORIZ, 0, 0);
+            if (rc < 0) break;
+        }
+        // these instructions are from the software configuration section 15.2.3 in
+        // the datasheet
+        // Set MUX Ratio 0xA8, 0x3F
+        data = oled->height - 1;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_MUX_RATIO, &data, 1);
+        if (rc < 0) break;
+        // Set display offset 0xD3, 0x00
+        data = 0x00;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_DISP_OFFSET, &data, 1);
+        if (rc < 0) break;
+        // set display start line 0x40
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_DISP_START_LINE, 0, 0);
+        if (rc < 0) break;
+        // set segment remap 0xA0/0xA1
+        data = 0x01;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_SEG_REMAP, &data, 1);
+        if (rc < 0) break;
+        // set com output scan direction 0xC0/0xC8
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_COM_SCAN_DIRXN_INVERT, 0, 0);
+        if (rc < 0) break;
+        // set com pins hardware config 0xDA, 0x02
+        data = (oled->height == 32) ? 0x02 : 0x12;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_COM_PIN_CFG, &data, 1);
+        if (rc < 0) break;
+        // set contrast control 0x81, 0xFF
+        data = SSD1306_I2C_INIT_CONTRAST;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_DISP_CONTRAST, &data, 1);
+        if (rc < 0) break;
+        // disable entire display on 0xA4
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_DISP_DISABLE_ENTIRE_ON, 0, 0);
+        if (rc < 0) break;
+        // set normal display 0xA6
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_DISP_NORMAL, 0, 0);
+        if (rc < 0) break;
+        // set osc frequency 0xD5, 0x80 for the SSD1306
+        data = prof->clock_divfreq;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_DISP_CLOCK_DIVFREQ, &data, 1);
+        if (rc < 0) break;
+        // set precharge period 0xD9, 0xF1 for the SSD1306
+        data = prof->precharge;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_PRECHARGE_PERIOD, &data, 1);
+        if (rc < 0) break;
+        // set Vcomh Deselect 0xDB 0x30 for the SSD1306
+        data = prof->vcomh;
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_VCOMH_DESELECT, &data, 1);
+        if (rc < 0) break;
+        // enable charge pump regulator 0x8D, 0x14
+        // charge pump has to be followed by a power on. section 15.2.1 in datasheet
+        if (prof->charge_pump) {
+            SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_ENABLE_CHARGE_PUMP, 0, 0);
+            if (rc < 0) break;
+        }
+        // the SH1106 DC-DC converter 0xAD, 0x8B
+        if (prof->dcdc) {
+            data = prof->dcdc;
+            SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_SH1106_DCDC, &data, 1);
+            if (rc < 0) break;
+        }
+        // power display on 0xAF
+        SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_POWER_ON, 0, 0);
+        if (rc < 0) break;
+        // deactivate scrolling
+        if (prof->hw_scroll) {
+            SSD1306_I2C_INIT_CMD(SSD1306_I2C_CMD_SCROLL_DEACTIVATE, 0, 0);
+            if (rc < 0) break;
+        }
+        SSD1306_I2C_LOCK(oled);
+        // the panel may have been reset, so send everything
+        oled->regcache.valid = 0;
+        rc |= ssd1306_i2c_internal_write_cmds(oled, cmds, clen);
+        oled->flip_front = 0; // the start line is 0
+        ssd1306_i2c_internal_fx_forget(oled->fx);
+        SSD1306_I2C_UNLOCK(oled);
+        if (rc < 0) break;
+        // clear the screen
+        rc |= ssd1306_i2c_display_clear(oled);
+        if (rc < 0) break;
+    } while (0);
+#undef SSD1306_I2C_INIT_CMD
+    return rc;
+}
+
+int ssd1306_i2c_run_cmd(ssd1306_i2c_t *oled, ssd1306_i2c_cmd_t cmd, uint8_t *data, size_t dlen)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    uint8_t cmd_buf[SSD1306_I2C_CMD_BYTES_MAX + 1] = { 0 };
+    cmd_buf[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    size_t cmd_sz = ssd1306_i2c_internal_append_cmd(err, cmd, data, dlen,
+                        &cmd_buf[1], sizeof(cmd_buf) - 1);
+    if (cmd_sz == 0) {
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    if (ssd1306_i2c_internal_cmd_moves_gddram(cmd)) {
+        oled->shadow_valid = false;
+    }
+    int rc = ssd1306_i2c_internal_write_cmds(oled, cmd_buf, cmd_sz + 1);
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_cmd_batch_begin(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    if (oled->cmd_batch_len > 0) {
+        SSD1306_LOG_WARN(err, "Command batch already open with %zu bytes. Discarding it",
+                oled->cmd_batch_len - 1);
+    }
+    oled->cmd_batch[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    oled->cmd_batch_len = 1;
+    SSD1306_I2C_UNLOCK(oled);
+    return 0;
+}
+
+int ssd1306_i2c_cmd_batch_append(ssd1306_i2c_t *oled, ssd1306_i2c_cmd_t cmd, uint8_t *data, size_t dlen)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    // encode first so that a bad command is not mistaken for a full batch
+    uint8_t cmd_buf[SSD1306_I2C_CMD_BYTES_MAX] = { 0 };
+    size_t cmd_sz = ssd1306_i2c_internal_append_cmd(err, cmd, data, dlen,
+                        cmd_buf, sizeof(cmd_buf));
+    if (cmd_sz == 0) {
+        return -1;
+    }
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    do {
+        if (oled->cmd_batch_len == 0) {
+            SSD1306_LOG_ERROR(err, "No command batch open. Call ssd1306_i2c_cmd_batch_begin() first");
+            rc = -1;
+            break;
+        }
+        if (cmd_sz > SSD1306_I2C_CMD_BATCH_MAX - oled->cmd_batch_len) {
+            // the batch is full. send what we have and start over
+            rc = ssd1306_i2c_internal_write_cmds(oled, oled->cmd_batch, oled->cmd_batch_len);
+            if (rc < 0) {
+                oled->cmd_batch_len = 0;
+                break;
+            }
+            oled->cmd_batch_len = 1;
+        }
+        memcpy(&(oled->cmd_batch[oled->cmd_batch_len]), cmd_buf, cmd_sz);
+        if (ssd1306_i2c_internal_cmd_moves_gddram(cmd)) {
+            oled->shadow_valid = false;
+        }
+        oled->cmd_batch_len += cmd_sz;
+    } while (0);
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_cmd_batch_commit(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    if (oled->cmd_batch_len == 0) {
+        SSD1306_LOG_ERROR(err, "No command batch open. Call ssd1306_i2c_cmd_batch_begin() first");
+        rc = -1;
+    } else if (oled->cmd_batch_len > 1) {
+        rc = ssd1306_i2c_internal_write_cmds(oled, oled->cmd_batch, oled->cmd_batch_len);
+    }
+    oled->cmd_batch_len = 0;
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+// encodes the control stream that sets the column and page address window.
+// returns the number of bytes written to cmds or 0 on error
+size_t ssd1306_i2c_internal_encode_window(ssd1306_err_t *err,
+        uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end,
+        uint8_t *cmds, size_t cmds_max)
+{
+    size_t clen = 0, sz = 0;
+    if (cmds_max < 1)
+        return 0;
+    cmds[clen++] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    uint8_t x[2] = { col_start, col_end };
+    sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_COLUMN_ADDR, x, 2,
+                    &cmds[clen], cmds_max - clen);
+    if (sz == 0)
+        return 0;
+    clen += sz;
+    x[0] = page_start;
+    x[1] = page_end;
+    sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_PAGE_ADDR, x, 2,
+                    &cmds[clen], cmds_max - clen);
+    if (sz == 0)
+        return 0;
+    clen += sz;
+    return clen;
+}
+
+// finds the first and last differing byte between a and b. compares a word at
+// a time and returns false if both are identical.
+static bool ssd1306_i2c_internal_diff_span(const uint8_t *a, const uint8_t *b,
+        size_t n, size_t *lo, size_t *hi)
+{
+    uint64_t wa, wb;
+    size_t i = 0;
+    while (i + sizeof(wa) <= n) {
+        memcpy(&wa, &a[i], sizeof(wa));
+        memcpy(&wb, &b[i], sizeof(wb));
+        if (wa != wb)
+            break;
+        i += sizeof(wa);
+    }
+    while (i < n && a[i] == b[i])
+        ++i;
+    if (i == n)
+        return false;
+    size_t j = n;
+    while (j >= i + sizeof(wa)) {
+        memcpy(&wa, &a[j - sizeof(wa)], sizeof(wa));
+        memcpy(&wb, &b[j - sizeof(wb)], sizeof(wb));
+        if (wa != wb)
+            break;
+        j -= sizeof(wa);
+    }
+    while (j > i && a[j - 1] == b[j - 1])
+        --j;
+    *lo = i;
+    *hi = j - 1;
+    return true;
+}
+
+// encodes the control stream that addresses the rectangle. controllers with
+// page addressing only take one page at a time. returns the number of bytes
+// written to cmds or 0 on error
+size_t ssd1306_i2c_internal_encode_rect(const ssd1306_i2c_t *oled,
+        const ssd1306_i2c_rect_t *r, uint8_t *cmds, size_t cmds_max)
+{
+    const ssd1306_i2c_profile_t *prof = oled->profile;
+    if (!prof->page_addressing_only) {
+        return ssd1306_i2c_internal_encode_window(SSD1306_I2C_GET_ERR(oled),
+                    r->col_start + prof->column_offset, r->col_end + prof->column_offset,
+                    r->page_start, r->page_end, cmds, cmds_max);
+    }
+    if (r->page_start != r->page_end || cmds_max < 4)
+        return 0;
+    uint8_t col = r->col_start + prof->column_offset;
+    cmds[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    cmds[1] = 0xB0 | (r->page_start & 0x07); // page start address
+    cmds[2] = 0x00 | (col & 0x0F); // lower nibble of the column
+    cmds[3] = 0x10 | (col >> 4); // higher nibble of the column
+    return 4;
+}
+
+// writes the rectangles of src, each a window and a data segment, all in one
+// submission and copies them to the shadow
+static int ssd1306_i2c_internal_send_rects(ssd1306_i2c_t *oled, const uint8_t *src,
+        const ssd1306_i2c_rect_t *rects, size_t nrects)
+{
+    const size_t width = oled->width;
+    uint8_t cmds[SSD1306_I2C_RAM_PAGES][2 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    ssd1306_i2c_seg_t segs[2 * SSD1306_I2C_RAM_PAGES];
+    size_t nsegs = 0;
+    size_t xlen = 0;
+    if (nrects > SSD1306_I2C_RAM_PAGES)
+        return -1;
+    for (size_t idx = 0; idx < nrects; ++idx) {
+        const ssd1306_i2c_rect_t *r = &rects[idx];
+        size_t ncols = r->col_end - r->col_start + 1;
+        size_t clen = ssd1306_i2c_internal_encode_rect(oled, r, cmds[idx], sizeof(cmds[idx]));
+        if (clen == 0)
+            return -1;
+        segs[nsegs].buf = cmds[idx];
+        segs[nsegs++].len = clen;
+        segs[nsegs].buf = &(oled->xfer_buffer[xlen]);
+        oled->xfer_buffer[xlen++] = 0x40; // Co: 0 D/C#: 1 0b01000000
+        for (size_t p = r->page_start; p <= r->page_end; ++p) {
+            size_t off = p * width + r->col_start;
+            memcpy(&(oled->xfer_buffer[xlen]), &src[off], ncols);
+            xlen += ncols;
+        }
+        segs[nsegs].len = &(oled->xfer_buffer[xlen]) - segs[nsegs].buf;
+        nsegs++;
+    }
+    if (ssd1306_i2c_internal_xfer(oled, segs, nsegs) < 0) {
+        oled->shadow_valid = false;
+        return -1;
+    }
+    if (!oled->shadow_buffer)
+        return 0;
+    for (size_t idx = 0; idx < nrects; ++idx) {
+        const ssd1306_i2c_rect_t *r = &rects[idx];
+        size_t ncols = r->col_end - r->col_start + 1;
+        for (size_t p = r->page_start; p <= r->page_end; ++p) {
+            size_t off = p * width + r->col_start;
+            memcpy(&(oled->shadow_buffer[off]), &src[off], ncols);
+        }
+    }
+    return 0;
+}
+
+// estimated bus cost in bytes of writing the rectangle: two transactions,
+// the address window commands and the data with its control byte
+static size_t ssd1306_i2c_internal_rect_cost(const ssd1306_i2c_t *oled,
+        const ssd1306_i2c_rect_t *r)
+{
+    size_t npages = r->page_end - r->page_start + 1;
+    size_t ncols = r->col_end - r->col_start + 1;
+    return 2 * oled->shadow_xfer_overhead + 7 + 1 + npages * ncols;
+}
+
+// compares src against the shadow and sends only the changed rectangles.
+// a non-zero budget limits the estimated cost of what is sent.
+// returns 0 if done, 1 if a full update is cheaper, 2 if changes were left
+// out to stay within the budget and -1 on error
+static int ssd1306_i2c_internal_update_partial(ssd1306_i2c_t *oled,
+        const uint8_t *src, size_t budget)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    (void)err; // only used by INFO logging which NDEBUG compiles out
+    const size_t width = oled->width;
+    const size_t pages = oled->height / 8;
+    ssd1306_i2c_rect_t rects[SSD1306_I2C_RAM_PAGES];
+    size_t nrects = 0;
+    size_t total = 0;
+    for (size_t p = 0; p < pages; ++p) {
+        size_t lo = 0, hi = 0;
+        if (!ssd1306_i2c_internal_diff_span(&src[p * width],
+                    &(oled->shadow_buffer[p * width]), width, &lo, &hi)) {
+            continue;
+        }
+        ssd1306_i2c_rect_t r = { p, p, lo, hi };
+        if (nrects > 0 && budget == 0 && !oled->profile->page_addressing_only) {
+            // merge with the previous rectangle if a single larger window is
+            // cheaper than two transactions. with a budget pages are kept
+            // apart so that they can be sent over several updates
+            ssd1306_i2c_rect_t *last = &rects[nrects - 1];
+            ssd1306_i2c_rect_t m = {
+                last->page_start, p,
+                (last->col_start < lo) ? last->col_start : lo,
+                (last->col_end > hi) ? last->col_end : hi
+            };
+            size_t mcost = ssd1306_i2c_internal_rect_cost(oled, &m);
+            size_t lcost = ssd1306_i2c_internal_rect_cost(oled, last);
+            size_t rcost = ssd1306_i2c_internal_rect_cost(oled, &r);
+            if (mcost <= lcost + rcost) {
+                total = total - lcost + mcost;
+                *last = m;
+                continue;
+            }
+        }
+        rects[nrects++] = r;
+        total += ssd1306_i2c_internal_rect_cost(oled, &r);
+    }
+    if (nrects == 0) {
+        SSD1306_LOG_INFO(err, "Screen buffer unchanged, nothing to write to device fd %d", oled->fd);
+        return 0;
+    }
+    ssd1306_i2c_rect_t full = { 0, pages - 1, 0, width - 1 };
+    // with page addressing only a full update is all pages anyway
+    if (budget == 0 && !oled->profile->page_addressing_only &&
+        total >= ssd1306_i2c_internal_rect_cost(oled, &full)) {
+        return 1;
+    }
+    // with a budget only the rectangles that fit are sent, at least one. the
+    // rest stays different from the shadow and goes out with the next update
+    size_t nsend = nrects;
+    if (budget > 0) {
+        size_t cost = ssd1306_i2c_internal_rect_cost(oled, &rects[0]);
+        for (nsend = 1; nsend < nrects; ++nsend) {
+            cost += ssd1306_i2c_internal_rect_cost(oled, &rects[nsend]);
+            if (cost > budget)
+                break;
+        }
+    }
+    if (ssd1306_i2c_internal_send_rects(oled, src, rects, nsend) < 0)
+        return -1;
+    return (nsend < nrects) ? 2 : 0;
+}
+
+// control stream that stops scrolling and sets the address window to the
+// given pages. RAM must not be written while scrolling is active
+static size_t ssd1306_i2c_internal_ticker_pre(ssd1306_i2c_t *oled,
+        uint8_t page_start, uint8_t page_end, uint8_t *cmds, size_t cmds_max)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    size_t clen = 0, sz = 0;
+    cmds[clen++] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_SCROLL_DEACTIVATE, NULL, 0,
+                    &cmds[clen], cmds_max - clen);
+    if (sz == 0)
+        return 0;
+    clen += sz;
+    uint8_t x[2] = { 0, oled->width - 1 };
+    sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_COLUMN_ADDR, x, 2,
+                    &cmds[clen], cmds_max - clen);
+    if (sz == 0)
+        return 0;
+    clen += sz;
+    x[0] = page_start;
+    x[1] = page_end;
+    sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_PAGE_ADDR, x, 2,
+                    &cmds[clen], cmds_max - clen);
+    if (sz == 0)
+        return 0;
+    return clen + sz;
+}
+
+// control stream that sets up and activates the ticker's scroll
+static size_t ssd1306_i2c_internal_ticker_post(ssd1306_i2c_t *oled,
+        uint8_t *cmds, size_t cmds_max)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    const ssd1306_i2c_ticker_t *tk = &(oled->ticker);
+    uint8_t data[3] = { tk->page_start, tk->interval, tk->page_end };
+    cmds[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    size_t sz = ssd1306_i2c_internal_append_cmd(err, tk->scroll_right ?
+                    SSD1306_I2C_CMD_SCROLL_RIGHT_HORIZONTAL :
+                    SSD1306_I2C_CMD_SCROLL_LEFT_HORIZONTAL,
+                    data, 3, &cmds[1], cmds_max - 1);
+    return (sz == 0) ? 0 : sz + 1;
+}
+
+// stops scrolling, writes the pages in data (control byte included) and
+// restarts the scroll, all in one submission
+static int ssd1306_i2c_internal_ticker_xfer(ssd1306_i2c_t *oled,
+        uint8_t page_start, uint8_t page_end, const uint8_t *data, size_t dlen)
+{
+    uint8_t pre[3 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    uint8_t post[SSD1306_I2C_CMD_BYTES_MAX + 1];
+    size_t prelen = ssd1306_i2c_internal_ticker_pre(oled, page_start, page_end,
+                            pre, sizeof(pre));
+    size_t postlen = ssd1306_i2c_internal_ticker_post(oled, post, sizeof(post));
+    if (prelen == 0 || postlen == 0)
+        return -1;
+    ssd1306_i2c_seg_t segs[3] = {
+        { pre, prelen },
+        { data, dlen },
+        { post, postlen }
+    };
+    // the scrolled band never matches the shadow
+    oled->shadow_valid = false;
+    return ssd1306_i2c_internal_xfer(oled, segs, 3);
+}
+
+// writes rectangles outside the band while the ticker runs, with scrolling
+// stopped around them
+static int ssd1306_i2c_internal_ticker_rects(ssd1306_i2c_t *oled, const uint8_t *src,
+        const ssd1306_i2c_rect_t *rects, size_t nrects)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    uint8_t pre[SSD1306_I2C_CMD_BYTES_MAX + 1];
+    uint8_t post[SSD1306_I2C_CMD_BYTES_MAX + 1];
+    pre[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    size_t prelen = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_SCROLL_DEACTIVATE,
+                        NULL, 0, &pre[1], sizeof(pre) - 1);
+    size_t postlen = ssd1306_i2c_internal_ticker_post(oled, post, sizeof(post));
+    if (prelen == 0 || postlen == 0)
+        return -1;
+    if (ssd1306_i2c_internal_write_cmds(oled, pre, prelen + 1) < 0 ||
+        ssd1306_i2c_internal_send_rects(oled, src, rects, nrects) < 0 ||
+        ssd1306_i2c_internal_write_cmds(oled, post, postlen) < 0)
+        return -1;
+    return 0;
+}
+
+// full update while the ticker runs. the band keeps the ticker's content
+static int ssd1306_i2c_internal_ticker_frame(ssd1306_i2c_t *oled, const uint8_t *src)
+{
+    const ssd1306_i2c_ticker_t *tk = &(oled->ticker);
+    const size_t width = oled->width;
+    if (src != &(oled->gddram_buffer[1]))
+        memcpy(&(oled->gddram_buffer[1]), src, oled->gddram_buffer_len - 1);
+    memcpy(&(oled->gddram_buffer[1 + tk->page_start * width]), oled->ticker_band,
+            (tk->page_end - tk->page_start + 1) * width);
+    oled->gddram_buffer[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+    return ssd1306_i2c_internal_ticker_xfer(oled, 0, (oled->height / 8) - 1,
+                oled->gddram_buffer, oled->gddram_buffer_len);
+}
+
+// the control byte in front of a framebuffer from ssd1306_i2c_framebuffer_create(),
+// which lets it be sent without a copy. NULL for any other framebuffer
+const uint8_t *ssd1306_i2c_internal_fb_xfer(const ssd1306_framebuffer_t *fbp)
+{
+    return (fbp->prefix_len > 0 && fbp->buffer[-1] == 0x40) ? fbp->buffer - 1 : NULL;
+}
+
+// writes the frame in src to GDDRAM from page ram_page on. xfer, if not NULL,
+// must point to the byte before src which holds the data control byte.
+// post, if not NULL, is a control stream sent after the data in the same
+// submission
+static int ssd1306_i2c_internal_write_pages(ssd1306_i2c_t *oled, const uint8_t *src,
+        const uint8_t *xfer, size_t ram_page, size_t npages, const uint8_t *post, size_t postlen)
+{
+    const size_t width = oled->width;
+    uint8_t cmds[SSD1306_I2C_RAM_PAGES][2 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    ssd1306_i2c_seg_t segs[2 * SSD1306_I2C_RAM_PAGES + 1];
+    size_t nsegs = 0;
+    if (ram_page + npages > SSD1306_I2C_RAM_PAGES || npages * width > oled->gddram_buffer_len - 1)
+        return -1;
+    if (oled->profile->page_addressing_only) {
+        // one write per page, staged with a control byte each
+        if (!oled->xfer_buffer)
+            return -1;
+        for (size_t p = 0; p < npages; ++p) {
+            ssd1306_i2c_rect_t r = { ram_page + p, ram_page + p, 0, width - 1 };
+            size_t clen = ssd1306_i2c_internal_encode_rect(oled, &r, cmds[p], sizeof(cmds[p]));
+            if (clen == 0)
+                return -1;
+            uint8_t *data = &(oled->xfer_buffer[p * (width + 1)]);
+            data[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+            memcpy(&data[1], &src[p * width], width);
+            segs[nsegs].buf = cmds[p];
+            segs[nsegs++].len = clen;
+            segs[nsegs].buf = data;
+            segs[nsegs++].len = width + 1;
+        }
+    } else {
+        ssd1306_i2c_rect_t r = { ram_page, ram_page + npages - 1, 0, width - 1 };
+        size_t clen = ssd1306_i2c_internal_encode_rect(oled, &r, cmds[0], sizeof(cmds[0]));
+        if (clen == 0)
+            return -1;
+        if (!xfer) {
+            memcpy(&(oled->gddram_buffer[1]), src, npages * width);
+            oled->gddram_buffer[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+            xfer = oled->gddram_buffer;
+        }
+        segs[nsegs].buf = cmds[0];
+        segs[nsegs++].len = clen;
+        segs[nsegs].buf = xfer;
+        segs[nsegs++].len = npages * width + 1;
+    }
+    if (post) {
+        segs[nsegs].buf = post;
+        segs[nsegs++].len = postlen;
+    }
+    return ssd1306_i2c_internal_xfer(oled, segs, nsegs);
+}
+
+// control stream that sets the display start line
+static size_t ssd1306_i2c_internal_start_line(ssd1306_i2c_t *oled, uint8_t line,
+        uint8_t *cmds, size_t cmds_max)
+{
+    cmds[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+    size_t sz = ssd1306_i2c_internal_append_cmd(SSD1306_I2C_GET_ERR(oled),
+                    SSD1306_I2C_CMD_DISP_START_LINE, &line, 1, &cmds[1], cmds_max - 1);
+    return (sz == 0) ? 0 : sz + 1;
+}
+
+// number of panel sized slots in GDDRAM
+static size_t ssd1306_i2c_internal_flip_slots(const ssd1306_i2c_t *oled)
+{
+    size_t ppages = oled->height / 8;
+    return (ppages > 0) ? SSD1306_I2C_RAM_PAGES / ppages : 0;
+}
+
+// writes the frame to the next hidden slot and shows it with the start line
+// in the same submission
+static int ssd1306_i2c_internal_flip_frame(ssd1306_i2c_t *oled, const uint8_t *src,
+        const uint8_t *xfer)
+{
+    size_t ppages = oled->height / 8;
+    size_t back = (oled->flip_front + 1) % ssd1306_i2c_internal_flip_slots(oled);
+    uint8_t post[SSD1306_I2C_CMD_BYTES_MAX + 1];
+    size_t postlen = ssd1306_i2c_internal_start_line(oled, (uint8_t)(back * oled->height),
+                            post, sizeof(post));
+    if (postlen == 0 ||
+        ssd1306_i2c_internal_write_pages(oled, src, xfer, back * ppages, ppages,
+            post, postlen) < 0) {
+        return -1;
+    }
+    oled->flip_front = (uint8_t)back;
+    return 0;
+}
+
+// updates the display with the frame in src. xfer, if not NULL, must point to
+// the byte right before src which holds the data control byte. otherwise
+// src gets copied into gddram_buffer for a full update.
+static int ssd1306_i2c_internal_display_update(ssd1306_i2c_t *oled,
+        const uint8_t *src, const uint8_t *xfer)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (oled->ticker_active) {
+        return ssd1306_i2c_internal_ticker_frame(oled, src);
+    }
+    if (oled->flip_enabled) {
+        return ssd1306_i2c_internal_flip_frame(oled, src, xfer);
+    }
+    if (oled->shadow_buffer && oled->shadow_valid) {
+        int rc = ssd1306_i2c_internal_update_partial(oled, src, 0);
+        if (rc <= 0)
+            return rc;
+        // a full update is cheaper
+    }
+    if (oled->profile->page_addressing_only) {
+        // one write per page
+        ssd1306_i2c_rect_t rects[SSD1306_I2C_RAM_PAGES];
+        size_t pages = oled->height / 8;
+        for (size_t p = 0; p < pages; ++p) {
+            ssd1306_i2c_rect_t r = { p, p, 0, oled->width - 1 };
+            rects[p] = r;
+        }
+        if (ssd1306_i2c_internal_send_rects(oled, src, rects, pages) < 0)
+            return -1;
+        if (oled->shadow_buffer)
+            oled->shadow_valid = true;
+        return 0;
+    }
+    uint8_t cmds[2 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    ssd1306_i2c_rect_t full = { 0, (oled->height / 8) - 1, 0, oled->width - 1 };
+    size_t clen = ssd1306_i2c_internal_encode_rect(oled, &full, cmds, sizeof(cmds));
+    if (clen == 0) {
+        SSD1306_LOG_WARN(err, "Unable to update display, exiting from earlier errors");
+        return -1;
+    }
+    if (oled->shadow_buffer) {
+        // the shadow is what the panel shows, so the frame goes out from it
+        if (src != oled->shadow_buffer)
+            memcpy(oled->shadow_buffer, src, oled->gddram_buffer_len - 1);
+        xfer = oled->shadow_buffer - 1;
+    } else if (!xfer) {
+        memcpy(&(oled->gddram_buffer[1]), src, oled->gddram_buffer_len - 1);
+        oled->gddram_buffer[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+        xfer = oled->gddram_buffer;
+    }
+    // the rest is framebuffer data for the GDDRAM as in section 8.1.5.2
+    // and goes out in the same submission as the address window
+    ssd1306_i2c_seg_t segs[2] = {
+        { cmds, clen },
+        { xfer, oled->gddram_buffer_len }
+    };
+    if (ssd1306_i2c_internal_xfer(oled, segs, 2) < 0) {
+        oled->shadow_valid = false;
+        return -1;
+    }
+    if (oled->shadow_buffer)
+        oled->shadow_valid = true;
+    return 0;
+}
+
+int ssd1306_i2c_display_update(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    // invalid data in pointer
+    if (fbp && (!(fbp->buffer) || fbp->len == 0 || (fbp->len != (oled->gddram_buffer_len - 1)))) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 framebuffer object");
+        return -1;
+    }
+    // if the framebuffer pointer is provided, we copy it to GDDRAM, otherwise
+    // we just display the GDDRAM. framebuffers with a reserved control byte
+    // are written out directly
+    const uint8_t *src = &(oled->gddram_buffer[1]);
+    const uint8_t *xfer = oled->gddram_buffer;
+    if (fbp) {
+        src = fbp->buffer;
+        xfer = ssd1306_i2c_internal_fb_xfer(fbp);
+    }
+    SSD1306_I2C_LOCK(oled);
+    // display_clear() zeroes the whole buffer
+    oled->gddram_buffer[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+    int rc = ssd1306_i2c_internal_display_update(oled, src, xfer);
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+// true if the flush thread sends frames a page at a time
+static bool ssd1306_i2c_internal_preemptible(const ssd1306_i2c_t *oled)
+{
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    return oled->async && SSD1306_ATOMIC_LOAD(&(oled->async->preempt));
+#else
+    (void)oled;
+    return false;
+#endif
+}
+
+int ssd1306_i2c_flip_enable(ssd1306_i2c_t *oled, bool enable)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->gddram_buffer) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    if (enable && ssd1306_i2c_internal_flip_slots(oled) < 2) {
+        SSD1306_LOG_ERROR(err, "A %ux%u display has no spare GDDRAM to flip to",
+                oled->width, oled->height);
+        return -1;
+    }
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    if (enable) {
+        const char *owner = oled->ticker_active ? "the ticker is running" :
+                            oled->console_active ? "a console is open" :
+                            ssd1306_i2c_internal_preemptible(oled) ?
+                                "the flush thread is preemptible" : NULL;
+        if (owner) {
+            SSD1306_LOG_ERROR(err, "Cannot flip pages while %s", owner);
+            SSD1306_I2C_UNLOCK(oled);
+            return -1;
+        }
+    }
+    if (!enable && oled->flip_enabled && oled->flip_front != 0) {
+        uint8_t cmds[SSD1306_I2C_CMD_BYTES_MAX + 1];
+        size_t clen = ssd1306_i2c_internal_start_line(oled, 0, cmds, sizeof(cmds));
+        rc = (clen > 0) ? ssd1306_i2c_internal_write_cmds(oled, cmds, clen) : -1;
+        if (rc == 0)
+            oled->flip_front = 0;
+    }
+    if (rc == 0)
+        oled->flip_enabled = enable;
+    // the shadow describes one slot only
+    oled->shadow_valid = false;
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_flip_load(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp, uint8_t slot)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->gddram_buffer || !fbp || !fbp->buffer ||
+        fbp->len != oled->gddram_buffer_len - 1) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C or framebuffer object");
+        return -1;
+    }
+    if (slot >= ssd1306_i2c_internal_flip_slots(oled)) {
+        SSD1306_LOG_ERROR(err, "Invalid slot %u for a %ux%u display", slot,
+                oled->width, oled->height);
+        return -1;
+    }
+    size_t ppages = oled->height / 8;
+    SSD1306_I2C_LOCK(oled);
+    int rc = ssd1306_i2c_internal_write_pages(oled, fbp->buffer,
+                ssd1306_i2c_internal_fb_xfer(fbp), slot * ppages, ppages, NULL, 0);
+    oled->shadow_valid = false;
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_flip_show(ssd1306_i2c_t *oled, uint8_t slot)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || slot >= ssd1306_i2c_internal_flip_slots(oled)) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object or slot");
+        return -1;
+    }
+    return ssd1306_i2c_pan_set(oled, (uint8_t)(slot * oled->height));
+}
+
+int ssd1306_i2c_pan_load(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->gddram_buffer || !fbp || !fbp->buffer ||
+        fbp->width != oled->width || fbp->height != SSD1306_I2C_RAM_PAGES * 8 ||
+        fbp->len != (size_t)fbp->width * fbp->height / 8) {
+        SSD1306_LOG_ERROR(err, "Panning needs a framebuffer as wide as the display and 64 rows high");
+        return -1;
+    }
+    // a panel sized piece at a time, as that is what gddram_buffer holds
+    size_t ppages = oled->height / 8;
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    for (size_t page = 0; page < SSD1306_I2C_RAM_PAGES && rc == 0; page += ppages) {
+        rc = ssd1306_i2c_internal_write_pages(oled, &(fbp->buffer[page * oled->width]),
+                NULL, page, ppages, NULL, 0);
+    }
+    oled->shadow_valid = false;
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_pan_set(ssd1306_i2c_t *oled, uint8_t row)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->gddram_buffer) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    row &= (SSD1306_I2C_RAM_PAGES * 8) - 1;
+    uint8_t cmds[SSD1306_I2C_CMD_BYTES_MAX + 1];
+    size_t clen = ssd1306_i2c_internal_start_line(oled, row, cmds, sizeof(cmds));
+    if (clen == 0)
+        return -1;
+    SSD1306_I2C_LOCK(oled);
+    int rc = ssd1306_i2c_internal_write_cmds(oled, cmds, clen);
+    if (rc == 0)
+        oled->flip_front = (uint8_t)((row / oled->height) % ssd1306_i2c_internal_flip_slots(oled));
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_set_chunk_size(ssd1306_i2c_t *oled, size_t chunk_size)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    if ((oled->transport_caps & SSD1306_I2C_TRANSPORT_CAP_SMBUS) &&
+        (chunk_size == 0 || chunk_size > SSD1306_I2C_SMBUS_BLOCK_MAX)) {
+        SSD1306_LOG_WARN(err, "Transport supports SMBus block writes only. Using chunk size %d",
+                SSD1306_I2C_SMBUS_BLOCK_MAX);
+        chunk_size = SSD1306_I2C_SMBUS_BLOCK_MAX;
+    }
+    if (chunk_size > UINT16_MAX - 1) {
+        chunk_size = UINT16_MAX - 1;
+    }
+    // no transaction is longer than a full frame, so larger chunks would only
+    // grow the staging buffer
+    if (oled->gddram_buffer_len > 1 && chunk_size > oled->gddram_buffer_len - 1) {
+        chunk_size = oled->gddram_buffer_len - 1;
+    }
+    uint8_t *buf = NULL;
+    size_t buflen = 0;
+    if (chunk_size > 0) {
+        // one slot per chunk for a full I2C_RDWR submission, else one slot
+        buflen = chunk_size + 1;
+#ifdef SSD1306_I2C_HAVE_RDWR
+        if ((oled->funcs & I2C_FUNC_I2C) &&
+            !(oled->transport_caps & SSD1306_I2C_TRANSPORT_CAP_SMBUS))
+            buflen *= I2C_RDWR_IOCTL_MAX_MSGS;
+#endif
+        buf = calloc(sizeof(uint8_t), buflen);
+        if (!buf) {
+            oled->err->errnum = errno;
+            strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+            SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for chunk buffer",
+                    buflen);
+            return -1;
+        }
+    }
+    SSD1306_I2C_LOCK(oled);
+    if (oled->chunk_buffer) {
+        ssd1306_i2c_internal_rt_lock(oled, oled->chunk_buffer, oled->chunk_buffer_len, false);
+        free(oled->chunk_buffer);
+    }
+    oled->chunk_buffer = buf;
+    oled->chunk_buffer_len = buf ? buflen : 0;
+    oled->chunk_size = chunk_size;
+    ssd1306_i2c_internal_rt_lock(oled, oled->chunk_buffer, oled->chunk_buffer_len, true);
+    SSD1306_I2C_UNLOCK(oled);
+    return 0;
+}
+
+ssd1306_framebuffer_t *ssd1306_i2c_framebuffer_create(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return NULL;
+    }
+    // reserve the data control byte in front of the pixels
+    ssd1306_framebuffer_t *fbp = ssd1306_framebuffer_create_prefixed(oled->width,
+                                    oled->height, 1, oled->err);
+    if (fbp) {
+        fbp->buffer[-1] = 0x40; // Co: 0 D/C#: 1 0b01000000
+    }
+    return fbp;
+}
+
+int ssd1306_i2c_shadow_enable(ssd1306_i2c_t *oled, bool enable)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    int rc = 0;
+    // the flush thread sends from these buffers
+    SSD1306_I2C_LOCK(oled);
+    do {
+        if (!enable) {
+            if (oled->shadow_buffer) {
+                ssd1306_i2c_internal_rt_lock(oled, oled->shadow_buffer - 1,
+                        oled->gddram_buffer_len, false);
+                free(oled->shadow_buffer - 1);
+            }
+            oled->shadow_buffer = NULL;
+            // page addressing controllers stage every update in xfer_buffer
+            if (oled->xfer_buffer && !oled->profile->page_addressing_only) {
+                ssd1306_i2c_internal_rt_lock(oled, oled->xfer_buffer,
+                        oled->gddram_buffer_len + 8, false);
+                free(oled->xfer_buffer);
+                oled->xfer_buffer = NULL;
+            }
+            oled->shadow_valid = false;
+            break;
+        }
+        if (oled->shadow_buffer)
+            break; // already enabled
+        // with the data control byte in front, so full updates are sent from it
+        size_t alloc_len = oled->gddram_buffer_len;
+        uint8_t *shadow = calloc(sizeof(uint8_t), oled->gddram_buffer_len);
+        if (shadow) {
+            shadow[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+            oled->shadow_buffer = &shadow[1];
+        }
+        // room for one control byte per page
+        if (!oled->xfer_buffer) {
+            alloc_len += oled->gddram_buffer_len + 8;
+            oled->xfer_buffer = calloc(sizeof(uint8_t), oled->gddram_buffer_len + 8);
+            ssd1306_i2c_internal_rt_lock(oled, oled->xfer_buffer,
+                    oled->gddram_buffer_len + 8, true);
+        }
+        if (!oled->shadow_buffer || !oled->xfer_buffer) {
+            oled->err->errnum = errno;
+            strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+            SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for shadow buffers",
+                    alloc_len);
+            ssd1306_i2c_shadow_enable(oled, false);
+            rc = -1;
+            break;
+        }
+        ssd1306_i2c_internal_rt_lock(oled, shadow, oled->gddram_buffer_len, true);
+        // the panel contents are unknown until the next full update
+        oled->shadow_valid = false;
+    } while (0);
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+void ssd1306_i2c_shadow_invalidate(ssd1306_i2c_t *oled)
+{
+    if (oled) {
+        SSD1306_I2C_LOCK(oled);
+        oled->shadow_valid = false;
+        SSD1306_I2C_UNLOCK(oled);
+    }
+}
+
+// the kernel's random id for this boot. empty if unavailable
+static void ssd1306_i2c_internal_boot_id(char *buf, size_t len)
+{
+    buf[0] = '\0';
+    FILE *fp = fopen("/proc/sys/kernel/random/boot_id", "r");
+    if (fp) {
+        if (!fgets(buf, (int)len, fp))
+            buf[0] = '\0';
+        fclose(fp);
+    }
+}
+
+// FNV-1a hash of the boot id and what identifies the display. a state file
+// written during another boot or for another display is not used
+static uint64_t ssd1306_i2c_internal_warm_token(const ssd1306_i2c_t *oled)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    char boot_id[64];
+    ssd1306_i2c_internal_boot_id(boot_id, sizeof(boot_id));
+    const char *dev = oled->dev ? oled->dev : oled->transport->name;
+    const char *prof = oled->profile->name;
+    const uint8_t geom[3] = { oled->addr, oled->width, oled->height };
+    const uint8_t *parts[4] = { (const uint8_t *)boot_id, (const uint8_t *)dev,
+                                (const uint8_t *)prof, geom };
+    const size_t lens[4] = { strlen(boot_id), strlen(dev) + 1, strlen(prof) + 1, sizeof(geom) };
+    for (size_t p = 0; p < 4; ++p) {
+        for (size_t idx = 0; idx < lens[p]; ++idx) {
+            h ^= parts[p][idx];
+            h *= 0x100000001b3ULL;
+        }
+    }
+    return h;
+}
+
+// warm state file format:
+//   token <16 hex digits>
+//   regs <valid mask> <col> <page> <2 hex digits per cached byte>
+//   frame <number of bytes> followed by the GDDRAM in hex, or frame 0
+// regs 0 and frame 0 mean the panel is configured but its state is unknown
+static int ssd1306_i2c_internal_warm_write(ssd1306_i2c_t *oled, bool clean)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    // a ticker scroll, a flip slot or console start line, or an effect left
+    // running is not undone by the next process if it trusts the registers,
+    // so the state is saved as unknown and that process resets them
+    if (oled->ticker_active || oled->flip_enabled || oled->console_active ||
+        (oled->fx && oled->fx->next_ns != 0))
+        clean = false;
+    const char *path = oled->warm_file;
+    char tmp[256];
+    // written to a temporary file and renamed so readers never see half of it
+    if (snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid()) >= (int)sizeof(tmp)) {
+        SSD1306_LOG_WARN(err, "Warm state path %s is too long", path);
+        return -1;
+    }
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_WARN(err, "Unable to write warm state %s: %s", tmp, oled->err->errbuf);
+        return -1;
+    }
+    const ssd1306_i2c_regcache_t *rc = &(oled->regcache);
+    uint32_t valid = (clean && oled->regcache_enabled) ? rc->valid : 0;
+    fprintf(fp, "token %016llx\n", (unsigned long long)ssd1306_i2c_internal_warm_token(oled));
+    fprintf(fp, "regs %08x %u %u", valid, rc->col, rc->page);
+    for (size_t idx = 0; idx < SSD1306_I2C_REGCACHE_SIZE; ++idx)
+        fprintf(fp, " %02x%02x", rc->val[idx][0], rc->val[idx][1]);
+    fputc('\n', fp);
+    if (clean && oled->shadow_buffer && oled->shadow_valid) {
+        size_t len = oled->gddram_buffer_len - 1;
+        fprintf(fp, "frame %zu", len);
+        for (size_t idx = 0; idx < len; ++idx)
+            fprintf(fp, "%s%02x", (idx % 32) ? "" : "\n", oled->shadow_buffer[idx]);
+        fputc('\n', fp);
+    } else {
+        fprintf(fp, "frame 0\n");
+    }
+    if (fclose(fp) != 0 || rename(tmp, path) < 0) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_WARN(err, "Unable to write warm state %s: %s", path, oled->err->errbuf);
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// loads the state file into rc and frame. returns -1 if it is missing or
+// does not belong to this display and boot, 0 if the panel state is unknown,
+// 1 if the registers are known and 2 if the GDDRAM contents are known too
+static int ssd1306_i2c_internal_warm_read(ssd1306_i2c_t *oled, const char *path,
+        ssd1306_i2c_regcache_t *rc, uint8_t *frame, size_t frame_len)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    int ret = -1;
+    unsigned long long token = 0;
+    unsigned int valid = 0, col = 0, page = 0;
+    size_t len = 0;
+    do {
+        if (fscanf(fp, "token %llx", &token) != 1 ||
+            token != ssd1306_i2c_internal_warm_token(oled))
+            break;
+        if (fscanf(fp, " regs %x %u %u", &valid, &col, &page) != 3)
+            break;
+        memset(rc, 0, sizeof(*rc));
+        bool ok = true;
+        for (size_t idx = 0; idx < SSD1306_I2C_REGCACHE_SIZE && ok; ++idx) {
+            unsigned int v = 0;
+            ok = (fscanf(fp, " %4x", &v) == 1);
+            rc->val[idx][0] = (uint8_t)(v >> 8);
+            rc->val[idx][1] = (uint8_t)v;
+        }
+        if (!ok || fscanf(fp, " frame %zu", &len) != 1)
+            break;
+        rc->valid = valid;
+        rc->col = (uint8_t)col;
+        rc->page = (uint8_t)page;
+        ret = (valid != 0) ? 1 : 0;
+        if (len == 0 || len != frame_len || !frame)
+            break;
+        for (size_t idx = 0; idx < len && ok; ++idx) {
+            unsigned int v = 0;
+            ok = (fscanf(fp, " %2x", &v) == 1);
+            frame[idx] = (uint8_t)v;
+        }
+        if (ok)
+            ret = 2;
+    } while (0);
+    fclose(fp);
+    return ret;
+}
+
+int ssd1306_i2c_warm_attach(ssd1306_i2c_t *oled, const char *state_file)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !state_file) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object or state file");
+        return -1;
+    }
+    char *path = strdup(state_file);
+    if (!path) {
+        SSD1306_LOG_ERROR(err, "Out of memory copying %s", state_file);
+        return -1;
+    }
+    if (oled->warm_file)
+        free(oled->warm_file);
+    oled->warm_file = path;
+    ssd1306_i2c_regcache_t rc;
+    // the saved frame goes into the shadow under the lock, as a flush may be
+    // diffing against it meanwhile
+    const size_t frame_len = oled->gddram_buffer_len - 1;
+    uint8_t *frame = oled->shadow_buffer ? malloc(frame_len) : NULL;
+    int state = ssd1306_i2c_internal_warm_read(oled, path, &rc, frame,
+                    frame ? frame_len : 0);
+    if (state < 0) {
+        free(frame);
+        SSD1306_LOG_INFO(err, "No warm state in %s. Initializing the display", path);
+        if (ssd1306_i2c_display_initialize(oled) < 0)
+            return -1;
+        ssd1306_i2c_internal_warm_write(oled, false);
+        return 0;
+    }
+    int ret = 0;
+    SSD1306_I2C_LOCK(oled);
+    if (state == 0) {
+        // left by a process that did not get to save. the panel is set up,
+        // but scrolling or the start line may have been left changed. this
+        // also checks that the display still answers. an effect or power
+        // off it was in the middle of may have left the panel lit, inverted,
+        // dimmed or dark
+        uint8_t cmds[11];
+        size_t clen = 0;
+        cmds[clen++] = 0x00; // Co: 0 D/C#: 0 0b00000000
+        if (oled->profile->hw_scroll)
+            cmds[clen++] = 0x2E; // deactivate scroll
+        cmds[clen++] = 0x40; // start line 0
+        if (!oled->profile->page_addressing_only) {
+            cmds[clen++] = 0x20; // horizontal addressing mode
+            cmds[clen++] = 0x00;
+        }
+        cmds[clen++] = 0x81; // contrast
+        cmds[clen++] = SSD1306_I2C_INIT_CONTRAST;
+        cmds[clen++] = 0xA4; // entire display on off
+        cmds[clen++] = 0xA6; // normal display
+        cmds[clen++] = 0xAF; // display on
+        oled->regcache.valid = 0;
+        oled->shadow_valid = false;
+        ret = ssd1306_i2c_internal_write_cmds(oled, cmds, clen);
+    } else {
+        uint8_t cmds[2] = { 0x00, 0xE3 }; // Co: 0 D/C#: 0, NOP to check the display answers
+        oled->regcache = rc;
+        if (!oled->regcache_enabled)
+            oled->regcache.valid = 0;
+        if (state == 2 && oled->shadow_buffer) {
+            memcpy(oled->shadow_buffer, frame, frame_len);
+            oled->shadow_valid = true;
+        } else {
+            oled->shadow_valid = false;
+        }
+        ret = ssd1306_i2c_internal_write_cmds(oled, cmds, sizeof(cmds));
+    }
+    if (ret < 0) {
+        oled->regcache.valid = 0;
+        oled->shadow_valid = false;
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    free(frame);
+    if (ret < 0) {
+        SSD1306_LOG_ERROR(err, "Display did not answer on warm start");
+        return -1;
+    }
+    // until the state is saved again it is unknown, in case the process dies
+    ssd1306_i2c_internal_warm_write(oled, false);
+    SSD1306_LOG_INFO(err, "Warm start from %s with %s", path,
+            (state == 2) ? "registers and GDDRAM" : (state == 1) ? "registers" : "nothing");
+    return 1;
+}
+
+int ssd1306_i2c_warm_save(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->warm_file) {
+        SSD1306_LOG_ERROR(err, "Warm start not set up. Call ssd1306_i2c_warm_attach() first");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    int rc = ssd1306_i2c_internal_warm_write(oled, true);
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_regcache_enable(ssd1306_i2c_t *oled, bool enable)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    // commands sent while disabled are not tracked
+    oled->regcache.valid = 0;
+    oled->regcache_enabled = enable;
+    SSD1306_I2C_UNLOCK(oled);
+    return 0;
+}
+
+void ssd1306_i2c_regcache_invalidate(ssd1306_i2c_t *oled)
+{
+    if (oled) {
+        SSD1306_I2C_LOCK(oled);
+        oled->regcache.valid = 0;
+        SSD1306_I2C_UNLOCK(oled);
+    }
+}
+
+int ssd1306_i2c_capture_start(ssd1306_i2c_t *oled, const char *path)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !path) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object or capture file");
+        return -1;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    // the flush thread would write the file
+    if (oled->async && oled->async->realtime) {
+        SSD1306_LOG_ERROR(err, "Cannot capture while a realtime flush thread runs");
+        return -1;
+    }
+#endif
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_ERROR(err, "Unable to create capture %s: %s", path, oled->err->errbuf);
+        return -1;
+    }
+    uint8_t hdr[SSD1306_I2C_CAPTURE_HDR_LEN] = { 0 };
+    memcpy(hdr, SSD1306_I2C_CAPTURE_MAGIC, 8);
+    hdr[8] = SSD1306_I2C_CAPTURE_VERSION;
+    hdr[9] = oled->addr;
+    hdr[10] = oled->width;
+    hdr[11] = oled->height;
+    if (fwrite(hdr, 1, sizeof(hdr), fp) != sizeof(hdr)) {
+        SSD1306_LOG_ERROR(err, "Unable to write capture %s", path);
+        fclose(fp);
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    if (oled->capture)
+        fclose(oled->capture);
+    oled->capture = fp;
+    oled->capture_ns = ssd1306_i2c_internal_now_ns();
+    SSD1306_I2C_UNLOCK(oled);
+    SSD1306_LOG_INFO(err, "Capturing the byte stream to %s", path);
+    return 0;
+}
+
+int ssd1306_i2c_capture_stop(ssd1306_i2c_t *oled)
+{
+    if (!oled)
+        return -1;
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    if (oled->capture) {
+        rc = (fclose(oled->capture) == 0) ? 0 : -1;
+        oled->capture = NULL;
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    if (rc < 0)
+        SSD1306_LOG_ERROR(oled->err, "Failed to finish the capture");
+    return rc;
+}
+
+// transactions replayed in one submission at most
+#define SSD1306_I2C_REPLAY_SEGS_MAX 64
+
+int ssd1306_i2c_replay(ssd1306_i2c_t *oled, const char *path, bool realtime,
+        ssd1306_i2c_replay_stats_t *stats)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !path) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object or capture file");
+        return -1;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_ERROR(err, "Unable to open capture %s: %s", path, oled->err->errbuf);
+        return -1;
+    }
+    // the whole capture is read in so the transactions can be sent from it
+    uint8_t *buf = NULL;
+    long flen = -1;
+    if (fseek(fp, 0, SEEK_END) == 0 && (flen = ftell(fp)) >= SSD1306_I2C_CAPTURE_HDR_LEN &&
+        fseek(fp, 0, SEEK_SET) == 0 && (buf = malloc((size_t)flen)) != NULL &&
+        fread(buf, 1, (size_t)flen, fp) != (size_t)flen) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(fp);
+    if (!buf || memcmp(buf, SSD1306_I2C_CAPTURE_MAGIC, 8) != 0 ||
+        buf[8] != SSD1306_I2C_CAPTURE_VERSION) {
+        SSD1306_LOG_ERROR(err, "%s is not a readable capture", path);
+        free(buf);
+        return -1;
+    }
+    if (buf[10] != oled->width || buf[11] != oled->height) {
+        SSD1306_LOG_WARN(err, "Capture %s is for a %ux%u display", path, buf[10], buf[11]);
+    }
+    ssd1306_i2c_replay_stats_t st = { 0 };
+    ssd1306_i2c_seg_t segs[SSD1306_I2C_REPLAY_SEGS_MAX];
+    const size_t len = (size_t)flen;
+    size_t pos = SSD1306_I2C_CAPTURE_HDR_LEN;
+    uint64_t t0 = ssd1306_i2c_internal_now_ns();
+    uint64_t when = t0;
+    int rc = 0;
+    while (pos < len && rc == 0) {
+        size_t nsegs = 0;
+        bool more = true;
+        while (more && nsegs < SSD1306_I2C_REPLAY_SEGS_MAX &&
+                pos + SSD1306_I2C_CAPTURE_REC_LEN <= len) {
+            const uint8_t *rec = &buf[pos];
+            size_t slen = (size_t)ssd1306_i2c_internal_get_le(&rec[6], 2);
+            if (slen == 0 || pos + SSD1306_I2C_CAPTURE_REC_LEN + slen > len)
+                break;
+            uint64_t usecs = ssd1306_i2c_internal_get_le(rec, 4);
+            when += usecs * 1000;
+            st.capture_ns += usecs * 1000;
+            segs[nsegs].buf = &rec[SSD1306_I2C_CAPTURE_REC_LEN];
+            segs[nsegs++].len = slen;
+            more = (rec[5] & SSD1306_I2C_CAPTURE_MORE) ? true : false;
+            pos += SSD1306_I2C_CAPTURE_REC_LEN + slen;
+        }
+        if (nsegs == 0) {
+            SSD1306_LOG_ERROR(err, "Capture %s is truncated at offset %zu", path, pos);
+            rc = -1;
+            break;
+        }
+        if (realtime) {
+            struct timespec ts = { (time_t)(when / 1000000000ULL), (long)(when % 1000000000ULL) };
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+        }
+        SSD1306_I2C_LOCK(oled);
+        // sent as recorded, past the register cache
+        rc = ssd1306_i2c_internal_xfer_raw(oled, segs, nsegs);
+        oled->regcache.valid = 0;
+        oled->shadow_valid = false;
+        SSD1306_I2C_UNLOCK(oled);
+        st.submissions++;
+        for (size_t idx = 0; idx < nsegs && rc == 0; ++idx) {
+            st.transactions++;
+            st.bytes += segs[idx].len;
+            if (SSD1306_I2C_SEG_IS_DATA(&segs[idx]))
+                st.data_xfers++;
+            else
+                st.cmd_xfers++;
+        }
+    }
+    st.elapsed_ns = ssd1306_i2c_internal_now_ns() - t0;
+    free(buf);
+    if (stats)
+        *stats = st;
+    return rc;
+}
+
+int ssd1306_i2c_display_clear(ssd1306_i2c_t *oled)
+{
+    if (oled != NULL && oled->gddram_buffer != NULL && oled->gddram_buffer_len > 0) {
+        SSD1306_I2C_LOCK(oled);
+        memset(oled->gddram_buffer, 0, sizeof(uint8_t) * oled->gddram_buffer_len);
+        int rc = ssd1306_i2c_display_update(oled, NULL);
+        SSD1306_I2C_UNLOCK(oled);
+        return rc;
+    } else {
+        ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+        SSD1306_LOG_ERROR(err, "Invalid OLED object. Failed to clear display");
+        return -1;
+    }
+}
+
+// stops scrolling and writes the running ticker's content back to its band
+// unscrolled, so a new band elsewhere does not leave it rotated
+static int ssd1306_i2c_internal_ticker_restore(ssd1306_i2c_t *oled)
+{
+    const ssd1306_i2c_ticker_t *tk = &(oled->ticker);
+    const size_t band_len = (tk->page_end - tk->page_start + 1) * oled->width;
+    uint8_t pre[3 * SSD1306_I2C_CMD_BYTES_MAX + 1];
+    size_t prelen = ssd1306_i2c_internal_ticker_pre(oled, tk->page_start, tk->page_end,
+                            pre, sizeof(pre));
+    uint8_t *band = calloc(sizeof(uint8_t), band_len + 1);
+    if (prelen == 0 || !band) {
+        SSD1306_LOG_ERROR(oled->err, "Unable to restore the ticker band");
+        free(band);
+        return -1;
+    }
+    band[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+    memcpy(&band[1], oled->ticker_band, band_len);
+    ssd1306_i2c_seg_t segs[2] = {
+        { pre, prelen },
+        { band, band_len + 1 }
+    };
+    int rc = ssd1306_i2c_internal_xfer(oled, segs, 2);
+    free(band);
+    if (rc == 0)
+        oled->ticker_active = false;
+    oled->shadow_valid = false;
+    return rc;
+}
+
+// uploads the band pages of fbp for oled->ticker and starts scrolling them
+static int ssd1306_i2c_internal_ticker_upload(ssd1306_i2c_t *oled,
+        const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!fbp || !(fbp->buffer) || fbp->len != (oled->gddram_buffer_len - 1)) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 framebuffer object");
+        return -1;
+    }
+    const ssd1306_i2c_ticker_t *tk = &(oled->ticker);
+    const size_t width = oled->width;
+    const size_t band_len = (tk->page_end - tk->page_start + 1) * width;
+    // room for the control byte in front of the band
+    uint8_t *band = calloc(sizeof(uint8_t), band_len + 1);
+    if (!band) {
+        oled->err->errnum = errno;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for ticker band",
+                band_len + 1);
+        return -1;
+    }
+    band[0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+    memcpy(&band[1], &(fbp->buffer[tk->page_start * width]), band_len);
+    SSD1306_I2C_LOCK(oled);
+    int rc = ssd1306_i2c_internal_ticker_xfer(oled, tk->page_start, tk->page_end,
+                    band, band_len + 1);
+    if (rc == 0) {
+        memmove(band, &band[1], band_len);
+        if (oled->ticker_band)
+            free(oled->ticker_band);
+        oled->ticker_band = band;
+        band = NULL;
+        oled->ticker_active = true;
+        SSD1306_LOG_INFO(err, "Ticker scrolling pages %u-%u", tk->page_start, tk->page_end);
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    if (band)
+        free(band);
+    return rc;
+}
+
+int ssd1306_i2c_ticker_start(ssd1306_i2c_t *oled, const ssd1306_i2c_ticker_t *ticker,
+        const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    if (!oled->profile->hw_scroll || oled->profile->page_addressing_only) {
+        SSD1306_LOG_ERROR(err, "The %s controller cannot scroll a ticker", oled->profile->name);
+        return -1;
+    }
+    if (!ticker || ticker->page_end < ticker->page_start ||
+        ticker->page_end >= oled->height / 8 || ticker->interval > 7) {
+        SSD1306_LOG_ERROR(err, "Invalid ticker configuration");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    // the scroll would move the rows of whichever slot or console line is shown
+    if (oled->flip_enabled || oled->console_active) {
+        SSD1306_LOG_ERROR(err, "Cannot scroll a ticker while %s",
+                oled->flip_enabled ? "flipping pages" : "a console is open");
+        SSD1306_I2C_UNLOCK(oled);
+        return -1;
+    }
+    ssd1306_i2c_ticker_t saved = oled->ticker;
+    bool active = oled->ticker_active;
+    if (active) {
+        if (ssd1306_i2c_internal_ticker_restore(oled) < 0) {
+            SSD1306_I2C_UNLOCK(oled);
+            return -1;
+        }
+        active = false; // the old band no longer scrolls
+    }
+    oled->ticker = *ticker;
+    int rc = ssd1306_i2c_internal_ticker_upload(oled, fbp);
+    if (rc < 0) {
+        oled->ticker = saved;
+        oled->ticker_active = active;
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_ticker_set_content(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    int rc = -1;
+    // the band is only known once a ticker is started
+    if (!oled->ticker_active)
+        SSD1306_LOG_ERROR(err, "Ticker not started");
+    else
+        rc = ssd1306_i2c_internal_ticker_upload(oled, fbp);
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_ticker_set_text(ssd1306_i2c_t *oled, const char *text)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !oled->gddram_buffer || oled->gddram_buffer_len == 0 ||
+        !text) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object or no text given");
+        return -1;
+    }
+    ssd1306_framebuffer_t *fbp = ssd1306_framebuffer_create(oled->width, oled->height, oled->err);
+    if (!fbp)
+        return -1;
+    int rc = -1;
+    // held from the render to the send, so the band cannot change in between
+    SSD1306_I2C_LOCK(oled);
+    if (!oled->ticker_active) {
+        SSD1306_LOG_ERROR(err, "Ticker not started");
+    } else {
+        const ssd1306_i2c_ticker_t *tk = &(oled->ticker);
+        // the baseline leaves about a fifth of the band for descenders
+        uint8_t rows = (uint8_t)((tk->page_end - tk->page_start + 1) * 8);
+        uint8_t baseline = (uint8_t)(tk->page_start * 8 + (rows * 4) / 5);
+        if (ssd1306_framebuffer_draw_text(fbp, text, 0, 0, baseline, tk->font,
+                    tk->font_size, NULL) >= 0)
+            rc = ssd1306_i2c_internal_ticker_upload(oled, fbp);
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    ssd1306_framebuffer_destroy(fbp);
+    return rc;
+}
+
+int ssd1306_i2c_ticker_stop(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    int rc = 0;
+    if (oled->ticker_active) {
+        uint8_t cmds[SSD1306_I2C_CMD_BYTES_MAX + 1];
+        cmds[0] = 0x00; // Co: 0 D/C#: 0 0b00000000
+        size_t sz = ssd1306_i2c_internal_append_cmd(err, SSD1306_I2C_CMD_SCROLL_DEACTIVATE,
+                        NULL, 0, &cmds[1], sizeof(cmds) - 1);
+        rc = (sz > 0) ? ssd1306_i2c_internal_write_cmds(oled, cmds, sz + 1) : -1;
+        if (rc == 0)
+            oled->ticker_active = false;
+        oled->shadow_valid = false;
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+const ssd1306_i2c_profile_t ssd1306_i2c_profile_ssd1306 = {
+    .name = "SSD1306",
+    .ram_columns = 128,
+    .column_offset = 0,
+    .page_addressing_only = false,
+    .hw_scroll = true,
+    .clock_divfreq = 0x80,
+    .precharge = 0xF1,
+    .vcomh = 0x30,
+    .charge_pump = true,
+    .dcdc = 0
+};
+
+// the SSD1309 runs off an external VCC and has no charge pump
+const ssd1306_i2c_profile_t ssd1306_i2c_profile_ssd1309 = {
+    .name = "SSD1309",
+    .ram_columns = 128,
+    .column_offset = 0,
+    .page_addressing_only = false,
+    .hw_scroll = true,
+    .clock_divfreq = 0xA0,
+    .precharge = 0x22,
+    .vcomh = 0x34,
+    .charge_pump = false,
+    .dcdc = 0
+};
+
+// the SH1106 has 132 columns of RAM with the 128 column panel usually wired
+// from column 2, and page addressing only
+const ssd1306_i2c_profile_t ssd1306_i2c_profile_sh1106 = {
+    .name = "SH1106",
+    .ram_columns = 132,
+    .column_offset = 2,
+    .page_addressing_only = true,
+    .hw_scroll = false,
+    .clock_divfreq = 0x80,
+    .precharge = 0x22,
+    .vcomh = 0x35,
+    .charge_pump = false,
+    .dcdc = 0x8B
+};
+
+int ssd1306_i2c_set_profile(ssd1306_i2c_t *oled, const ssd1306_i2c_profile_t *profile)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    if (!profile || !profile->name || oled->width + profile->column_offset > profile->ram_columns) {
+        SSD1306_LOG_ERROR(err, "Controller profile does not fit a %u column display",
+                oled->width);
+        return -1;
+    }
+    if (oled->ticker_active) {
+        SSD1306_LOG_ERROR(err, "Stop the ticker before changing the controller profile");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    int rc = 0;
+    // page addressing controllers stage every update in xfer_buffer
+    if (profile->page_addressing_only && !oled->xfer_buffer) {
+        oled->xfer_buffer = calloc(sizeof(uint8_t), oled->gddram_buffer_len + 8);
+        if (!oled->xfer_buffer) {
+            oled->err->errnum = errno;
+            strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+            SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for page buffers",
+                    oled->gddram_buffer_len + 8);
+            rc = -1;
+        }
+        ssd1306_i2c_internal_rt_lock(oled, oled->xfer_buffer, oled->gddram_buffer_len + 8, true);
+    }
+    if (rc == 0) {
+        oled->profile = profile;
+        oled->shadow_valid = false;
+        oled->regcache.valid = 0;
+        SSD1306_LOG_INFO(err, "Using the %s controller profile", profile->name);
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+const char *ssd1306_i2c_version(void)
+{
+    return LIBSSD1306_PACKAGE_VERSION;
+}
+
+#ifdef SSD1306_I2C_HAVE_SMBUS_PROBE
+// same probe as i2cdetect: a byte read for EEPROM-like address ranges where a
+// quick write could corrupt data and a quick write everywhere else
+static int ssd1306_i2c_internal_probe(int fd, uint32_t adx, unsigned long ifunc)
+{
+    bool do_read = (adx >= 0x30 && adx <= 0x37) || (adx >= 0x50 && adx <= 0x5F);
+    if (!(ifunc & I2C_FUNC_SMBUS_QUICK))
+        do_read = true;
+    if (do_read && !(ifunc & I2C_FUNC_SMBUS_READ_BYTE))
+        return -1;
+#if LIBSSD1306_HAVE_I2C_SMBUS_H
+    return do_read ? i2c_smbus_read_byte(fd) : i2c_smbus_write_quick(fd, I2C_SMBUS_WRITE);
+#else
+    union i2c_smbus_data data;
+    struct i2c_smbus_ioctl_data args = {
+        .read_write = do_read ? I2C_SMBUS_READ : I2C_SMBUS_WRITE,
+        .command = 0,
+        .size = do_read ? I2C_SMBUS_BYTE : I2C_SMBUS_QUICK,
+        .data = do_read ? &data : NULL
+    };
+    return ioctl(fd, I2C_SMBUS, &args);
+#endif
+}
+
+// opens the bus in entry->dev and fills in the addresses that respond.
+// returns 0 if the bus could be opened and -1 otherwise
+static int ssd1306_i2c_internal_probe_bus(ssd1306_i2c_dev_t *entry,
+        bool ssd1306_only, const ssd1306_err_t *err)
+{
+    int fd = open(entry->dev, O_RDWR);
+    if (fd < 0) {
+        int errnum = errno;
+        if (errnum != ENODEV && errnum != ENOENT) {
+            char errbuf[128] = { 0 };
+            strerror_r(errnum, errbuf, sizeof(errbuf));
+            SSD1306_LOG_WARN(err, "Device %s has unexpected error: %s (%d)", entry->dev,
+                    errbuf, errnum);
+        }
+        return -1;
+    }
+    SSD1306_LOG_INFO(err, "Opened %s at fd %d. Device exists!", entry->dev, fd);
+    entry->num_addrs = 0;
+    unsigned long ifunc = 0;
+    if (ioctl(fd, I2C_FUNCS, &ifunc) < 0) {
+        SSD1306_LOG_WARN(err, "I2C Function mask not set. Return value: %ld", ifunc);
+    } else if (ifunc & (I2C_FUNC_SMBUS_QUICK | I2C_FUNC_SMBUS_READ_BYTE)) {
+        SSD1306_LOG_INFO(err, "I2C Function mask set. Return value: %ld", ifunc);
+        const uint32_t first = ssd1306_only ? 0x3c : 0x00;
+        const uint32_t last = ssd1306_only ? 0x3d : 0x7f;
+        for (uint32_t adx = first; adx <= last; adx++) {
+            if (ioctl(fd, I2C_SLAVE, adx) < 0) {
+                if (errno == EBUSY) {
+                    SSD1306_LOG_INFO(err, "Found address 0x%02x at fd %d but it is in use.",
+                            adx, fd);
+                }
+                continue;
+            }
+            if (ssd1306_i2c_internal_probe(fd, adx, ifunc) >= 0) {
+                entry->addrs[entry->num_addrs++] = (uint8_t)adx;
+                SSD1306_LOG_INFO(err, "Found address 0x%02x at fd %d.", adx, fd);
+            }
+        }
+    }
+    close(fd);
+    SSD1306_LOG_INFO(err, "Closed device %s", entry->dev);
+    return 0;
+}
+
+static int ssd1306_i2c_internal_cmp_int(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+// fills devarr with the device names of the I2C adapters the kernel knows
+// about. falls back to trying every bus number if sysfs is not available.
+static size_t ssd1306_i2c_internal_list_buses(ssd1306_i2c_dev_t **devarr,
+        const ssd1306_err_t *err)
+{
+    int nums[SSD1306_I2C_SEARCH_MAX_BUSES];
+    size_t nbuses = 0;
+#ifdef LIBSSD1306_HAVE_DIRENT_H
+    DIR *dir = opendir("/sys/bus/i2c/devices");
+    if (dir) {
+        struct dirent *de;
+        while ((de = readdir(dir)) != NULL && nbuses < SSD1306_I2C_SEARCH_MAX_BUSES) {
+            int num = -1;
+            char extra = 0;
+            // adapters are i2c-N, clients are N-00AA
+            if (sscanf(de->d_name, "i2c-%d%c", &num, &extra) == 1 && num >= 0) {
+                nums[nbuses++] = num;
+            }
+        }
+        closedir(dir);
+        qsort(nums, nbuses, sizeof(int), ssd1306_i2c_internal_cmp_int);
+    }
+#endif
+    if (nbuses == 0) {
+        SSD1306_LOG_INFO(err, "No I2C adapters listed in sysfs. Trying bus 0 to %d",
+                SSD1306_I2C_SEARCH_MAX_BUSES - 1);
+        for (int idx = 0; idx < SSD1306_I2C_SEARCH_MAX_BUSES; ++idx)
+            nums[nbuses++] = idx;
+    }
+    *devarr = calloc(nbuses, sizeof(ssd1306_i2c_dev_t));
+    if (!*devarr) {
+        SSD1306_LOG_ERROR(err, "Failed to allocate memory of size %zu bytes",
+                sizeof(ssd1306_i2c_dev_t) * nbuses);
+        return 0;
+    }
+    for (size_t idx = 0; idx < nbuses; ++idx) {
+        ssd1306_i2c_dev_t *entry = &((*devarr)[idx]);
+        snprintf(entry->dev, sizeof(entry->dev), "/dev/i2c-%d", nums[idx]);
+        if (access(entry->dev, F_OK) < 0) {
+            // try another format
+            snprintf(entry->dev, sizeof(entry->dev), "/dev/i2c/%d", nums[idx]);
+        }
+    }
+    return nbuses;
+}
+
+// FNV-1a hash of the boot id, the options and the candidate buses. the cache
+// is only used if the token is unchanged, so a reboot or an adapter being
+// added or removed forces a rescan.
+static uint64_t ssd1306_i2c_internal_search_token(const ssd1306_i2c_dev_t *devarr,
+        size_t nbuses, bool ssd1306_only)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+#define SSD1306_I2C_FNV(P,L) do { \
+    for (size_t _i = 0; _i < (L); ++_i) { \
+        h ^= ((const uint8_t *)(P))[_i]; \
+        h *= 0x100000001b3ULL; \
+    } \
+} while (0)
+    char boot_id[64];
+    ssd1306_i2c_internal_boot_id(boot_id, sizeof(boot_id));
+    SSD1306_I2C_FNV(boot_id, strlen(boot_id));
+    SSD1306_I2C_FNV(&ssd1306_only, sizeof(ssd1306_only));
+    for (size_t idx = 0; idx < nbuses; ++idx)
+        SSD1306_I2C_FNV(devarr[idx].dev, strlen(devarr[idx].dev) + 1);
+#undef SSD1306_I2C_FNV
+    return h;
+}
+
+// cache file format:
+//   token <16 hex digits>
+//   <device> <number of addresses> <address in hex>...
+static int ssd1306_i2c_internal_cache_load(const char *path, uint64_t token,
+        size_t maxdevs, ssd1306_i2c_dev_t **devs, size_t *num_devs)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+        return -1;
+    ssd1306_i2c_dev_t *devarr = calloc(maxdevs ? maxdevs : 1, sizeof(ssd1306_i2c_dev_t));
+    if (!devarr) {
+        fclose(fp);
+        return -1;
+    }
+    int rc = 0;
+    unsigned long long saved = 0;
+    size_t ndevs = 0;
+    if (fscanf(fp, "token %llx", &saved) != 1 || saved != token) {
+        rc = -1;
+    }
+    while (rc == 0) {
+        ssd1306_i2c_dev_t entry;
+        memset(&entry, 0, sizeof(entry));
+        int n = fscanf(fp, " %127s %zu", entry.dev, &entry.num_addrs);
+        if (n == EOF)
+            break;
+        if (n != 2 || ndevs >= maxdevs || entry.num_addrs > sizeof(entry.addrs)) {
+            rc = -1;
+            break;
+        }
+        for (size_t adx = 0; adx < entry.num_addrs && rc == 0; ++adx) {
+            unsigned int a = 0;
+            if (fscanf(fp, " %x", &a) != 1 || a >= 0x80)
+                rc = -1;
+            entry.addrs[adx] = (uint8_t)a;
+        }
+        devarr[ndevs++] = entry;
+    }
+    fclose(fp);
+    if (rc == 0) {
+        *devs = devarr;
+        *num_devs = ndevs;
+    } else {
+        free(devarr);
+    }
+    return rc;
+}
+
+static void ssd1306_i2c_internal_cache_save(const char *path, uint64_t token,
+        const ssd1306_i2c_dev_t *devarr, size_t num_devs, const ssd1306_err_t *err)
+{
+    char tmp[256];
+    char errbuf[128] = { 0 };
+    // written to a temporary file and renamed so readers never see half of it
+    if (snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid()) >= (int)sizeof(tmp)) {
+        SSD1306_LOG_WARN(err, "Bus cache path %s is too long", path);
+        return;
+    }
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        strerror_r(errno, errbuf, sizeof(errbuf));
+        SSD1306_LOG_WARN(err, "Unable to write bus cache %s: %s", tmp, errbuf);
+        return;
+    }
+    fprintf(fp, "token %016llx\n", (unsigned long long)token);
+    for (size_t idx = 0; idx < num_devs; ++idx) {
+        fprintf(fp, "%s %zu", devarr[idx].dev, devarr[idx].num_addrs);
+        for (size_t adx = 0; adx < devarr[idx].num_addrs; ++adx)
+            fprintf(fp, " %02x", devarr[idx].addrs[adx]);
+        fputc('\n', fp);
+    }
+    if (fclose(fp) != 0 || rename(tmp, path) < 0) {
+        strerror_r(errno, errbuf, sizeof(errbuf));
+        SSD1306_LOG_WARN(err, "Unable to write bus cache %s: %s", path, errbuf);
+        unlink(tmp);
+    }
+}
+
+typedef struct {
+    ssd1306_i2c_dev_t *devarr;
+    int8_t *opened; // 1 if the bus exists
+    size_t nbuses;
+    volatile size_t next; // next bus to probe. shared
+    bool ssd1306_only;
+    const ssd1306_err_t *err;
+} ssd1306_i2c_search_t;
+
+static void *ssd1306_i2c_internal_search_worker(void *arg)
+{
+    ssd1306_i2c_search_t *srch = arg;
+    for (;;) {
+        size_t idx = SSD1306_ATOMIC_INCREMENT(&(srch->next)) - 1;
+        if (idx >= srch->nbuses)
+            break;
+        srch->opened[idx] = (ssd1306_i2c_internal_probe_bus(&(srch->devarr[idx]),
+                    srch->ssd1306_only, srch->err) == 0) ? 1 : 0;
+    }
+    return NULL;
+}
+#endif
+
+int ssd1306_i2c_search_addresses(ssd1306_i2c_dev_t **devs, size_t *num_devs, FILE *logerr)
+{
+    return ssd1306_i2c_search_addresses_ex(devs, num_devs, NULL, logerr);
+}
+
+int ssd1306_i2c_search_addresses_ex(ssd1306_i2c_dev_t **devs, size_t *num_devs,
+        const ssd1306_i2c_search_opts_t *opts, FILE *logerr)
+{
+#ifdef SSD1306_I2C_HAVE_SMBUS_PROBE
+    if (!devs || !num_devs)
+        return -1;
+    // not ssd1306_err_create(), which would close logerr when destroyed
+    ssd1306_err_t errlog = { 0 };
+    errlog.err_fp = logerr == NULL ? stderr : logerr;
+    errlog.level = SSD1306_LOGLEVEL_INFO;
+    const ssd1306_err_t *err = &errlog;
+    const bool ssd1306_only = opts ? opts->ssd1306_only : false;
+    size_t nthreads = (opts && opts->threads > 0) ? opts->threads :
+                            SSD1306_I2C_SEARCH_THREADS_DEFAULT;
+    ssd1306_i2c_dev_t *devarr = NULL;
+    size_t nbuses = ssd1306_i2c_internal_list_buses(&devarr, err);
+    if (!devarr)
+        return -1;
+    uint64_t token = ssd1306_i2c_internal_search_token(devarr, nbuses, ssd1306_only);
+    if (opts && opts->cache_file &&
+        ssd1306_i2c_internal_cache_load(opts->cache_file, token, nbuses,
+                devs, num_devs) == 0) {
+        SSD1306_LOG_INFO(err, "Using %zu I2C devices from cache %s", *num_devs,
+                opts->cache_file);
+        free(devarr);
+        return 0;
+    }
+    ssd1306_i2c_search_t srch = {
+        .devarr = devarr,
+        .opened = calloc(nbuses, sizeof(int8_t)),
+        .nbuses = nbuses,
+        .next = 0,
+        .ssd1306_only = ssd1306_only,
+        .err = err
+    };
+    if (!srch.opened) {
+        SSD1306_LOG_ERROR(err, "Failed to allocate memory of size %zu bytes", nbuses);
+        free(devarr);
+        return -1;
+    }
+    if (nthreads > nbuses)
+        nthreads = nbuses;
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    // buses are independent, so slow or absent devices on one do not hold up
+    // the others. the calling thread is one of the workers
+    pthread_t threads[SSD1306_I2C_SEARCH_THREADS_MAX];
+    size_t nstarted = 0;
+    if (nthreads > SSD1306_I2C_SEARCH_THREADS_MAX)
+        nthreads = SSD1306_I2C_SEARCH_THREADS_MAX;
+    for (size_t idx = 1; idx < nthreads; ++idx) {
+        if (pthread_create(&threads[nstarted], NULL,
+                    ssd1306_i2c_internal_search_worker, &srch) != 0)
+            break;
+        nstarted++;
+    }
+    ssd1306_i2c_internal_search_worker(&srch);
+    for (size_t idx = 0; idx < nstarted; ++idx)
+        pthread_join(threads[idx], NULL);
+#else
+    ssd1306_i2c_internal_search_worker(&srch);
+#endif
+    // keep only the buses that exist, in bus order
+    size_t devarridx = 0;
+    for (size_t idx = 0; idx < nbuses; ++idx) {
+        if (srch.opened[idx]) {
+            if (devarridx != idx)
+                devarr[devarridx] = devarr[idx];
+            devarridx++;
+        }
+    }
+    free(srch.opened);
+    if (opts && opts->cache_file)
+        ssd1306_i2c_internal_cache_save(opts->cache_file, token, devarr, devarridx, err);
+    *devs = devarr;
+    *num_devs = devarridx;
+    return 0;
+#else
+    (void)devs;
+    (void)num_devs;
+    (void)opts;
+    (void)logerr;
+    return -1;
+#endif
+}
+
+#ifdef LIBSSD1306_HAVE_PTHREAD
+static void ssd1306_i2c_internal_sleep_until(uint64_t when_ns)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(when_ns / 1000000000ULL),
+        .tv_nsec = (long)(when_ns % 1000000000ULL)
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+}
+
+// hands a handled frame to the pacing callback and the completion queue
+static void ssd1306_i2c_async_complete(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_present_info_t *info, const ssd1306_i2c_pacing_t *pacing)
+{
+    ssd1306_i2c_async_t *as = oled->async;
+    if (pacing && pacing->cb)
+        pacing->cb(oled, info, pacing->cbdata);
+    pthread_mutex_lock(&(as->done_lock));
+    if (as->efd >= 0) {
+        size_t idx = (as->done_first + as->done_count) % SSD1306_I2C_ASYNC_COMPLETIONS;
+        if (as->done_count == SSD1306_I2C_ASYNC_COMPLETIONS) {
+            // full, overwrite the oldest
+            as->done_first = (as->done_first + 1) % SSD1306_I2C_ASYNC_COMPLETIONS;
+            SSD1306_ATOMIC_INCREMENT(&(as->stats.lost));
+        } else {
+            as->done_count++;
+        }
+        as->done[idx] = *info;
+        uint64_t one = 1;
+        if (write(as->efd, &one, sizeof(one)) < 0) {
+            // the counter cannot overflow as it is reset by every drain
+        }
+    }
+    pthread_mutex_unlock(&(as->done_lock));
+}
+
+// sends the queued urgent regions, highest priority first. the regions are
+// also copied into src, the frame being sent, so that its remaining pages do
+// not undo them. returns the number of regions that failed
+static size_t ssd1306_i2c_async_serve_urgent(ssd1306_i2c_t *oled, uint8_t *src)
+{
+    ssd1306_i2c_async_t *as = oled->async;
+    const size_t width = oled->width;
+    size_t nfailed = 0;
+    while (SSD1306_ATOMIC_LOAD(&(as->nurgent)) > 0) {
+        pthread_mutex_lock(&(as->urgent_lock));
+        ssd1306_i2c_urgent_t *best = NULL;
+        for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX; ++idx) {
+            ssd1306_i2c_urgent_t *u = &(as->urgent[idx]);
+            if (u->used && (!best || u->priority > best->priority ||
+                        (u->priority == best->priority && u->order < best->order)))
+                best = u;
+        }
+        if (!best) {
+            pthread_mutex_unlock(&(as->urgent_lock));
+            break;
+        }
+        // take the region's bytes and leave the spare buffer in their place
+        uint8_t *frame = best->frame;
+        best->frame = as->urgent_buf;
+        as->urgent_buf = frame;
+        ssd1306_i2c_rect_t r = best->rect;
+        best->used = false;
+        SSD1306_ATOMIC_DECREMENT(&(as->nurgent));
+        pthread_mutex_unlock(&(as->urgent_lock));
+        pthread_mutex_lock(as->lock);
+        // the pages of a running ticker's band are left out
+        const bool ticker = oled->ticker_active;
+        ssd1306_i2c_rect_t rects[SSD1306_I2C_RAM_PAGES];
+        size_t nrects = 0;
+        for (size_t pg = r.page_start; pg <= r.page_end; ++pg) {
+            if (ticker && pg >= oled->ticker.page_start && pg <= oled->ticker.page_end)
+                continue;
+            if (nrects > 0 && !oled->profile->page_addressing_only &&
+                (size_t)rects[nrects - 1].page_end + 1 == pg) {
+                rects[nrects - 1].page_end = (uint8_t)pg;
+            } else {
+                ssd1306_i2c_rect_t pr = { pg, pg, r.col_start, r.col_end };
+                rects[nrects++] = pr;
+            }
+        }
+        int rc = 0;
+        if (!oled->xfer_buffer)
+            rc = -1;
+        else if (nrects > 0 && ticker)
+            rc = ssd1306_i2c_internal_ticker_rects(oled, frame, rects, nrects);
+        else if (nrects > 0)
+            rc = ssd1306_i2c_internal_send_rects(oled, frame, rects, nrects);
+        pthread_mutex_unlock(as->lock);
+        if (rc < 0) {
+            SSD1306_ATOMIC_INCREMENT(&(as->stats.errors));
+            nfailed++;
+        } else if (nrects > 0) {
+            SSD1306_ATOMIC_INCREMENT(&(as->stats.urgent));
+        }
+        for (size_t idx = 0; src && idx < nrects; ++idx) {
+            for (size_t pg = rects[idx].page_start; pg <= rects[idx].page_end; ++pg) {
+                size_t off = pg * width + r.col_start;
+                memcpy(&src[off], &frame[off], r.col_end - r.col_start + 1);
+            }
+        }
+    }
+    return nfailed;
+}
+
+// sends the frame one page at a time, each page with its own address window,
+// and lets urgent regions in between two pages. the frame then carries on
+// with its next page. with a valid shadow only the changed part of each page
+// is sent
+static int ssd1306_i2c_async_send_pages(ssd1306_i2c_t *oled, uint8_t *src)
+{
+    ssd1306_i2c_async_t *as = oled->async;
+    const size_t width = oled->width;
+    const size_t pages = oled->height / 8;
+    size_t nfailed = 0;
+    for (size_t pg = 0; pg < pages; ++pg) {
+        nfailed += ssd1306_i2c_async_serve_urgent(oled, src);
+        pthread_mutex_lock(as->lock);
+        if (!oled->xfer_buffer || oled->ticker_active || oled->flip_enabled) {
+            // nothing to stage pages in, or the page goes elsewhere in RAM
+            int rc = ssd1306_i2c_internal_display_update(oled, src, NULL);
+            pthread_mutex_unlock(as->lock);
+            return rc;
+        }
+        ssd1306_i2c_rect_t r = { pg, pg, 0, width - 1 };
+        if (oled->shadow_buffer && oled->shadow_valid) {
+            size_t lo = 0, hi = 0;
+            if (!ssd1306_i2c_internal_diff_span(&src[pg * width],
+                        &(oled->shadow_buffer[pg * width]), width, &lo, &hi)) {
+                pthread_mutex_unlock(as->lock);
+                continue;
+            }
+            r.col_start = lo;
+            r.col_end = hi;
+        }
+        int rc = ssd1306_i2c_internal_send_rects(oled, src, &r, 1);
+        pthread_mutex_unlock(as->lock);
+        if (rc < 0)
+            return -1;
+    }
+    pthread_mutex_lock(as->lock);
+    // every page now matches src unless an urgent region failed
+    if (oled->shadow_buffer)
+        oled->shadow_valid = (nfailed == 0);
+    pthread_mutex_unlock(as->lock);
+    return 0;
+}
+
+// waits for a wakeup until the CLOCK_MONOTONIC time when_ns
+static void ssd1306_i2c_async_timedwait(ssd1306_i2c_async_t *as, uint64_t when_ns)
+{
+    uint64_t now = ssd1306_i2c_internal_now_ns();
+    if (now >= when_ns)
+        return;
+    // semaphores wait on the realtime clock
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t until = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec +
+                        (when_ns - now);
+    ts.tv_sec = (time_t)(until / 1000000000ULL);
+    ts.tv_nsec = (long)(until % 1000000000ULL);
+    sem_timedwait(&(as->wakeup), &ts);
+}
+
+// sleeps until when_ns but sends urgent regions that come in meanwhile
+static void ssd1306_i2c_async_sleep_until(ssd1306_i2c_t *oled, uint64_t when_ns)
+{
+    ssd1306_i2c_async_t *as = oled->async;
+    if (!SSD1306_ATOMIC_LOAD(&(as->preempt))) {
+        ssd1306_i2c_internal_sleep_until(when_ns);
+        return;
+    }
+    while (ssd1306_i2c_internal_now_ns() < when_ns) {
+        ssd1306_i2c_async_serve_urgent(oled, &(as->buffers[as->front][1]));
+        ssd1306_i2c_async_timedwait(as, when_ns);
+    }
+}
+
+#ifdef SSD1306_I2C_HAVE_REALTIME
+static void ssd1306_i2c_async_lock_buf(ssd1306_i2c_async_t *as, void *buf, size_t len)
+{
+    if (!buf || len == 0 || as->rt_err != 0)
+        return;
+    as->rt_err = ssd1306_i2c_internal_mlock(buf, len);
+}
+
+static void ssd1306_i2c_async_unlock_buf(void *buf, size_t len)
+{
+    if (buf && len > 0)
+        munlock(buf, len);
+}
+
+// every buffer the worker touches on a frame
+static void ssd1306_i2c_async_lock_bufs(ssd1306_i2c_t *oled, bool lock)
+{
+    ssd1306_i2c_async_t *as = oled->async;
+    const size_t len = oled->gddram_buffer_len;
+    void *bufs[] = { oled, as, oled->lock, oled->gddram_buffer,
+                     oled->shadow_buffer ? oled->shadow_buffer - 1 : NULL,
+                     oled->xfer_buffer, oled->chunk_buffer, as->buffers[0],
+                     as->buffers[1], as->buffers[2], as->urgent_buf };
+    const size_t lens[] = { sizeof(*oled), sizeof(*as), sizeof(*oled->lock), len, len,
+                            len + 8, oled->chunk_buffer_len, len, len, len, len - 1 };
+    for (size_t idx = 0; idx < sizeof(bufs) / sizeof(bufs[0]); ++idx) {
+        if (lock)
+            ssd1306_i2c_async_lock_buf(as, bufs[idx], lens[idx]);
+        else
+            ssd1306_i2c_async_unlock_buf(bufs[idx], lens[idx]);
+    }
+    for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX; ++idx) {
+        if (lock)
+            ssd1306_i2c_async_lock_buf(as, as->urgent[idx].frame, len - 1);
+        else
+            ssd1306_i2c_async_unlock_buf(as->urgent[idx].frame, len - 1);
+    }
+}
+
+// faults in and locks the stack the worker will use
+static void ssd1306_i2c_async_lock_stack(ssd1306_i2c_async_t *as)
+{
+    uint8_t stack[SSD1306_I2C_RT_STACK_PREFAULT];
+    ssd1306_i2c_async_lock_buf(as, stack, sizeof(stack));
+}
+
+// applies the realtime settings to the calling thread, the worker
+static void ssd1306_i2c_async_apply_realtime(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_realtime_t *rt)
+{
+    ssd1306_i2c_async_t *as = oled->async;
+    if (rt->cpus != 0) {
+        // the raw syscall works without _GNU_SOURCE and cpu_set_t
+        unsigned long mask[64 / (8 * sizeof(unsigned long))] = { 0 };
+        for (size_t cpu = 0; cpu < 64; ++cpu) {
+            if (rt->cpus & (1ULL << cpu))
+                mask[cpu / (8 * sizeof(unsigned long))] |= 1UL << (cpu % (8 * sizeof(unsigned long)));
+        }
+        if (syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) < 0) {
+            as->rt_err = errno;
+            return;
+        }
+    }
+    struct sched_param sp;
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = rt->priority;
+    int rc = pthread_setschedparam(pthread_self(), rt->policy, &sp);
+    if (rc != 0) {
+        as->rt_err = rc;
+        return;
+    }
+    if (rt->lock_memory) {
+        ssd1306_i2c_async_lock_stack(as);
+        pthread_mutex_lock(as->lock);
+        ssd1306_i2c_async_lock_bufs(oled, true);
+        as->locked = true;
+        pthread_mutex_unlock(as->lock);
+    }
+}
+#endif
+
+// records how long after its slot or presentation the frame went out
+static void ssd1306_i2c_async_wakeup(ssd1306_i2c_async_t *as, uint64_t ref, uint64_t now,
+        ssd1306_i2c_present_info_t *info)
+{
+    if (ref == 0 || now < ref)
+        return;
+    uint64_t wake = now - ref;
+    uint64_t dev = (wake > as->wake_ns) ? wake - as->wake_ns : as->wake_ns - wake;
+    info->wake_ns = wake;
+    as->wake_ns = as->wake_ns ? (7 * as->wake_ns + wake) / 8 : wake;
+    as->jitter_ns = (7 * as->jitter_ns + dev) / 8;
+    SSD1306_ATOMIC_SET(&(as->stats.wake_ns), as->wake_ns);
+    SSD1306_ATOMIC_SET(&(as->stats.jitter_ns), as->jitter_ns);
+    if (wake > SSD1306_ATOMIC_LOAD(&(as->stats.wake_max_ns)))
+        SSD1306_ATOMIC_SET(&(as->stats.wake_max_ns), wake);
+}
+
+static void *ssd1306_i2c_async_worker(void *arg)
+{
+    ssd1306_i2c_t *oled = (ssd1306_i2c_t *)arg;
+    ssd1306_i2c_async_t *as = oled->async;
+    if (as->rt) {
+        // keep stdio off the realtime path. errors only reach the log
+        // callback, and the stats and completions
+        ssd1306_err_set_thread_quiet(true);
+#ifdef SSD1306_I2C_HAVE_REALTIME
+        ssd1306_i2c_async_apply_realtime(oled, as->rt);
+#else
+        as->rt_err = ENOSYS;
+#endif
+        as->rt = NULL;
+        sem_post(&(as->started));
+        if (as->rt_err != 0)
+            return NULL;
+    }
+    for (;;) {
+        uint32_t p = SSD1306_ATOMIC_LOAD(&(as->pending));
+        const bool stopping = SSD1306_ATOMIC_LOAD(&(as->stop)) ? true : false;
+        if (!(p & SSD1306_I2C_ASYNC_NEW) && !as->resend) {
+            if (SSD1306_ATOMIC_LOAD(&(as->nurgent)) > 0) {
+                ssd1306_i2c_async_serve_urgent(oled, &(as->buffers[as->front][1]));
+                continue;
+            }
+            if (stopping)
+                break;
+            // effect steps are sent while idle, and with the frames otherwise
+            uint64_t now = 0, next = 0;
+            ssd1306_i2c_internal_fx_run(oled, &now, &next);
+            if (next > 0)
+                ssd1306_i2c_async_timedwait(as, next);
+            else
+                while (sem_wait(&(as->wakeup)) < 0 && errno == EINTR);
+            continue;
+        }
+        pthread_mutex_lock(as->lock);
+        ssd1306_i2c_pacing_t pacing = as->pacing;
+        uint64_t period = as->period_ns;
+        pthread_mutex_unlock(as->lock);
+        ssd1306_i2c_present_info_t info = { 0 };
+        size_t budget = 0;
+        // the last frame is sent right away when stopping
+        if (period > 0 && !stopping) {
+            uint64_t now = ssd1306_i2c_internal_now_ns();
+            if (as->next_slot < now)
+                as->next_slot = now; // idle, no need to catch up
+            info.target_ns = as->next_slot;
+            ssd1306_i2c_async_sleep_until(oled, info.target_ns);
+            now = ssd1306_i2c_internal_now_ns();
+            uint64_t deadline = info.target_ns + (pacing.deadline_ns ? pacing.deadline_ns : period);
+            info.late = (now + as->bus_ns > deadline);
+            if (info.late) {
+                as->next_slot = info.target_ns + period;
+                // never skip two slots in a row, or a bus that is always
+                // slower than the deadline would not get any frame out
+                if (pacing.policy == SSD1306_I2C_PACE_DROP && !as->deferred &&
+                    (p & SSD1306_I2C_ASYNC_NEW)) {
+                    p = SSD1306_ATOMIC_EXCHANGE(&(as->pending), as->front);
+                    as->front = p & SSD1306_I2C_ASYNC_IDX_MASK;
+                    SSD1306_ATOMIC_INCREMENT(&(as->stats.dropped));
+                    SSD1306_ATOMIC_INCREMENT(&(as->stats.late));
+                    as->deferred = true;
+                    info.frame = ++(as->frame);
+                    info.seq = as->seqs[as->front];
+                    info.dropped = true;
+                    ssd1306_i2c_async_complete(oled, &info, &pacing);
+                    continue;
+                }
+                if (pacing.policy == SSD1306_I2C_PACE_MERGE && !as->deferred) {
+                    // leave it pending for the next slot, a newer frame replaces it
+                    as->deferred = true;
+                    continue;
+                }
+                SSD1306_ATOMIC_INCREMENT(&(as->stats.late));
+                if (pacing.policy == SSD1306_I2C_PACE_DEGRADE) {
+                    uint64_t left = (deadline > now) ? deadline - now : 0;
+                    budget = (size_t)(left / (as->byte_ns ? as->byte_ns : 1));
+                    if (budget == 0)
+                        budget = 1; // at least one rectangle
+                }
+            }
+        }
+        if (p & SSD1306_I2C_ASYNC_NEW) {
+            // take the newest frame and leave our old buffer in its place
+            p = SSD1306_ATOMIC_EXCHANGE(&(as->pending), as->front);
+            as->front = p & SSD1306_I2C_ASYNC_IDX_MASK;
+        }
+        as->deferred = false;
+        uint8_t *xfer = as->buffers[as->front];
+        uint64_t t0 = ssd1306_i2c_internal_now_ns();
+        // the rest of a degraded frame is not woken up for
+        if (!as->resend)
+            ssd1306_i2c_async_wakeup(as, info.target_ns ? info.target_ns :
+                    as->presented[as->front], t0, &info);
+        as->resend = false;
+        pthread_mutex_lock(as->lock);
+        uint64_t b0 = oled->tx_bytes;
+        int rc = 1;
+        if (budget > 0 && oled->shadow_buffer && oled->shadow_valid) {
+            rc = ssd1306_i2c_internal_update_partial(oled, &xfer[1], budget);
+            if (rc == 2) {
+                info.partial = true;
+                as->resend = true;
+                rc = 0;
+            }
+        }
+        if (rc == 1 && SSD1306_ATOMIC_LOAD(&(as->preempt))) {
+            // the lock is taken per page so urgent regions and other
+            // callers can get in between
+            pthread_mutex_unlock(as->lock);
+            rc = ssd1306_i2c_async_send_pages(oled, &xfer[1]);
+            pthread_mutex_lock(as->lock);
+        }
+        if (rc == 1)
+            rc = ssd1306_i2c_internal_display_update(oled, &xfer[1], xfer);
+        info.bus_bytes = oled->tx_bytes - b0;
+        pthread_mutex_unlock(as->lock);
+        info.present_ns = ssd1306_i2c_internal_now_ns();
+        info.bus_ns = info.present_ns - t0;
+        info.frame = ++(as->frame);
+        info.seq = as->seqs[as->front];
+        if (rc < 0) {
+            info.failed = true;
+            SSD1306_ATOMIC_INCREMENT(&(as->stats.errors));
+        } else {
+            SSD1306_ATOMIC_INCREMENT(&(as->stats.flushed));
+            if (info.bus_bytes > 0) {
+                // moving averages over about 8 frames
+                uint64_t per_byte = info.bus_ns / info.bus_bytes;
+                as->byte_ns = as->byte_ns ? (7 * as->byte_ns + per_byte) / 8 : per_byte;
+                if (!info.partial) {
+                    as->bus_ns = as->bus_ns ? (7 * as->bus_ns + info.bus_ns) / 8 : info.bus_ns;
+                    SSD1306_ATOMIC_SET(&(as->stats.bus_ns), as->bus_ns);
+                }
+            }
+        }
+        if (period > 0 && !info.late)
+            as->next_slot = info.target_ns + period;
+        ssd1306_i2c_async_complete(oled, &info, &pacing);
+    }
+    return NULL;
+}
+#endif
+
+static int ssd1306_i2c_internal_async_start(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_realtime_t *rt)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport || !oled->gddram_buffer || oled->gddram_buffer_len == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    if (oled->async)
+        return 0; // already running
+    if (!oled->lock) {
+        SSD1306_LOG_ERROR(err, "No lock for ssd1306 I2C object");
+        return -1;
+    }
+    ssd1306_i2c_async_t *as = calloc(1, sizeof(*as));
+    if (!as) {
+        SSD1306_LOG_ERROR(err, "Failed to allocate memory of size %zu bytes", sizeof(*as));
+        return -1;
+    }
+    for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_NBUFS; ++idx) {
+        as->buffers[idx] = calloc(sizeof(uint8_t), oled->gddram_buffer_len);
+        if (!as->buffers[idx]) {
+            SSD1306_LOG_ERROR(err, "Out of memory allocating %zu bytes for frame buffer",
+                    oled->gddram_buffer_len);
+            for (size_t jdx = 0; jdx < idx; ++jdx)
+                free(as->buffers[jdx]);
+            free(as);
+            return -1;
+        }
+        as->buffers[idx][0] = 0x40; // Co: 0 D/C#: 1 0b01000000
+    }
+    as->front = 0;
+    as->pending = 1;
+    as->back = 2;
+    as->efd = -1;
+    pthread_mutex_init(&(as->done_lock), NULL);
+    pthread_mutex_init(&(as->urgent_lock), NULL);
+    as->lock = &(oled->lock->mutex);
+    sem_init(&(as->wakeup), 0, 0);
+    sem_init(&(as->started), 0, 0);
+    as->rt = rt;
+    as->realtime = (rt != NULL);
+    oled->async = as;
+    int rc = pthread_create(&(as->thread), NULL, ssd1306_i2c_async_worker, oled);
+    if (rc == 0 && rt) {
+        // wait for the worker to apply the settings
+        while (sem_wait(&(as->started)) < 0 && errno == EINTR);
+        if (as->rt_err != 0) {
+            pthread_join(as->thread, NULL);
+            rc = as->rt_err;
+#ifdef SSD1306_I2C_HAVE_REALTIME
+            if (as->locked)
+                ssd1306_i2c_async_lock_bufs(oled, false);
+#endif
+        }
+    }
+    if (rc != 0) {
+        oled->err->errnum = rc;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        SSD1306_LOG_ERROR(err, "Failed to %s flush thread: %s",
+                (as->rt_err != 0) ? "apply realtime settings to" : "create",
+                oled->err->errbuf);
+        oled->async = NULL;
+        sem_destroy(&(as->wakeup));
+        sem_destroy(&(as->started));
+        pthread_mutex_destroy(&(as->done_lock));
+        pthread_mutex_destroy(&(as->urgent_lock));
+        for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_NBUFS; ++idx)
+            free(as->buffers[idx]);
+        free(as);
+        return -1;
+    }
+    SSD1306_LOG_INFO(err, "Started %sflush thread for device fd %d", rt ? "realtime " : "",
+            oled->fd);
+    return 0;
+#else
+    (void)rt;
+    SSD1306_LOG_ERROR(err, "Library built without threading support");
+    return -1;
+#endif
+}
+
+int ssd1306_i2c_async_start(ssd1306_i2c_t *oled)
+{
+    return ssd1306_i2c_internal_async_start(oled, NULL);
+}
+
+int ssd1306_i2c_async_start_realtime(ssd1306_i2c_t *oled, const ssd1306_i2c_realtime_t *rt)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!rt) {
+        SSD1306_LOG_ERROR(err, "Invalid realtime settings");
+        return -1;
+    }
+    if (oled && oled->async) {
+        SSD1306_LOG_ERROR(err, "Flush thread already started. Stop it first");
+        return -1;
+    }
+    if (oled && oled->capture) {
+        SSD1306_LOG_ERROR(err, "Cannot start a realtime flush thread while capturing");
+        return -1;
+    }
+    return ssd1306_i2c_internal_async_start(oled, rt);
+}
+
+int ssd1306_i2c_async_present(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->async) {
+        SSD1306_LOG_ERROR(err, "Flush thread not started for ssd1306 I2C object");
+        return -1;
+    }
+    if (!fbp || !(fbp->buffer) || fbp->len == 0 || (fbp->len != (oled->gddram_buffer_len - 1))) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 framebuffer object");
+        return -1;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    ssd1306_i2c_async_t *as = oled->async;
+    memcpy(&(as->buffers[as->back][1]), fbp->buffer, fbp->len);
+    as->seqs[as->back] = SSD1306_ATOMIC_INCREMENT(&(as->stats.submitted));
+    as->presented[as->back] = ssd1306_i2c_internal_now_ns();
+    // publish the frame and take back whatever was pending. if the worker
+    // has not picked it up yet, that older frame is dropped.
+    uint32_t p = SSD1306_ATOMIC_EXCHANGE(&(as->pending), as->back | SSD1306_I2C_ASYNC_NEW);
+    as->back = p & SSD1306_I2C_ASYNC_IDX_MASK;
+    if (p & SSD1306_I2C_ASYNC_NEW) {
+        SSD1306_ATOMIC_INCREMENT(&(as->stats.dropped));
+        ssd1306_i2c_present_info_t info = { 0 };
+        info.seq = as->seqs[as->back];
+        info.dropped = true;
+        ssd1306_i2c_async_complete(oled, &info, NULL);
+    }
+    sem_post(&(as->wakeup));
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int ssd1306_i2c_async_set_preemptible(ssd1306_i2c_t *oled, bool enable)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->async) {
+        SSD1306_LOG_ERROR(err, "Flush thread not started for ssd1306 I2C object");
+        return -1;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    ssd1306_i2c_async_t *as = oled->async;
+    if (enable) {
+        // pages are staged in the shadow mode buffers
+        pthread_mutex_lock(as->lock);
+        int rc = -1;
+        if (oled->flip_enabled)
+            SSD1306_LOG_ERROR(err, "Cannot send frames a page at a time while flipping pages");
+        else
+            rc = ssd1306_i2c_shadow_enable(oled, true);
+        pthread_mutex_unlock(as->lock);
+        if (rc < 0)
+            return -1;
+    }
+    SSD1306_ATOMIC_SET(&(as->preempt), enable ? 1 : 0);
+    SSD1306_LOG_INFO(err, "Flush thread sends frames %s", enable ? "a page at a time" : "whole");
+    return 0;
+#else
+    (void)enable;
+    return -1;
+#endif
+}
+
+int ssd1306_i2c_async_present_region(ssd1306_i2c_t *oled, const ssd1306_framebuffer_t *fbp,
+        uint8_t x, uint8_t y, uint8_t w, uint8_t h, uint8_t priority)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->async) {
+        SSD1306_LOG_ERROR(err, "Flush thread not started for ssd1306 I2C object");
+        return -1;
+    }
+    if (!fbp || !(fbp->buffer) || fbp->len == 0 || (fbp->len != (oled->gddram_buffer_len - 1))) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 framebuffer object");
+        return -1;
+    }
+    if (w == 0 || h == 0 || x >= oled->width || y >= oled->height) {
+        SSD1306_LOG_ERROR(err, "Region %ux%u at (%u, %u) is outside the display", w, h, x, y);
+        return -1;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    ssd1306_i2c_async_t *as = oled->async;
+    const size_t width = oled->width;
+    size_t x1 = (size_t)x + w - 1;
+    size_t y1 = (size_t)y + h - 1;
+    ssd1306_i2c_rect_t r = {
+        y / 8,
+        (uint8_t)(((y1 < oled->height) ? y1 : (size_t)oled->height - 1) / 8),
+        x,
+        (uint8_t)((x1 < width) ? x1 : width - 1)
+    };
+    if (!SSD1306_ATOMIC_LOAD(&(as->preempt)) &&
+        ssd1306_i2c_async_set_preemptible(oled, true) < 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&(as->urgent_lock));
+    if (!as->urgent_buf) {
+        as->urgent_buf = calloc(sizeof(uint8_t), fbp->len);
+        for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX && as->urgent_buf; ++idx) {
+            as->urgent[idx].frame = calloc(sizeof(uint8_t), fbp->len);
+            if (!as->urgent[idx].frame) {
+                for (size_t jdx = 0; jdx < idx; ++jdx) {
+                    free(as->urgent[jdx].frame);
+                    as->urgent[jdx].frame = NULL;
+                }
+                free(as->urgent_buf);
+                as->urgent_buf = NULL;
+            }
+        }
+        if (!as->urgent_buf) {
+            pthread_mutex_unlock(&(as->urgent_lock));
+            SSD1306_LOG_ERROR(err, "Out of memory allocating urgent region buffers");
+            return -1;
+        }
+        ssd1306_i2c_internal_rt_lock(oled, as->urgent_buf, fbp->len, true);
+        for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX; ++idx)
+            ssd1306_i2c_internal_rt_lock(oled, as->urgent[idx].frame, fbp->len, true);
+    }
+    // a region that is still queued is replaced, so a blinking cursor does
+    // not fill the queue
+    ssd1306_i2c_urgent_t *u = NULL;
+    for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX && !u; ++idx) {
+        if (as->urgent[idx].used && memcmp(&(as->urgent[idx].rect), &r, sizeof(r)) == 0)
+            u = &(as->urgent[idx]);
+    }
+    for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX && !u; ++idx) {
+        if (!as->urgent[idx].used) {
+            u = &(as->urgent[idx]);
+            u->used = true;
+            u->rect = r;
+            u->order = as->urgent_order++;
+            SSD1306_ATOMIC_INCREMENT(&(as->nurgent));
+        }
+    }
+    if (!u) {
+        pthread_mutex_unlock(&(as->urgent_lock));
+        SSD1306_LOG_ERROR(err, "Urgent region queue is full");
+        return -1;
+    }
+    u->priority = priority;
+    for (size_t pg = r.page_start; pg <= r.page_end; ++pg) {
+        size_t off = pg * width + r.col_start;
+        memcpy(&(u->frame[off]), &(fbp->buffer[off]), r.col_end - r.col_start + 1);
+    }
+    pthread_mutex_unlock(&(as->urgent_lock));
+    sem_post(&(as->wakeup));
+    return 0;
+#else
+    (void)priority;
+    return -1;
+#endif
+}
+
+int ssd1306_i2c_async_get_stats(const ssd1306_i2c_t *oled, ssd1306_i2c_async_stats_t *stats)
+{
+    if (!oled || !oled->async || !stats)
+        return -1;
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    const ssd1306_i2c_async_t *as = oled->async;
+    stats->submitted = SSD1306_ATOMIC_LOAD(&(as->stats.submitted));
+    stats->flushed = SSD1306_ATOMIC_LOAD(&(as->stats.flushed));
+    stats->dropped = SSD1306_ATOMIC_LOAD(&(as->stats.dropped));
+    stats->errors = SSD1306_ATOMIC_LOAD(&(as->stats.errors));
+    stats->late = SSD1306_ATOMIC_LOAD(&(as->stats.late));
+    stats->bus_ns = SSD1306_ATOMIC_LOAD(&(as->stats.bus_ns));
+    stats->lost = SSD1306_ATOMIC_LOAD(&(as->stats.lost));
+    stats->urgent = SSD1306_ATOMIC_LOAD(&(as->stats.urgent));
+    stats->wake_ns = SSD1306_ATOMIC_LOAD(&(as->stats.wake_ns));
+    stats->wake_max_ns = SSD1306_ATOMIC_LOAD(&(as->stats.wake_max_ns));
+    stats->jitter_ns = SSD1306_ATOMIC_LOAD(&(as->stats.jitter_ns));
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+int ssd1306_i2c_async_set_pacing(ssd1306_i2c_t *oled, const ssd1306_i2c_pacing_t *pacing)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->async) {
+        SSD1306_LOG_ERROR(err, "Flush thread not started for ssd1306 I2C object");
+        return -1;
+    }
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    ssd1306_i2c_async_t *as = oled->async;
+    pthread_mutex_lock(as->lock);
+    // degraded frames are diffed against the shadow
+    if (pacing && pacing->policy == SSD1306_I2C_PACE_DEGRADE && pacing->fps > 0 &&
+        ssd1306_i2c_shadow_enable(oled, true) < 0) {
+        pthread_mutex_unlock(as->lock);
+        return -1;
+    }
+    if (pacing) {
+        as->pacing = *pacing;
+        as->period_ns = (pacing->fps > 0) ? 1000000000ULL / pacing->fps : 0;
+    } else {
+        memset(&(as->pacing), 0, sizeof(as->pacing));
+        as->period_ns = 0;
+    }
+    pthread_mutex_unlock(as->lock);
+    SSD1306_LOG_INFO(err, "Flush thread pacing set to %u fps", pacing ? pacing->fps : 0);
+    return 0;
+#else
+    (void)pacing;
+    return -1;
+#endif
+}
+
+int ssd1306_i2c_async_eventfd(ssd1306_i2c_t *oled)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->async) {
+        SSD1306_LOG_ERROR(err, "Flush thread not started for ssd1306 I2C object");
+        return -1;
+    }
+#if defined(LIBSSD1306_HAVE_PTHREAD) && defined(LIBSSD1306_HAVE_SYS_EVENTFD_H)
+    ssd1306_i2c_async_t *as = oled->async;
+    pthread_mutex_lock(&(as->done_lock));
+    if (as->efd < 0) {
+        as->efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (as->efd < 0) {
+            oled->err->errnum = errno;
+            strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+            SSD1306_LOG_ERROR(err, "Failed to create eventfd: %s", oled->err->errbuf);
+        } else {
+            SSD1306_LOG_INFO(err, "Flush thread completions on eventfd %d", as->efd);
+        }
+    }
+    int efd = as->efd;
+    pthread_mutex_unlock(&(as->done_lock));
+    return efd;
+#else
+    SSD1306_LOG_ERROR(err, "Library built without eventfd support");
+    return -1;
+#endif
+}
+
+size_t ssd1306_i2c_async_drain(ssd1306_i2c_t *oled, ssd1306_i2c_present_info_t *infos,
+        size_t max)
+{
+    if (!oled || !oled->async || !infos || max == 0)
+        return 0;
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    ssd1306_i2c_async_t *as = oled->async;
+    size_t count = 0;
+    pthread_mutex_lock(&(as->done_lock));
+    if (as->efd >= 0) {
+        uint64_t val = 0;
+        if (read(as->efd, &val, sizeof(val)) < 0) {
+            // EAGAIN, nothing was signalled
+        }
+        for (; count < max && as->done_count > 0; ++count) {
+            infos[count] = as->done[as->done_first];
+            as->done_first = (as->done_first + 1) % SSD1306_I2C_ASYNC_COMPLETIONS;
+            as->done_count--;
+        }
+        if (as->done_count > 0) {
+            // keep the fd readable for the rest
+            val = 1;
+            if (write(as->efd, &val, sizeof(val)) < 0) {
+                // cannot overflow, it was just reset
+            }
+        }
+    }
+    pthread_mutex_unlock(&(as->done_lock));
+    return count;
+#else
+    return 0;
+#endif
+}
+
+void ssd1306_i2c_async_stop(ssd1306_i2c_t *oled)
+{
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    if (oled && oled->async) {
+        ssd1306_i2c_async_t *as = oled->async;
+        // the worker flushes the last pending frame before exiting
+        SSD1306_ATOMIC_SET(&(as->stop), 1);
+        sem_post(&(as->wakeup));
+        pthread_join(as->thread, NULL);
+#ifdef SSD1306_I2C_HAVE_REALTIME
+        if (as->locked)
+            ssd1306_i2c_async_lock_bufs(oled, false);
+#endif
+        oled->async = NULL;
+        if (as->efd >= 0)
+            close(as->efd);
+        sem_destroy(&(as->wakeup));
+        sem_destroy(&(as->started));
+        pthread_mutex_destroy(&(as->done_lock));
+        pthread_mutex_destroy(&(as->urgent_lock));
+        for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_NBUFS; ++idx)
+            free(as->buffers[idx]);
+        for (size_t idx = 0; idx < SSD1306_I2C_ASYNC_URGENT_MAX; ++idx)
+            free(as->urgent[idx].frame);
+        free(as->urgent_buf);
+        memset(as, 0, sizeof(*as));
+        free(as);
+    }
+#else
+    (void)oled;
+#endif
+}
+
+
+// returns the effects state, creating it on first use
+static ssd1306_i2c_fx_t *ssd1306_i2c_internal_fx_get(ssd1306_i2c_t *oled)
+{
+    if (!oled->fx) {
+        oled->fx = calloc(1, sizeof(*oled->fx));
+        if (!oled->fx) {
+            SSD1306_LOG_ERROR(oled->err, "Out of memory allocating %zu bytes for effects",
+                    sizeof(*oled->fx));
+            return NULL;
+        }
+        ssd1306_i2c_internal_fx_forget(oled->fx);
+    }
+    return oled->fx;
+}
+
+// sends the first step right away and lets the flush thread know
+static int ssd1306_i2c_internal_fx_started(ssd1306_i2c_t *oled)
+{
+    int rc = ssd1306_i2c_fx_run(oled, NULL);
+#ifdef LIBSSD1306_HAVE_PTHREAD
+    if (oled->async)
+        sem_post(&(oled->async->wakeup));
+#endif
+    return (rc < 0) ? -1 : 0;
+}
+
+int ssd1306_i2c_fx_fade(ssd1306_i2c_t *oled, uint8_t from, uint8_t to, uint32_t duration_ms,
+        ssd1306_i2c_fx_curve_t curve)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    ssd1306_i2c_fx_t *fx = ssd1306_i2c_internal_fx_get(oled);
+    if (fx) {
+        fx->fading = true;
+        fx->from = from;
+        fx->to = to;
+        fx->curve = curve;
+        fx->fade_start_ns = ssd1306_i2c_internal_now_ns();
+        fx->fade_ns = (duration_ms > 0) ? (uint64_t)duration_ms * 1000000ULL : 1;
+        fx->next_ns = fx->fade_start_ns;
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    return fx ? ssd1306_i2c_internal_fx_started(oled) : -1;
+}
+
+int ssd1306_i2c_fx_blink(ssd1306_i2c_t *oled, ssd1306_i2c_fx_target_t target,
+        uint32_t pattern, uint8_t nbits, uint32_t step_ms, unsigned int repeat)
+{
+    ssd1306_err_t *err = SSD1306_I2C_GET_ERR(oled);
+    if (!oled || !oled->transport) {
+        SSD1306_LOG_ERROR(err, "Invalid ssd1306 I2C object");
+        return -1;
+    }
+    if ((target != SSD1306_I2C_FX_INVERT && target != SSD1306_I2C_FX_ENTIRE_ON) ||
+        nbits == 0 || nbits > 32 || step_ms == 0) {
+        SSD1306_LOG_ERROR(err, "Invalid blink pattern of %u bits of %u ms", nbits, step_ms);
+        return -1;
+    }
+    SSD1306_I2C_LOCK(oled);
+    ssd1306_i2c_fx_t *fx = ssd1306_i2c_internal_fx_get(oled);
+    if (fx) {
+        ssd1306_i2c_fx_blink_t *b = &(fx->blink[target]);
+        b->active = true;
+        b->pattern = pattern;
+        b->nbits = nbits;
+        b->repeat = repeat;
+        b->step_ns = (uint64_t)step_ms * 1000000ULL;
+        b->start_ns = ssd1306_i2c_internal_now_ns();
+        fx->next_ns = b->start_ns;
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    return fx ? ssd1306_i2c_internal_fx_started(oled) : -1;
+}
+
+int ssd1306_i2c_fx_flash(ssd1306_i2c_t *oled, unsigned int count, uint32_t on_ms)
+{
+    // on for a step, off for a step
+    return ssd1306_i2c_fx_blink(oled, SSD1306_I2C_FX_ENTIRE_ON, 0x1, 2, on_ms, count);
+}
+
+int ssd1306_i2c_fx_run(ssd1306_i2c_t *oled, uint32_t *next_ms)
+{
+    if (!oled || !oled->transport)
+        return -1;
+    uint64_t now = 0, next = 0;
+    int rc = ssd1306_i2c_internal_fx_run(oled, &now, &next);
+    if (next_ms) {
+        // rounded up so a timer does not fire just before the step is due
+        *next_ms = (next == 0) ? UINT32_MAX :
+                    (next <= now) ? 0 : (uint32_t)((next - now + 999999) / 1000000);
+    }
+    if (rc < 0)
+        return -1;
+    return (next > 0) ? 1 : 0;
+}
+
+int ssd1306_i2c_fx_stop(ssd1306_i2c_t *oled)
+{
+    if (!oled || !oled->transport)
+        return -1;
+    int rc = 0;
+    SSD1306_I2C_LOCK(oled);
+    ssd1306_i2c_fx_t *fx = oled->fx;
+    if (fx) {
+        // the display goes back to normal, the contrast stays where it is
+        uint8_t cmds[3] = { 0x00, 0xA6, 0xA4 }; // Co: 0 D/C#: 0, normal, entire off
+        fx->fading = false;
+        fx->blink[0].active = fx->blink[1].active = false;
+        fx->next_ns = 0;
+        if (fx->state[0] != 0 || fx->state[1] != 0) {
+            rc = ssd1306_i2c_internal_write_cmds(oled, cmds, sizeof(cmds));
+            fx->state[0] = fx->state[1] = (rc < 0) ? -1 : 0;
+        }
+    }
+    SSD1306_I2C_UNLOCK(oled);
+    return rc;
+}
+
+int ssd1306_i2c_fx_get_stats(const ssd1306_i2c_t *oled, ssd1306_i2c_fx_stats_t *stats)
+{
+    if (!oled || !stats)
+        return -1;
+    SSD1306_I2C_LOCK(oled);
+    if (oled->fx)
+        *stats = oled->fx->stats;
+    else
+        memset(stats, 0, sizeof(*stats));
+    SSD1306_I2C_UNLOCK(oled);
+    return 0;
 }
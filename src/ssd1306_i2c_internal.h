@@ -0,0 +1,247 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#ifndef __LIB_SSD1306_I2C_INTERNAL_H__
+#define __LIB_SSD1306_I2C_INTERNAL_H__
+
+// shared by the library's source files. not installed
+#include <ssd1306_config.h>
+#ifdef LIBSSD1306_HAVE_FEATURES_H
+#include <features.h>
+#endif
+#ifdef LIBSSD1306_HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef LIBSSD1306_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef LIBSSD1306_HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef LIBSSD1306_HAVE_SYS_IOCTL_H
+#include <sys/ioctl.h>
+#endif
+#ifdef LIBSSD1306_HAVE_STDIO_H
+#include <stdio.h>
+#endif
+#ifdef LIBSSD1306_HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef LIBSSD1306_HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
+#ifdef LIBSSD1306_HAVE_DIRENT_H
+#include <dirent.h>
+#endif
+#include <time.h>
+
+#if LIBSSD1306_HAVE_LINUX_I2C_DEV_H
+#include <linux/i2c-dev.h>
+#else
+#warning "You need to install libi2c-dev and i2c-tools"
+// forcibly defining the ioctl number
+#undef I2C_SLAVE
+#define I2C_SLAVE 0x0703
+#undef I2C_FUNCS
+#define I2C_FUNCS 0x0705
+#undef I2C_SMBUS
+#undef I2C_SMBUS
+#define I2C_SMBUS 0x0720
+#endif
+#if LIBSSD1306_HAVE_I2C_SMBUS_H
+#include <i2c/smbus.h>
+#endif
+#if LIBSSD1306_HAVE_LINUX_I2C_H
+#include <linux/i2c.h>
+#endif
+#if defined(I2C_RDWR) && defined(I2C_FUNC_I2C) && defined(I2C_RDWR_IOCTL_MAX_MSGS)
+#define SSD1306_I2C_HAVE_RDWR 1
+#endif
+#if defined(I2C_FUNC_SMBUS_WRITE_I2C_BLOCK) && defined(I2C_SMBUS_I2C_BLOCK_DATA)
+#define SSD1306_I2C_HAVE_SMBUS_BLOCK 1
+#endif
+#if LIBSSD1306_HAVE_I2C_SMBUS_H || (defined(I2C_FUNC_SMBUS_QUICK) && defined(I2C_SMBUS_QUICK) && \
+        defined(I2C_FUNC_SMBUS_READ_BYTE) && defined(I2C_SMBUS_BYTE))
+#define SSD1306_I2C_HAVE_SMBUS_PROBE 1
+#endif
+#include <ssd1306_i2c.h>
+
+#if LIBSSD1306_HAVE_DECL_STRERROR_R
+// do nothing
+#else
+// rewrite it
+#warning "strerror_r is reentrant. strerror is not, so removing usage of strerror_r"
+#define strerror_r(A,B,C) do {} while (0)
+#endif
+
+#ifdef LIBSSD1306_HAVE_PTHREAD
+#include <pthread.h>
+#include <semaphore.h>
+#ifdef LIBSSD1306_HAVE_SCHED_H
+#include <sched.h>
+#endif
+#endif
+#ifdef LIBSSD1306_HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
+#ifdef LIBSSD1306_HAVE_SYS_FILE_H
+#include <sys/file.h>
+#if defined(LOCK_EX) && defined(LOCK_SH) && defined(LOCK_UN)
+#define SSD1306_I2C_HAVE_FLOCK 1
+#endif
+#endif
+#ifdef LIBSSD1306_HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef LIBSSD1306_HAVE_SYS_SYSCALL_H
+#include <sys/syscall.h>
+#endif
+#if LIBSSD1306_HAVE_LINUX_IO_URING_H && LIBSSD1306_HAVE_SYS_MMAN_H && LIBSSD1306_HAVE_SYS_SYSCALL_H
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && \
+        defined(I2C_SLAVE) && defined(I2C_FUNC_I2C)
+#define SSD1306_I2C_HAVE_URING 1
+#endif
+#endif
+#if defined(LIBSSD1306_HAVE_PTHREAD) && LIBSSD1306_HAVE_SYS_MMAN_H && defined(SYS_sched_setaffinity)
+#define SSD1306_I2C_HAVE_REALTIME 1
+#endif
+
+// helpful macros
+#ifndef SSD1306_I2C_GET_ERR
+#define SSD1306_I2C_GET_ERR(P) (((P) != NULL) ? (P)->err : NULL)
+#endif // SSD1306_I2C_GET_ERR
+
+typedef struct {
+    uint8_t page_start;
+    uint8_t page_end;
+    uint8_t col_start;
+    uint8_t col_end;
+} ssd1306_i2c_rect_t;
+// GDDRAM pages of the controller, whatever the panel height. updates are made
+// of at most one rectangle per page
+#define SSD1306_I2C_RAM_PAGES 8
+
+#ifdef LIBSSD1306_HAVE_PTHREAD
+// urgent region waiting for the flush thread. frame has the layout of a
+// framebuffer and only the rectangle is valid
+typedef struct {
+    ssd1306_i2c_rect_t rect;
+    uint8_t priority;
+    uint64_t order; // arrival order among equal priorities
+    uint8_t *frame;
+    bool used;
+} ssd1306_i2c_urgent_t;
+
+// the flush worker publishes frames through a single atomic word holding the
+// index of the pending buffer and a flag saying whether it is a new frame.
+#define SSD1306_I2C_ASYNC_NBUFS 3
+#define SSD1306_I2C_ASYNC_IDX_MASK 0x3
+#define SSD1306_I2C_ASYNC_NEW 0x4
+struct ssd1306_i2c_async_ {
+    pthread_t thread;
+    pthread_mutex_t *lock; // the device's lock, taken by the worker around bus access
+    sem_t wakeup;
+    uint8_t *buffers[SSD1306_I2C_ASYNC_NBUFS]; // control byte + frame
+    volatile uint32_t pending; // index | SSD1306_I2C_ASYNC_NEW. shared
+    uint32_t back; // owned by the producer
+    uint32_t front; // owned by the worker
+    uint64_t seqs[SSD1306_I2C_ASYNC_NBUFS]; // presentation number of each buffer
+    uint64_t presented[SSD1306_I2C_ASYNC_NBUFS]; // CLOCK_MONOTONIC ns of each presentation
+    volatile int stop;
+    ssd1306_i2c_async_stats_t stats;
+    // frame pacing. the configuration is changed under lock, the rest is
+    // owned by the worker
+    ssd1306_i2c_pacing_t pacing;
+    uint64_t period_ns; // 0 when pacing is off
+    uint64_t next_slot; // CLOCK_MONOTONIC ns of the next frame slot
+    uint64_t bus_ns; // moving average of the bus time per frame
+    uint64_t byte_ns; // moving average of the bus time per byte
+    uint64_t frame; // frames handled by the worker
+    bool resend; // a degraded frame still has changes to send
+    bool deferred; // the previous slot was skipped
+    // completions. a separate lock, since the worker holds the other one
+    // while on the bus
+    pthread_mutex_t done_lock;
+    int efd; // -1 until ssd1306_i2c_async_eventfd() is called
+    ssd1306_i2c_present_info_t done[SSD1306_I2C_ASYNC_COMPLETIONS];
+    size_t done_first;
+    size_t done_count;
+    // urgent regions. once one is presented, frames are sent a page at a
+    // time and the regions are sent in between
+    pthread_mutex_t urgent_lock;
+    ssd1306_i2c_urgent_t urgent[SSD1306_I2C_ASYNC_URGENT_MAX];
+    volatile uint32_t nurgent; // queued regions. shared
+    uint64_t urgent_order;
+    uint8_t *urgent_buf; // owned by the worker, swapped with a queued frame
+    volatile int preempt;
+    // realtime thread. the settings are applied by the worker when it starts
+    const ssd1306_i2c_realtime_t *rt; // only valid until the worker has started
+    bool realtime; // started by ssd1306_i2c_async_start_realtime()
+    sem_t started;
+    int rt_err; // errno of the setting that failed, 0 if all were applied
+    bool locked; // buffers are locked in memory
+    uint64_t wake_ns; // moving averages of the wakeup latency and its deviation
+    uint64_t jitter_ns;
+};
+// recursive, as public calls that lock also call each other
+struct ssd1306_i2c_lock_ {
+    pthread_mutex_t mutex;
+};
+// the lock exists from open to close, so whether to take it never depends on
+// a flush thread being started or stopped at the same time
+#define SSD1306_I2C_LOCK(P) do { \
+    if ((P)->lock) pthread_mutex_lock(&((P)->lock->mutex)); \
+} while (0)
+#define SSD1306_I2C_UNLOCK(P) do { \
+    if ((P)->lock) pthread_mutex_unlock(&((P)->lock->mutex)); \
+} while (0)
+#else
+#define SSD1306_I2C_LOCK(P) do {} while (0)
+#define SSD1306_I2C_UNLOCK(P) do {} while (0)
+#endif
+
+// functions shared between the library's source files, kept out of the
+// exported symbols
+#if defined(__GNUC__) && __GNUC__ >= 4
+#define SSD1306_I2C_INTERNAL __attribute__((visibility("hidden")))
+#else
+#define SSD1306_I2C_INTERNAL
+#endif
+
+// ssd1306_i2c.c
+SSD1306_I2C_INTERNAL uint32_t ssd1306_i2c_internal_i2cdev_caps(const ssd1306_i2c_t *oled,
+        void *ctx);
+SSD1306_I2C_INTERNAL int ssd1306_i2c_internal_i2cdev_xfer(ssd1306_i2c_t *oled, void *ctx,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs);
+#ifdef SSD1306_I2C_HAVE_RDWR
+SSD1306_I2C_INTERNAL int ssd1306_i2c_internal_rdwr(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs);
+#endif
+SSD1306_I2C_INTERNAL uint64_t ssd1306_i2c_internal_now_ns(void);
+SSD1306_I2C_INTERNAL int ssd1306_i2c_internal_xfer_send(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs);
+SSD1306_I2C_INTERNAL int ssd1306_i2c_internal_xfer(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs);
+SSD1306_I2C_INTERNAL int ssd1306_i2c_internal_write_cmds(ssd1306_i2c_t *oled,
+        const uint8_t *cmd_buf, size_t cmd_sz);
+SSD1306_I2C_INTERNAL size_t ssd1306_i2c_internal_encode_window(ssd1306_err_t *err,
+        uint8_t col_start, uint8_t col_end, uint8_t page_start, uint8_t page_end,
+        uint8_t *cmds, size_t cmds_max);
+SSD1306_I2C_INTERNAL const uint8_t *ssd1306_i2c_internal_fb_xfer(const ssd1306_framebuffer_t *fbp);
+SSD1306_I2C_INTERNAL size_t ssd1306_i2c_internal_append_cmd(ssd1306_err_t *err,
+        ssd1306_i2c_cmd_t cmd, uint8_t *data, size_t dlen, uint8_t *buf, size_t buf_max);
+SSD1306_I2C_INTERNAL size_t ssd1306_i2c_internal_encode_rect(const ssd1306_i2c_t *oled,
+        const ssd1306_i2c_rect_t *r, uint8_t *cmds, size_t cmds_max);
+
+// arbitration.c
+SSD1306_I2C_INTERNAL void ssd1306_i2c_internal_arb_free(ssd1306_i2c_arbiter_t *arb);
+#ifdef SSD1306_I2C_HAVE_FLOCK
+SSD1306_I2C_INTERNAL int ssd1306_i2c_internal_arb_xfer(ssd1306_i2c_t *oled,
+        const ssd1306_i2c_seg_t *segs, size_t nsegs);
+#endif
+
+#endif /* __LIB_SSD1306_I2C_INTERNAL_H__ */
@@ -0,0 +1,108 @@
+/*
+ * COPYRIGHT: 2020. Stealthy Labs LLC.
+ * DATE: 2026-10-16
+ * SOFTWARE: libssd1306-i2c
+ * LICENSE: Refer license file
+ */
+#include <ssd1306_config.h>
+#ifdef LIBSSD1306_HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef LIBSSD1306_HAVE_STRING_H
+#include <string.h>
+#endif
+#include <ssd1306_i2c.h>
+
+#if LIBSSD1306_HAVE_DECL_STRERROR_R
+// do nothing
+#else
+// rewrite it
+#warning "strerror_r is reentrant. strerror is not, so removing usage of strerror_r"
+#define strerror_r(A,B,C) do {} while (0)
+#endif
+
+// in-memory sink. counts every transaction and copies it into the caller's
+// buffer while there is room
+static int ssd1306_i2c_internal_memory_open(ssd1306_i2c_t *oled, void *ctx,
+        const char *dev)
+{
+    (void)dev;
+    if (!ctx) {
+        SSD1306_LOG_ERROR(oled->err, "Memory transport needs a ssd1306_i2c_memsink_t");
+        return -1;
+    }
+    return 0;
+}
+
+static void ssd1306_i2c_internal_memory_store(ssd1306_i2c_memsink_t *sink,
+        const uint8_t *buf, size_t len)
+{
+    sink->bytes += len;
+    if (sink->buf && sink->buf_len < sink->buf_size) {
+        size_t n = sink->buf_size - sink->buf_len;
+        if (n > len)
+            n = len;
+        memcpy(&(sink->buf[sink->buf_len]), buf, n);
+        sink->buf_len += n;
+    }
+}
+
+static int ssd1306_i2c_internal_memory_write_cmds(ssd1306_i2c_t *oled,
+        void *ctx, const uint8_t *buf, size_t len)
+{
+    (void)oled;
+    ssd1306_i2c_memsink_t *sink = ctx;
+    sink->cmd_xfers++;
+    ssd1306_i2c_internal_memory_store(sink, buf, len);
+    return 0;
+}
+
+static int ssd1306_i2c_internal_memory_write_data(ssd1306_i2c_t *oled,
+        void *ctx, const uint8_t *buf, size_t len)
+{
+    (void)oled;
+    ssd1306_i2c_memsink_t *sink = ctx;
+    sink->data_xfers++;
+    ssd1306_i2c_internal_memory_store(sink, buf, len);
+    return 0;
+}
+
+const ssd1306_i2c_transport_t ssd1306_i2c_transport_memory = {
+    .name = "memory",
+    .open = ssd1306_i2c_internal_memory_open,
+    .write_cmds = ssd1306_i2c_internal_memory_write_cmds,
+    .write_data = ssd1306_i2c_internal_memory_write_data
+};
+
+// user callback. every transaction goes to the caller's function as is
+static int ssd1306_i2c_internal_callback_open(ssd1306_i2c_t *oled, void *ctx,
+        const char *dev)
+{
+    (void)dev;
+    const ssd1306_i2c_transport_cb_t *tcb = ctx;
+    if (!tcb || !tcb->cb) {
+        SSD1306_LOG_ERROR(oled->err, "Callback transport needs a ssd1306_i2c_transport_cb_t");
+        return -1;
+    }
+    return 0;
+}
+
+static int ssd1306_i2c_internal_callback_write(ssd1306_i2c_t *oled,
+        void *ctx, const uint8_t *buf, size_t len)
+{
+    const ssd1306_i2c_transport_cb_t *tcb = ctx;
+    errno = 0;
+    if (tcb->cb(oled->addr, buf, len, tcb->cbdata) < 0) {
+        oled->err->errnum = errno ? errno : EIO;
+        strerror_r(oled->err->errnum, oled->err->errbuf, oled->err->errlen);
+        return -1;
+    }
+    return 0;
+}
+
+const ssd1306_i2c_transport_t ssd1306_i2c_transport_callback = {
+    .name = "callback",
+    .open = ssd1306_i2c_internal_callback_open,
+    .write_cmds = ssd1306_i2c_internal_callback_write,
+    .write_data = ssd1306_i2c_internal_callback_write
+};